@@ -0,0 +1,112 @@
+/**
+ * Benchmark: request body parsing for the cart and order routes.
+ * Parses the same bodies with crow::json::load plus the field reads the
+ * routes used to do, and with the schema-specific parsers now used
+ * (server/body_parser.h). Prints ns per body and MB/s for each.
+ *
+ * Build: cmake -DBUILD_BENCHMARKS=ON .. && cmake --build . --target body_parser_bench
+ * Run:   ./body_parser_bench [--iterations 200000] [--items 1,10,100]
+ */
+
+#include "crow/json.h"
+#include "server/body_parser.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::vector<int> parse_list(const std::string& s) {
+    std::vector<int> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) out.push_back(std::atoi(item.c_str()));
+    }
+    return out;
+}
+
+std::string order_body(int items) {
+    std::string body = "{\"user_id\":1042,\"items\":[";
+    for (int i = 0; i < items; i++) {
+        if (i > 0) body += ",";
+        body += "{\"product_id\":" + std::to_string(100 + i * 7) + ",\"quantity\":" + std::to_string(1 + i % 5) + "}";
+    }
+    return body + "]}";
+}
+
+// What the cart routes did before: DOM, then three lookups.
+int64_t crow_cart(const std::string& body) {
+    auto json = crow::json::load(body);
+    if (!json || !json.has("user_id") || !json.has("product_id")) return -1;
+    int64_t quantity = json.has("quantity") ? json["quantity"].i() : 1;
+    return json["user_id"].i() + json["product_id"].i() + quantity;
+}
+
+int64_t schema_cart(const std::string& body) {
+    server::CartPayload p;
+    if (!server::parse_cart_payload(body, p).empty() || !p.user_id || !p.product_id) return -1;
+    return int64_t{*p.user_id} + *p.product_id + p.quantity.value_or(1);
+}
+
+int64_t crow_order(const std::string& body) {
+    auto json = crow::json::load(body);
+    if (!json || !json.has("user_id") || !json.has("items")) return -1;
+    int64_t sum = json["user_id"].i();
+    const auto& items = json["items"];
+    for (size_t i = 0; i < items.size(); i++) sum += items[i]["product_id"].i() + items[i]["quantity"].i();
+    return sum;
+}
+
+int64_t schema_order(const std::string& body) {
+    server::OrderPayload p;
+    if (!server::parse_order_payload(body, p).empty() || !p.user_id) return -1;
+    int64_t sum = *p.user_id;
+    for (const auto& [product_id, quantity] : p.items) sum += product_id + quantity;
+    return sum;
+}
+
+void run(const std::string& label, const std::string& body, int iterations,
+         const std::function<int64_t(const std::string&)>& baseline,
+         const std::function<int64_t(const std::string&)>& schema) {
+    if (baseline(body) != schema(body)) {
+        std::fprintf(stderr, "%s: parsers disagree\n", label.c_str());
+        std::exit(1);
+    }
+    for (const auto& [name, fn] : {std::make_pair("crow::json", baseline), std::make_pair("schema", schema)}) {
+        volatile int64_t sink = 0;
+        auto t0 = Clock::now();
+        for (int i = 0; i < iterations; i++) sink = sink + fn(body);
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / iterations;
+        std::printf("%-14s %7zu %-11s %10.1f %9.1f\n", label.c_str(), body.size(), name, ns,
+                    static_cast<double>(body.size()) * 1000.0 / ns);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iterations = 200000;
+    std::string items_arg = "1,10,100";
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        bool v = i + 1 < argc;
+        if (a == "--iterations" && v) iterations = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--items" && v) items_arg = argv[++i];
+    }
+
+    std::printf("%-14s %7s %-11s %10s %9s\n", "body", "bytes", "parser", "ns/body", "MB/s");
+    run("cart.add", "{\"user_id\":1042,\"product_id\":317,\"quantity\":2}", iterations, crow_cart, schema_cart);
+    for (int items : parse_list(items_arg)) {
+        int n = std::max(1, iterations / std::max(1, items));
+        run("order x" + std::to_string(items), order_body(items), n, crow_order, schema_order);
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+/**
+ * Benchmark: response compression cost and savings on catalog-shaped JSON.
+ * Builds a /api/products body of N rows in the route's exact format, then for
+ * gzip and deflate at several zlib levels prints the compression ratio,
+ * bandwidth saved, throughput and CPU ms per MB of input. It also times the
+ * CompressedCache hit path (hash + compare), which is what a hot catalog
+ * response costs once it has been compressed.
+ *
+ * Build: cmake -DBUILD_BENCHMARKS=ON .. && cmake --build . --target compression_bench
+ * Run:   ./compression_bench [--rows 24,500,5000] [--levels 1,6,9] [--iterations 50]
+ */
+
+#include "server/compression.h"
+#include "utils/json_helper.h"
+#include "utils/response_helper.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::vector<int> parse_list(const std::string& s) {
+    std::vector<int> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) out.push_back(std::atoi(item.c_str()));
+    }
+    return out;
+}
+
+// Same shape as product_routes::product_to_json; text varies like the seed catalog.
+std::string products_body(int rows) {
+    static const char* names[] = {"Classic Denim Jacket", "Slim Fit Chinos", "Wool Blend Coat", "Linen Summer Shirt",
+                                  "Floral Midi Dress", "Cashmere Sweater", "Leather Ankle Boots", "Pleated Skirt"};
+    static const char* cats[] = {"Men", "Women"};
+    std::string data = "[";
+    for (int i = 0; i < rows; i++) {
+        if (i > 0) data += ",";
+        int cat = i % 2;
+        std::string name = std::string(names[i % 8]) + " " + std::to_string(i);
+        data += "{\"id\":" + std::to_string(i + 1) +
+            ",\"category_id\":" + std::to_string(cat + 1) +
+            ",\"name\":" + json_helper::quote(name) +
+            ",\"description\":" + json_helper::quote("Comfortable " + name + " made from premium materials, item " +
+                                                     std::to_string(i * 7919 % 10007) + ".") +
+            ",\"price\":" + json_helper::double_to_str(19.99 + (i * 37 % 200)) +
+            ",\"image_url\":" + json_helper::quote("https://images.example.com/products/" + std::to_string(i + 1) + ".jpg") +
+            ",\"stock\":" + std::to_string(i * 13 % 120) +
+            ",\"category_name\":" + json_helper::quote(cats[cat]) +
+            ",\"created_at\":" + json_helper::quote("2024-01-15 10:" + std::to_string(10 + i % 50) + ":00.123456") + "}";
+    }
+    return response_helper::success_json(data + "]");
+}
+
+double cpu_seconds() {
+    return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string rows_arg = "24,500,5000";
+    std::string levels_arg = "1,6,9";
+    int iterations = 50;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        bool v = i + 1 < argc;
+        if (a == "--rows" && v) rows_arg = argv[++i];
+        else if (a == "--levels" && v) levels_arg = argv[++i];
+        else if (a == "--iterations" && v) iterations = std::max(1, std::atoi(argv[++i]));
+    }
+
+    std::printf("%6s %9s %8s %5s %10s %7s %8s %10s %10s\n", "rows", "bytes", "encoding", "level", "compressed",
+                "saved", "MB/s", "cpu_ms/MB", "hit_us");
+    for (int rows : parse_list(rows_arg)) {
+        std::string body = products_body(rows);
+        double mb = static_cast<double>(body.size()) / (1024.0 * 1024.0);
+        for (server::Encoding e : {server::Encoding::Gzip, server::Encoding::Deflate}) {
+            for (int level : parse_list(levels_arg)) {
+                size_t out_size = 0;
+                double c0 = cpu_seconds();
+                auto t0 = Clock::now();
+                for (int it = 0; it < iterations; it++) out_size = server::compress(body, e, level).size();
+                double wall = std::chrono::duration<double>(Clock::now() - t0).count();
+                double cpu = cpu_seconds() - c0;
+
+                // Hit path: the same body again, already in the cache.
+                server::CompressedCache cache(256 * 1024 * 1024);
+                cache.get(body, e, level);
+                auto h0 = Clock::now();
+                for (int it = 0; it < iterations; it++) cache.get(body, e, level);
+                double hit_us = std::chrono::duration<double, std::micro>(Clock::now() - h0).count() / iterations;
+
+                std::printf("%6d %9zu %8s %5d %10zu %6.1f%% %8.1f %10.2f %10.2f\n", rows, body.size(),
+                            server::encoding_name(e), level, out_size,
+                            100.0 * (1.0 - static_cast<double>(out_size) / static_cast<double>(body.size())),
+                            mb * iterations / wall, cpu * 1000.0 / (mb * iterations), hit_us);
+            }
+        }
+    }
+    return 0;
+}
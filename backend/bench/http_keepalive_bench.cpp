@@ -0,0 +1,360 @@
+/**
+ * Benchmark: many keep-alive connections against one backend (Linux).
+ * For each step it opens idle keep-alive connections up to the step's count
+ * (each sends one request, reads the answer and then sits idle, like a
+ * proxy's spare upstream connections), then drives --active connections with
+ * back-to-back requests for --duration seconds. It prints the server's RSS
+ * (from /proc/<pid>/status), the memory added per idle connection, requests/s
+ * and latency with the idle connections held, and how many of them the server
+ * still keeps open afterwards (http_idle_timeout_s closes the rest).
+ *
+ * Build: cmake -DBUILD_BENCHMARKS=ON .. && cmake --build . --target http_keepalive_bench
+ * Run:   ./http_keepalive_bench --server ./lala_backend --server-args "--config ../config/db_config.json"
+ *            [--idle 0,1000,5000,10000] [--active 64] [--client-threads 2] [--duration 5]
+ *            [--idle-timeout 60] [--path /api/metrics] [--port 18080]
+ *        ./http_keepalive_bench --port 8080 --pid <backend pid>   (no --server: use a running backend)
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Config {
+    std::string server;
+    std::string server_args;
+    pid_t pid = 0;
+    int port = 18080;
+    std::string idle = "0,1000,5000,10000";
+    int active = 64;
+    int client_threads = 2;
+    double duration_s = 5;
+    int idle_timeout_s = 60;
+    std::string path = "/api/metrics";
+};
+
+std::vector<std::string> split(const std::string& s, char sep) {
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, sep)) {
+        if (!item.empty()) out.push_back(item);
+    }
+    return out;
+}
+
+void raise_fd_limit() {
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+}
+
+// Resident set size of `pid` in KiB, 0 if unknown.
+long rss_kb(pid_t pid) {
+    std::ifstream f("/proc/" + std::to_string(pid) + "/status");
+    std::string line;
+    while (std::getline(f, line)) {
+        if (line.rfind("VmRSS:", 0) == 0) return std::strtol(line.c_str() + 6, nullptr, 10);
+    }
+    return 0;
+}
+
+int connect_to(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+bool wait_for_port(int port, int timeout_ms) {
+    for (int waited = 0; waited < timeout_ms; waited += 50) {
+        int fd = connect_to(port);
+        if (fd >= 0) {
+            close(fd);
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    return false;
+}
+
+pid_t start_server(const Config& cfg) {
+    std::vector<std::string> args = {cfg.server};
+    for (auto& a : split(cfg.server_args, ' ')) args.push_back(a);
+    args.insert(args.end(), {"--port", std::to_string(cfg.port)});
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        // Config override (server/config.h): keep the idle connections open for the whole run.
+        setenv("LALA_HTTP_IDLE_TIMEOUT_S", std::to_string(cfg.idle_timeout_s).c_str(), 1);
+        std::vector<char*> argv;
+        for (auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+        argv.push_back(nullptr);
+        execv(argv[0], argv.data());
+        std::perror("execv");
+        _exit(127);
+    }
+    return pid;
+}
+
+// Returns true once a whole response (headers + Content-Length body) is buffered.
+bool response_complete(const std::string& in, int& status) {
+    size_t hdr_end = in.find("\r\n\r\n");
+    if (hdr_end == std::string::npos) return false;
+    status = in.size() > 12 ? std::atoi(in.c_str() + 9) : 0;
+    size_t body_len = 0;
+    std::string lower = in.substr(0, hdr_end);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+    size_t cl = lower.find("content-length:");
+    if (cl != std::string::npos) body_len = std::strtoul(lower.c_str() + cl + 15, nullptr, 10);
+    return in.size() >= hdr_end + 4 + body_len;
+}
+
+std::string request_for(const Config& cfg) {
+    return "GET " + cfg.path + " HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: keep-alive\r\n\r\n";
+}
+
+// Connect, complete one request, and leave the connection open. Returns the fd or -1.
+int open_idle(const Config& cfg) {
+    int fd = connect_to(cfg.port);
+    if (fd < 0) return -1;
+    std::string req = request_for(cfg);
+    if (send(fd, req.data(), req.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(req.size())) {
+        close(fd);
+        return -1;
+    }
+    std::string in;
+    char buf[16384];
+    int status = 0;
+    while (!response_complete(in, status)) {
+        ssize_t r = recv(fd, buf, sizeof(buf), 0);
+        if (r <= 0) {
+            close(fd);
+            return -1;
+        }
+        in.append(buf, static_cast<size_t>(r));
+    }
+    return fd;
+}
+
+// Connections the server has not closed (no EOF or error pending).
+size_t count_open(const std::vector<int>& fds) {
+    size_t open = 0;
+    for (int fd : fds) {
+        struct pollfd p = {fd, POLLIN | POLLRDHUP, 0};
+        if (poll(&p, 1, 0) == 0) open++;
+    }
+    return open;
+}
+
+struct ClientResult {
+    uint64_t ok = 0;
+    uint64_t errors = 0;
+    std::vector<uint32_t> latency_us;
+};
+
+struct Conn {
+    int fd = -1;
+    std::string in;
+    Clock::time_point sent;
+};
+
+// One outstanding request per connection, epoll-driven; latency samples in microseconds.
+void client_thread(const Config& cfg, int conns, const std::atomic<bool>& stop, ClientResult& out) {
+    const std::string request = request_for(cfg);
+    int ep = epoll_create1(0);
+    std::vector<Conn> pool(static_cast<size_t>(conns));
+    auto send_request = [&](Conn& c) {
+        c.in.clear();
+        c.sent = Clock::now();
+        return send(c.fd, request.data(), request.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(request.size());
+    };
+    auto open_conn = [&](size_t i) {
+        Conn& c = pool[i];
+        c.fd = connect_to(cfg.port);
+        if (c.fd < 0) return false;
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u64 = i;
+        epoll_ctl(ep, EPOLL_CTL_ADD, c.fd, &ev);
+        return send_request(c);
+    };
+    for (size_t i = 0; i < pool.size(); i++) {
+        if (!open_conn(i)) out.errors++;
+    }
+
+    std::vector<struct epoll_event> events(256);
+    char buf[16384];
+    while (!stop.load(std::memory_order_relaxed)) {
+        int n = epoll_wait(ep, events.data(), static_cast<int>(events.size()), 100);
+        for (int e = 0; e < n; e++) {
+            size_t i = events[e].data.u64;
+            Conn& c = pool[i];
+            ssize_t r = recv(c.fd, buf, sizeof(buf), 0);
+            int status = 0;
+            if (r > 0) {
+                c.in.append(buf, static_cast<size_t>(r));
+                if (!response_complete(c.in, status)) continue;
+            }
+            if (r > 0 && status == 200) {
+                out.ok++;
+                auto us = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - c.sent).count();
+                out.latency_us.push_back(static_cast<uint32_t>(std::min<int64_t>(us, UINT32_MAX)));
+            } else {
+                out.errors++;
+            }
+            if (r > 0 && send_request(c)) continue;
+            close(c.fd);  // server closed or failed: reconnect
+            if (!open_conn(i)) out.errors++;
+        }
+    }
+    for (auto& c : pool) {
+        if (c.fd >= 0) close(c.fd);
+    }
+    close(ep);
+}
+
+double percentile_ms(const std::vector<uint32_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    return sorted[static_cast<size_t>(p * static_cast<double>(sorted.size() - 1))] / 1000.0;
+}
+
+struct LoadResult {
+    double rps = 0;
+    uint64_t errors = 0;
+    double p50 = 0, p99 = 0;
+    long peak_rss_kb = 0;
+};
+
+LoadResult run_load(const Config& cfg, pid_t pid) {
+    LoadResult res;
+    if (cfg.active <= 0) return res;
+    std::atomic<bool> stop{false};
+    std::vector<ClientResult> results(static_cast<size_t>(cfg.client_threads));
+    std::vector<std::thread> threads;
+    int per = std::max(1, cfg.active / cfg.client_threads);
+    auto t0 = Clock::now();
+    for (int t = 0; t < cfg.client_threads; t++) {
+        threads.emplace_back([&, t] { client_thread(cfg, per, stop, results[static_cast<size_t>(t)]); });
+    }
+    auto end = t0 + std::chrono::duration<double>(cfg.duration_s);
+    while (Clock::now() < end) {
+        res.peak_rss_kb = std::max(res.peak_rss_kb, rss_kb(pid));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    stop = true;
+    for (auto& t : threads) t.join();
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    uint64_t ok = 0;
+    std::vector<uint32_t> all;
+    for (auto& r : results) {
+        ok += r.ok;
+        res.errors += r.errors;
+        all.insert(all.end(), r.latency_us.begin(), r.latency_us.end());
+    }
+    std::sort(all.begin(), all.end());
+    res.rps = static_cast<double>(ok) / secs;
+    res.p50 = percentile_ms(all, 0.50);
+    res.p99 = percentile_ms(all, 0.99);
+    return res;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Config cfg;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        bool v = i + 1 < argc;
+        if (a == "--server" && v) cfg.server = argv[++i];
+        else if (a == "--server-args" && v) cfg.server_args = argv[++i];
+        else if (a == "--pid" && v) cfg.pid = static_cast<pid_t>(std::atoi(argv[++i]));
+        else if (a == "--port" && v) cfg.port = std::atoi(argv[++i]);
+        else if (a == "--idle" && v) cfg.idle = argv[++i];
+        else if (a == "--active" && v) cfg.active = std::atoi(argv[++i]);
+        else if (a == "--client-threads" && v) cfg.client_threads = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--duration" && v) cfg.duration_s = std::atof(argv[++i]);
+        else if (a == "--idle-timeout" && v) cfg.idle_timeout_s = std::atoi(argv[++i]);
+        else if (a == "--path" && v) cfg.path = argv[++i];
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+    raise_fd_limit();
+
+    pid_t pid = cfg.pid;
+    if (!cfg.server.empty()) pid = start_server(cfg);
+    if (!wait_for_port(cfg.port, 15000)) {
+        std::fprintf(stderr, "nothing listening on 127.0.0.1:%d\n", cfg.port);
+        if (!cfg.server.empty()) kill(pid, SIGKILL);
+        return 1;
+    }
+    if (pid <= 0) std::fprintf(stderr, "no --server or --pid: RSS columns will be 0\n");
+
+    std::printf("http_keepalive_bench: %s, %d active connections, %.1fs per step\n",
+                cfg.path.c_str(), cfg.active, cfg.duration_s);
+    std::printf("%8s %8s %10s %12s %10s %8s %9s %9s %8s\n", "idle", "opened", "rss_mb", "kb_per_idle",
+                "req/s", "errors", "p50_ms", "p99_ms", "still_open");
+
+    std::vector<int> idle_fds;
+    long base_kb = pid > 0 ? rss_kb(pid) : 0;
+    for (auto& item : split(cfg.idle, ',')) {
+        size_t target = std::strtoul(item.c_str(), nullptr, 10);
+        size_t failed = 0;
+        while (idle_fds.size() < target && failed < 100) {
+            int fd = open_idle(cfg);
+            if (fd < 0) failed++;
+            else idle_fds.push_back(fd);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        long idle_kb = pid > 0 ? rss_kb(pid) : 0;
+        double per_conn = idle_fds.empty() ? 0 : static_cast<double>(idle_kb - base_kb) / static_cast<double>(idle_fds.size());
+
+        LoadResult load = run_load(cfg, pid);
+        std::printf("%8zu %8zu %10.1f %12.1f %10.0f %8llu %9.2f %9.2f %8zu\n", target, idle_fds.size(),
+                    static_cast<double>(std::max(idle_kb, load.peak_rss_kb)) / 1024.0, per_conn, load.rps,
+                    static_cast<unsigned long long>(load.errors), load.p50, load.p99, count_open(idle_fds));
+        std::fflush(stdout);
+    }
+
+    for (int fd : idle_fds) close(fd);
+    if (!cfg.server.empty()) {
+        kill(pid, SIGTERM);
+        waitpid(pid, nullptr, 0);
+    }
+    return 0;
+}
@@ -0,0 +1,302 @@
+/**
+ * Benchmark: HTTP requests/s scaling with cores (Linux).
+ * For each core count N it starts the backend restricted to CPUs [0, N) with
+ * `--workers N` (and `--instances N --pin-threads` in reuseport mode), drives
+ * it with keep-alive GET requests from client threads pinned to the remaining
+ * CPUs, and prints requests/s and latency percentiles. Point --path at a route
+ * that does not touch the DB (default /api/metrics) to measure the HTTP side.
+ *
+ * Build: cmake -DBUILD_BENCHMARKS=ON .. && cmake --build . --target http_scaling_bench
+ * Run:   ./http_scaling_bench --server ./lala_backend --server-args "--config ../config/db_config.json"
+ *            [--cores 1,2,4,8,16,32] [--mode workers|reuseport] [--connections 256]
+ *            [--client-threads 4] [--duration 5] [--path /api/metrics] [--port 18080]
+ *        ./http_scaling_bench --port 8080   (no --server: measure an already running backend once)
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Config {
+    std::string server;
+    std::string server_args;
+    std::string cores = "1,2,4,8,16,32";
+    bool reuseport = false;
+    int port = 18080;
+    int connections = 256;
+    int client_threads = 4;
+    double duration_s = 5;
+    std::string path = "/api/metrics";
+};
+
+std::vector<std::string> split(const std::string& s, char sep) {
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, sep)) {
+        if (!item.empty()) out.push_back(item);
+    }
+    return out;
+}
+
+size_t online_cpus() {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? static_cast<size_t>(n) : 1;
+}
+
+void set_affinity(pid_t pid, size_t first, size_t count) {
+    size_t n = online_cpus();
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (size_t i = 0; i < count; i++) CPU_SET(static_cast<int>((first + i) % n), &set);
+    sched_setaffinity(pid, sizeof(set), &set);
+}
+
+int connect_to(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+bool wait_for_port(int port, int timeout_ms) {
+    for (int waited = 0; waited < timeout_ms; waited += 50) {
+        int fd = connect_to(port);
+        if (fd >= 0) {
+            close(fd);
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    return false;
+}
+
+pid_t start_server(const Config& cfg, size_t cores) {
+    std::vector<std::string> args = {cfg.server};
+    for (auto& a : split(cfg.server_args, ' ')) args.push_back(a);
+    args.insert(args.end(), {"--port", std::to_string(cfg.port), "--workers", std::to_string(cores)});
+    if (cfg.reuseport) args.insert(args.end(), {"--instances", std::to_string(cores), "--pin-threads"});
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        set_affinity(0, 0, cores);
+        std::vector<char*> argv;
+        for (auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+        argv.push_back(nullptr);
+        execv(argv[0], argv.data());
+        std::perror("execv");
+        _exit(127);
+    }
+    return pid;
+}
+
+// One outstanding request per connection; latency samples in microseconds.
+struct ClientResult {
+    uint64_t ok = 0;
+    uint64_t errors = 0;
+    std::vector<uint32_t> latency_us;
+};
+
+struct Conn {
+    int fd = -1;
+    std::string in;
+    Clock::time_point sent;
+};
+
+// Returns true once a whole response (headers + Content-Length body) is buffered.
+bool response_complete(const std::string& in, int& status) {
+    size_t hdr_end = in.find("\r\n\r\n");
+    if (hdr_end == std::string::npos) return false;
+    status = in.size() > 12 ? std::atoi(in.c_str() + 9) : 0;
+    size_t body_len = 0;
+    std::string lower = in.substr(0, hdr_end);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+    size_t cl = lower.find("content-length:");
+    if (cl != std::string::npos) body_len = std::strtoul(lower.c_str() + cl + 15, nullptr, 10);
+    return in.size() >= hdr_end + 4 + body_len;
+}
+
+void client_thread(const Config& cfg, int conns, const std::atomic<bool>& measuring,
+                   const std::atomic<bool>& stop, ClientResult& out) {
+    const std::string request = "GET " + cfg.path + " HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: keep-alive\r\n\r\n";
+    int ep = epoll_create1(0);
+    std::vector<Conn> pool(static_cast<size_t>(conns));
+    auto send_request = [&](Conn& c) {
+        c.in.clear();
+        c.sent = Clock::now();
+        return send(c.fd, request.data(), request.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(request.size());
+    };
+    auto open_conn = [&](size_t i) {
+        Conn& c = pool[i];
+        c.fd = connect_to(cfg.port);
+        if (c.fd < 0) return false;
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u64 = i;
+        epoll_ctl(ep, EPOLL_CTL_ADD, c.fd, &ev);
+        return send_request(c);
+    };
+    for (size_t i = 0; i < pool.size(); i++) {
+        if (!open_conn(i)) out.errors++;
+    }
+
+    std::vector<struct epoll_event> events(256);
+    char buf[16384];
+    while (!stop.load(std::memory_order_relaxed)) {
+        int n = epoll_wait(ep, events.data(), static_cast<int>(events.size()), 100);
+        for (int e = 0; e < n; e++) {
+            size_t i = events[e].data.u64;
+            Conn& c = pool[i];
+            ssize_t r = recv(c.fd, buf, sizeof(buf), 0);
+            int status = 0;
+            if (r > 0) {
+                c.in.append(buf, static_cast<size_t>(r));
+                if (!response_complete(c.in, status)) continue;
+            }
+            bool good = r > 0 && status == 200;
+            if (measuring.load(std::memory_order_relaxed)) {
+                if (good) {
+                    out.ok++;
+                    auto us = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - c.sent).count();
+                    out.latency_us.push_back(static_cast<uint32_t>(std::min<int64_t>(us, UINT32_MAX)));
+                } else {
+                    out.errors++;
+                }
+            }
+            if (r > 0 && send_request(c)) continue;
+            close(c.fd);  // server closed or failed: reconnect
+            if (!open_conn(i)) out.errors++;
+        }
+    }
+    for (auto& c : pool) {
+        if (c.fd >= 0) close(c.fd);
+    }
+    close(ep);
+}
+
+double percentile_ms(const std::vector<uint32_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    return sorted[static_cast<size_t>(p * static_cast<double>(sorted.size() - 1))] / 1000.0;
+}
+
+void measure(const Config& cfg, const std::string& label, size_t client_cpu_first, size_t client_cpus) {
+    std::atomic<bool> measuring{false};
+    std::atomic<bool> stop{false};
+    std::vector<ClientResult> results(static_cast<size_t>(cfg.client_threads));
+    std::vector<std::thread> threads;
+    int per = std::max(1, cfg.connections / cfg.client_threads);
+    for (int t = 0; t < cfg.client_threads; t++) {
+        threads.emplace_back([&, t] {
+            if (client_cpus) set_affinity(0, client_cpu_first, client_cpus);
+            client_thread(cfg, per, measuring, stop, results[static_cast<size_t>(t)]);
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));  // warm-up
+    measuring = true;
+    auto t0 = Clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(cfg.duration_s));
+    measuring = false;
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+    stop = true;
+    for (auto& t : threads) t.join();
+
+    uint64_t ok = 0, errors = 0;
+    std::vector<uint32_t> all;
+    for (auto& r : results) {
+        ok += r.ok;
+        errors += r.errors;
+        all.insert(all.end(), r.latency_us.begin(), r.latency_us.end());
+    }
+    std::sort(all.begin(), all.end());
+    std::printf("%-10s %10.0f req/s  errors=%-6llu p50=%7.2fms p90=%7.2fms p99=%7.2fms p99.9=%7.2fms\n",
+                label.c_str(), static_cast<double>(ok) / secs, static_cast<unsigned long long>(errors),
+                percentile_ms(all, 0.50), percentile_ms(all, 0.90), percentile_ms(all, 0.99), percentile_ms(all, 0.999));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Config cfg;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        bool v = i + 1 < argc;
+        if (a == "--server" && v) cfg.server = argv[++i];
+        else if (a == "--server-args" && v) cfg.server_args = argv[++i];
+        else if (a == "--cores" && v) cfg.cores = argv[++i];
+        else if (a == "--mode" && v) cfg.reuseport = std::string(argv[++i]) == "reuseport";
+        else if (a == "--port" && v) cfg.port = std::atoi(argv[++i]);
+        else if (a == "--connections" && v) cfg.connections = std::atoi(argv[++i]);
+        else if (a == "--client-threads" && v) cfg.client_threads = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--duration" && v) cfg.duration_s = std::atof(argv[++i]);
+        else if (a == "--path" && v) cfg.path = argv[++i];
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+    size_t cpus = online_cpus();
+    std::printf("http_scaling_bench: %s, %d connections, %d client threads, %.1fs per step, %zu CPUs online\n",
+                cfg.path.c_str(), cfg.connections, cfg.client_threads, cfg.duration_s, cpus);
+
+    if (cfg.server.empty()) {
+        if (!wait_for_port(cfg.port, 2000)) {
+            std::fprintf(stderr, "nothing listening on 127.0.0.1:%d\n", cfg.port);
+            return 1;
+        }
+        measure(cfg, "running", 0, 0);
+        return 0;
+    }
+
+    std::printf("mode=%s\n", cfg.reuseport ? "reuseport (N instances)" : "workers (1 instance, N workers)");
+    for (auto& item : split(cfg.cores, ',')) {
+        size_t n = std::strtoul(item.c_str(), nullptr, 10);
+        if (n == 0) continue;
+        if (n > cpus) {
+            std::printf("cores=%-4zu skipped (only %zu CPUs)\n", n, cpus);
+            continue;
+        }
+        pid_t pid = start_server(cfg, n);
+        if (!wait_for_port(cfg.port, 15000)) {
+            std::fprintf(stderr, "cores=%zu: backend did not start\n", n);
+            kill(pid, SIGKILL);
+            waitpid(pid, nullptr, 0);
+            continue;
+        }
+        // Clients use the CPUs the server does not; share them all if none are left.
+        size_t client_cpus = cpus > n ? cpus - n : 0;
+        measure(cfg, "cores=" + std::to_string(n), n, client_cpus);
+        kill(pid, SIGTERM);
+        waitpid(pid, nullptr, 0);
+    }
+    return 0;
+}
@@ -0,0 +1,167 @@
+/**
+ * Benchmark: decoding and formatting prices. Takes DECIMAL(10,2) values as
+ * Postgres sends them (text, and the binary NUMERIC form) and runs each
+ * through the double path the routes used — strtod, then ostringstream
+ * (json_helper::double_to_str) or "%.2f" — and through Money (utils/money.h).
+ * Prints ns per value and values/s, then sums order totals both ways and
+ * counts how many double totals are not the exact cents.
+ *
+ * Build: cmake -DBUILD_BENCHMARKS=ON .. && cmake --build . --target money_bench
+ * Run:   ./money_bench [--values 1000000] [--iterations 5]
+ */
+
+#include "utils/json_helper.h"
+#include "utils/money.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Binary NUMERIC for cents >= 0 (what numeric_send produces for scale 2).
+std::string numeric_binary(int64_t cents) {
+    std::vector<unsigned> digits;
+    int64_t whole = cents / 100;
+    for (; whole > 0; whole /= 10000) digits.insert(digits.begin(), static_cast<unsigned>(whole % 10000));
+    int weight = static_cast<int>(digits.size()) - 1;
+    digits.push_back(static_cast<unsigned>(cents % 100) * 100);
+    while (!digits.empty() && digits.back() == 0) digits.pop_back();
+    while (!digits.empty() && digits.front() == 0) {
+        digits.erase(digits.begin());
+        weight--;
+    }
+    if (digits.empty()) weight = 0;
+    std::string out;
+    auto put = [&out](unsigned v) {
+        out += static_cast<char>(v >> 8 & 0xff);
+        out += static_cast<char>(v & 0xff);
+    };
+    put(static_cast<unsigned>(digits.size()));
+    put(static_cast<unsigned>(weight) & 0xffff);
+    put(0);
+    put(2);
+    for (unsigned d : digits) put(d);
+    return out;
+}
+
+void run(const char* name, size_t n, int iterations, const std::function<size_t()>& fn) {
+    volatile size_t sink = fn();
+    auto t0 = Clock::now();
+    for (int i = 0; i < iterations; i++) sink = sink + fn();
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / iterations / static_cast<double>(n);
+    std::printf("%-26s %9.1f %12.1f\n", name, ns, 1000.0 / ns);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t values = 1000000;
+    int iterations = 5;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        bool v = i + 1 < argc;
+        if (a == "--values" && v) values = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        else if (a == "--iterations" && v) iterations = std::max(1, std::atoi(argv[++i]));
+    }
+
+    // Catalog-like prices: mostly under 1000.00, some up to the column limit.
+    std::mt19937_64 rng(42);
+    std::vector<int64_t> cents(values);
+    std::vector<std::string> text(values), binary(values);
+    for (size_t i = 0; i < values; i++) {
+        cents[i] = i % 16 == 0 ? static_cast<int64_t>(rng() % 10000000000ULL) : static_cast<int64_t>(rng() % 100000);
+        text[i] = Money::from_cents(cents[i]).str();
+        binary[i] = numeric_binary(cents[i]);
+    }
+    for (size_t i = 0; i < values; i++) {
+        Money a, b;
+        if (!Money::parse(text[i], a) || !Money::parse_numeric(binary[i].data(), binary[i].size(), b) ||
+            a.cents() != cents[i] || b.cents() != cents[i]) {
+            std::fprintf(stderr, "decode mismatch for %s\n", text[i].c_str());
+            return 1;
+        }
+    }
+
+    std::printf("%-26s %9s %12s\n", "path", "ns/value", "Mvalues/s");
+    run("double: strtod", values, iterations, [&] {
+        double sum = 0;
+        for (const auto& s : text) sum += std::strtod(s.c_str(), nullptr);
+        return static_cast<size_t>(sum);
+    });
+    run("money: parse text", values, iterations, [&] {
+        int64_t sum = 0;
+        Money m;
+        for (const auto& s : text) sum += Money::parse(s, m) ? m.cents() : 0;
+        return static_cast<size_t>(sum);
+    });
+    run("money: parse binary", values, iterations, [&] {
+        int64_t sum = 0;
+        Money m;
+        for (const auto& b : binary) sum += Money::parse_numeric(b.data(), b.size(), m) ? m.cents() : 0;
+        return static_cast<size_t>(sum);
+    });
+    run("double: ostringstream", values, iterations, [&] {
+        size_t len = 0;
+        for (int64_t c : cents) len += json_helper::double_to_str(static_cast<double>(c) / 100.0).size();
+        return len;
+    });
+    run("double: snprintf %.2f", values, iterations, [&] {
+        size_t len = 0;
+        char buf[64];
+        for (int64_t c : cents) len += static_cast<size_t>(std::snprintf(buf, sizeof(buf), "%.2f", static_cast<double>(c) / 100.0));
+        return len;
+    });
+    run("money: format", values, iterations, [&] {
+        size_t len = 0;
+        char buf[Money::MAX_CHARS];
+        for (int64_t c : cents) len += Money::from_cents(c).format(buf);
+        return len;
+    });
+    run("double: strtod + %.2f", values, iterations, [&] {
+        size_t len = 0;
+        char buf[64];
+        for (const auto& s : text) len += static_cast<size_t>(std::snprintf(buf, sizeof(buf), "%.2f", std::strtod(s.c_str(), nullptr)));
+        return len;
+    });
+    run("money: parse + format", values, iterations, [&] {
+        size_t len = 0;
+        char buf[Money::MAX_CHARS];
+        Money m;
+        for (const auto& s : text) len += Money::parse(s, m) ? m.format(buf) : 0;
+        return len;
+    });
+
+    // Orders of 1-8 lines priced from the list, totalled as /api/orders/create does. The old
+    // route bound the double itself: pqxx sends its shortest round-trip text, and NUMERIC(10,2)
+    // rounds that to cents on insert, so count totals whose text carried a residue
+    // ("59.970000000000006") and totals whose cents came out wrong after that rounding.
+    size_t orders = 0, residue = 0, wrong = 0;
+    for (size_t i = 0; i + 8 <= values; i += 8, orders++) {
+        double total = 0;
+        Money exact;
+        for (size_t k = 0; k < 1 + i / 8 % 8; k++) {
+            int qty = static_cast<int>(1 + (i + k) % 5);
+            total += std::strtod(text[i + k].c_str(), nullptr) * qty;
+            exact += Money::from_cents(cents[i + k]) * qty;
+        }
+        char buf[64];
+        std::string_view sent(buf, static_cast<size_t>(std::to_chars(buf, buf + sizeof(buf), total, std::chars_format::fixed).ptr - buf));
+        size_t dot = sent.find('.');
+        if (dot != std::string_view::npos && sent.size() - dot - 1 > 2) residue++;
+        Money stored;
+        if (!Money::parse(sent, stored) || stored != exact) wrong++;
+    }
+    std::printf("\norder totals: %zu, double text with a residue: %zu (%.1f%%), wrong cents: %zu\n", orders, residue,
+                100.0 * static_cast<double>(residue) / static_cast<double>(std::max<size_t>(1, orders)), wrong);
+    return 0;
+}
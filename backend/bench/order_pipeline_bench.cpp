@@ -0,0 +1,304 @@
+/**
+ * Benchmark: synchronous orders vs the async order pipeline
+ * (server/order_queue.h). Part one needs no database: --threads buyers
+ * journal --orders orders through OrderJournal (server/order_journal.h) in
+ * --dir, first one at a time (an fsync each, like a transaction commit per
+ * order), then all at once with the group fsync, and prints orders/s and
+ * fsyncs per order.
+ *
+ * With --conninfo it also runs both paths against a live database, on
+ * scratch tables created and dropped by the run (order_bench_*):
+ *   sync:  --threads connections, one transaction per order as
+ *          /api/orders/create does it (price and stock under FOR UPDATE,
+ *          insert order and items, decrement stock, commit);
+ *   async: --threads buyers journal their orders and queue them; one
+ *          writer commits up to --batch orders per transaction with the
+ *          pipeline's array statements.
+ * Orders pick 1-3 of --products products, so the sync path contends on
+ * product rows as a sale does.
+ *
+ * Build: cmake -DBUILD_BENCHMARKS=ON .. && cmake --build . --target order_pipeline_bench
+ * Run:   ./order_pipeline_bench [--threads 32] [--orders 20000] [--dir /tmp/order_pipeline_bench]
+ *                              [--conninfo "host=localhost port=5434 dbname=lala_store user=app_user password=app_pass"]
+ *                              [--products 20] [--batch 500]
+ */
+
+#include "server/order_journal.h"
+#include <pqxx/pqxx>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using server::JournalRecord;
+using server::OrderJournal;
+
+double seconds_since(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+std::vector<JournalRecord> make_orders(int orders, int products) {
+    std::mt19937 rng(42);
+    std::vector<JournalRecord> out(static_cast<size_t>(orders));
+    for (int i = 0; i < orders; i++) {
+        auto& o = out[static_cast<size_t>(i)];
+        char token[33];
+        std::snprintf(token, sizeof token, "%032x", i + 1);
+        o.token = token;
+        o.user_id = 1;
+        int lines = 1 + static_cast<int>(rng() % 3);
+        for (int l = 0; l < lines; l++) {
+            int id = 1 + static_cast<int>(rng() % static_cast<unsigned>(products));
+            if (std::none_of(o.items.begin(), o.items.end(), [&](auto& it) { return it.first == id; })) {
+                o.items.emplace_back(id, 1);
+            }
+        }
+        // Lock rows in one order, as a well-behaved client would.
+        std::sort(o.items.begin(), o.items.end());
+    }
+    return out;
+}
+
+// Journal every order from `threads` threads; each waits for its own record to be on disk.
+double journal_orders_per_s(const std::string& dir, std::vector<JournalRecord> orders, int threads, uint64_t& syncs) {
+    std::filesystem::remove_all(dir);
+    OrderJournal journal(dir);
+    journal.open();
+    std::atomic<size_t> next{0};
+    auto t0 = Clock::now();
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&] {
+            for (size_t i; (i = next.fetch_add(1)) < orders.size();) {
+                journal.sync(journal.append(orders[i]));
+                journal.done(orders[i].segment);
+            }
+        });
+    }
+    for (auto& t : pool) t.join();
+    double s = seconds_since(t0);
+    syncs = journal.metrics().syncs;
+    journal.close();
+    std::filesystem::remove_all(dir);
+    return static_cast<double>(orders.size()) / s;
+}
+
+std::string int_array(const std::vector<int>& v) {
+    std::string s = "{";
+    for (size_t i = 0; i < v.size(); i++) s += (i ? "," : "") + std::to_string(v[i]);
+    return s + "}";
+}
+
+void setup_tables(const std::string& conninfo, int products) {
+    pqxx::connection conn(conninfo);
+    pqxx::work txn(conn);
+    txn.exec("DROP TABLE IF EXISTS order_bench_items, order_bench_orders, order_bench_products");
+    txn.exec("CREATE TABLE order_bench_products (id INT PRIMARY KEY, price DECIMAL(10,2) NOT NULL, stock INT NOT NULL)");
+    txn.exec("CREATE TABLE order_bench_orders (id SERIAL PRIMARY KEY, user_id INT NOT NULL, "
+             "total DECIMAL(10,2) NOT NULL, token VARCHAR(32) UNIQUE)");
+    txn.exec("CREATE TABLE order_bench_items (order_id INT NOT NULL REFERENCES order_bench_orders(id), "
+             "product_id INT NOT NULL, quantity INT NOT NULL, price DECIMAL(10,2) NOT NULL, "
+             "stock_applied BOOLEAN NOT NULL DEFAULT true)");
+    txn.exec("INSERT INTO order_bench_products SELECT g, 9.99, 1000000000 FROM generate_series(1, " +
+             std::to_string(products) + ") g");
+    txn.commit();
+}
+
+void drop_tables(const std::string& conninfo) {
+    pqxx::connection conn(conninfo);
+    pqxx::work txn(conn);
+    txn.exec("DROP TABLE IF EXISTS order_bench_items, order_bench_orders, order_bench_products");
+    txn.commit();
+}
+
+double sync_orders_per_s(const std::string& conninfo, const std::vector<JournalRecord>& orders, int threads) {
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> pool;
+    std::vector<std::unique_ptr<pqxx::connection>> conns;
+    for (int t = 0; t < threads; t++) {
+        conns.push_back(std::make_unique<pqxx::connection>(conninfo));
+        auto& c = *conns.back();
+        c.prepare("price_stock", "SELECT price, stock FROM order_bench_products WHERE id = $1 FOR UPDATE");
+        c.prepare("order", "INSERT INTO order_bench_orders (user_id, total) VALUES ($1, $2) RETURNING id");
+        c.prepare("item", "INSERT INTO order_bench_items (order_id, product_id, quantity, price) VALUES ($1, $2, $3, $4)");
+        c.prepare("decrement", "UPDATE order_bench_products SET stock = stock - $1 WHERE id = $2");
+    }
+    auto t0 = Clock::now();
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&, t] {
+            auto& c = *conns[static_cast<size_t>(t)];
+            for (size_t i; (i = next.fetch_add(1)) < orders.size();) {
+                pqxx::work txn(c);
+                std::vector<std::string> prices;
+                double total = 0;
+                for (const auto& [id, qty] : orders[i].items) {
+                    auto r = txn.exec_prepared("price_stock", id);
+                    prices.push_back(r[0][0].c_str());
+                    total += r[0][0].as<double>() * qty;
+                }
+                int orderId = txn.exec_prepared("order", orders[i].user_id, std::to_string(total))[0][0].as<int>();
+                for (size_t k = 0; k < orders[i].items.size(); k++) {
+                    const auto& [id, qty] = orders[i].items[k];
+                    txn.exec_prepared("item", orderId, id, qty, prices[k]);
+                    txn.exec_prepared("decrement", qty, id);
+                }
+                txn.commit();
+            }
+        });
+    }
+    for (auto& t : pool) t.join();
+    return static_cast<double>(orders.size()) / seconds_since(t0);
+}
+
+double async_orders_per_s(const std::string& conninfo, const std::string& dir, std::vector<JournalRecord> orders,
+                          int threads, size_t batch_max, uint64_t& batches) {
+    std::filesystem::remove_all(dir);
+    OrderJournal journal(dir);
+    journal.open();
+    pqxx::connection conn(conninfo);
+    conn.prepare("prices", "SELECT id, price FROM order_bench_products WHERE id = ANY($1::int[])");
+    conn.prepare("orders", "INSERT INTO order_bench_orders (user_id, total, token) "
+                           "SELECT u, t, k FROM unnest($1::int[], $2::numeric[], $3::text[]) AS b(u, t, k) RETURNING id, token");
+    conn.prepare("items", "INSERT INTO order_bench_items (order_id, product_id, quantity, price, stock_applied) "
+                          "SELECT o, p, q, pr, false FROM unnest($1::int[], $2::int[], $3::int[], $4::numeric[]) AS b(o, p, q, pr)");
+
+    std::mutex mu;
+    std::condition_variable cv;
+    std::deque<const JournalRecord*> queue;
+    size_t producers_left = static_cast<size_t>(threads);
+    std::atomic<size_t> next{0};
+    batches = 0;
+
+    auto t0 = Clock::now();
+    std::thread writer([&] {
+        std::unique_lock<std::mutex> lock(mu);
+        while (true) {
+            cv.wait(lock, [&] { return !queue.empty() || producers_left == 0; });
+            if (queue.empty()) break;
+            size_t n = std::min(queue.size(), batch_max);
+            std::vector<const JournalRecord*> batch(queue.begin(), queue.begin() + static_cast<std::ptrdiff_t>(n));
+            queue.erase(queue.begin(), queue.begin() + static_cast<std::ptrdiff_t>(n));
+            lock.unlock();
+
+            std::vector<int> ids;
+            for (const auto* o : batch) {
+                for (const auto& [id, qty] : o->items) ids.push_back(id);
+            }
+            pqxx::work txn(conn);
+            std::vector<std::string> price(ids.empty() ? 1 : static_cast<size_t>(*std::max_element(ids.begin(), ids.end()) + 1));
+            std::vector<double> value(price.size());
+            for (const auto& row : txn.exec_prepared("prices", int_array(ids))) {
+                price[static_cast<size_t>(row[0].as<int>())] = row[1].c_str();
+                value[static_cast<size_t>(row[0].as<int>())] = row[1].as<double>();
+            }
+            std::string users = "{", totals = "{", tokens = "{";
+            for (size_t i = 0; i < batch.size(); i++) {
+                double total = 0;
+                for (const auto& [id, qty] : batch[i]->items) total += value[static_cast<size_t>(id)] * qty;
+                const char* sep = i ? "," : "";
+                users += sep + std::to_string(batch[i]->user_id);
+                totals += sep + std::to_string(total);
+                tokens += sep + batch[i]->token;
+            }
+            auto inserted = txn.exec_prepared("orders", users + "}", totals + "}", tokens + "}");
+            std::vector<std::pair<std::string, int>> byToken;
+            for (const auto& row : inserted) byToken.emplace_back(row[1].as<std::string>(), row[0].as<int>());
+            std::sort(byToken.begin(), byToken.end());
+            std::vector<int> itemOrders, itemProducts, itemQtys;
+            std::string itemPrices = "{";
+            for (const auto* o : batch) {
+                int orderId = std::lower_bound(byToken.begin(), byToken.end(), std::make_pair(o->token, 0))->second;
+                for (const auto& [id, qty] : o->items) {
+                    itemOrders.push_back(orderId);
+                    itemProducts.push_back(id);
+                    itemQtys.push_back(qty);
+                    itemPrices += (itemPrices.size() > 1 ? "," : "") + price[static_cast<size_t>(id)];
+                }
+            }
+            txn.exec_prepared("items", int_array(itemOrders), int_array(itemProducts), int_array(itemQtys), itemPrices + "}");
+            txn.commit();
+            for (const auto* o : batch) journal.done(o->segment);
+            batches++;
+            lock.lock();
+        }
+    });
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&] {
+            for (size_t i; (i = next.fetch_add(1)) < orders.size();) {
+                journal.sync(journal.append(orders[i]));
+                std::lock_guard<std::mutex> lock(mu);
+                queue.push_back(&orders[i]);
+                cv.notify_one();
+            }
+            std::lock_guard<std::mutex> lock(mu);
+            producers_left--;
+            cv.notify_one();
+        });
+    }
+    for (auto& t : pool) t.join();
+    writer.join();
+    double s = seconds_since(t0);
+    journal.close();
+    std::filesystem::remove_all(dir);
+    return static_cast<double>(orders.size()) / s;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int threads = 32, orders = 20000, products = 20, batch = 500;
+    std::string dir = "/tmp/order_pipeline_bench", conninfo;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        bool v = i + 1 < argc;
+        if (a == "--threads" && v) threads = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--orders" && v) orders = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--products" && v) products = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--batch" && v) batch = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--dir" && v) dir = argv[++i];
+        else if (a == "--conninfo" && v) conninfo = argv[++i];
+    }
+    auto list = make_orders(orders, products);
+
+    std::printf("journal: %d orders in %s\n", orders, dir.c_str());
+    uint64_t soloSyncs = 0, groupSyncs = 0;
+    double solo = journal_orders_per_s(dir, list, 1, soloSyncs);
+    double group = journal_orders_per_s(dir, list, threads, groupSyncs);
+    std::printf("  %-26s %10.0f orders/s %8.3f fsyncs/order\n", "1 thread, fsync each", solo,
+                static_cast<double>(soloSyncs) / orders);
+    std::printf("  %-26s %10.0f orders/s %8.3f fsyncs/order\n", (std::to_string(threads) + " threads, group fsync").c_str(),
+                group, static_cast<double>(groupSyncs) / orders);
+
+    if (conninfo.empty()) return 0;
+    std::printf("\ndatabase: %d orders over %d products, %d threads\n", orders, products, threads);
+    try {
+        setup_tables(conninfo, products);
+        double sync = sync_orders_per_s(conninfo, list, threads);
+        uint64_t batches = 0;
+        double async = async_orders_per_s(conninfo, dir, list, threads, static_cast<size_t>(batch), batches);
+        drop_tables(conninfo);
+        std::printf("  %-26s %10.0f orders/s %8d transactions\n", "sync (txn per order)", sync, orders);
+        std::printf("  %-26s %10.0f orders/s %8llu transactions (batch <= %d)\n", "async (journal + batches)", async,
+                    static_cast<unsigned long long>(batches), batch);
+        std::printf("  speedup: %.1fx\n", async / sync);
+    } catch (std::exception& e) {
+        std::fprintf(stderr, "database: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
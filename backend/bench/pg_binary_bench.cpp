@@ -0,0 +1,280 @@
+/**
+ * Benchmark: text vs binary result format for the catalog query. Builds
+ * products_all results in both formats — the exact values Postgres sends —
+ * and prints DataRow bytes on the wire, the time to decode every row into a
+ * Product, and the time to decode and write the JSON list as the route does.
+ * The text path decodes like pqxx does (from_chars, Money::parse, raw
+ * strings); the binary path is row_mapping over pg_binary (db/pg_binary.h).
+ *
+ * With --conninfo it also runs products_all against a live database in both
+ * formats and prints round-trip time, wire bytes and decode time per query.
+ *
+ * Build: cmake -DBUILD_BENCHMARKS=ON .. && cmake --build . --target pg_binary_bench
+ * Run:   ./pg_binary_bench [--rows 24,1000,20000] [--iterations 50]
+ *                          [--conninfo "host=localhost port=5434 dbname=lala_store user=app_user password=app_pass"]
+ */
+
+#include "db/pg_binary.h"
+#include "db/row_mapping.h"
+#include "db/statements.h"
+#include "models/Product.h"
+#include "utils/serializer.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int COLUMNS = 9;
+const Oid TYPES[COLUMNS] = {pg_binary::INT4_OID, pg_binary::INT4_OID, pg_binary::VARCHAR_OID,
+                            pg_binary::TEXT_OID, pg_binary::NUMERIC_OID, pg_binary::VARCHAR_OID,
+                            pg_binary::INT4_OID, pg_binary::VARCHAR_OID, pg_binary::TIMESTAMP_OID};
+
+std::vector<int> parse_list(const std::string& s) {
+    std::vector<int> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) out.push_back(std::atoi(item.c_str()));
+    }
+    return out;
+}
+
+std::string be(uint64_t v, int bytes) {
+    std::string out;
+    for (int i = bytes - 1; i >= 0; i--) out += static_cast<char>(v >> (8 * i) & 0xff);
+    return out;
+}
+
+// numeric_send output for a non-negative scale-2 value.
+std::string numeric_binary(int64_t cents) {
+    std::vector<unsigned> digits;
+    for (int64_t whole = cents / 100; whole > 0; whole /= 10000) digits.insert(digits.begin(), static_cast<unsigned>(whole % 10000));
+    int weight = static_cast<int>(digits.size()) - 1;
+    digits.push_back(static_cast<unsigned>(cents % 100) * 100);
+    while (!digits.empty() && digits.back() == 0) digits.pop_back();
+    while (!digits.empty() && digits.front() == 0) {
+        digits.erase(digits.begin());
+        weight--;
+    }
+    if (digits.empty()) weight = 0;
+    std::string out = be(digits.size(), 2) + be(static_cast<uint16_t>(weight), 2) + be(0, 2) + be(2, 2);
+    for (unsigned d : digits) out += be(d, 2);
+    return out;
+}
+
+const char* NAMES[] = {"Classic Denim Jacket", "Slim Fit Chinos", "Wool Blend Coat", "Linen Summer Shirt",
+                       "Floral Midi Dress", "Cashmere Sweater", "Leather Ankle Boots", "Pleated Skirt"};
+
+// Seed-like products_all rows in both formats.
+void make_results(int rows, PGresult*& text, PGresult*& binary) {
+    text = PQmakeEmptyPGresult(nullptr, PGRES_TUPLES_OK);
+    binary = PQmakeEmptyPGresult(nullptr, PGRES_TUPLES_OK);
+    const char* names[COLUMNS] = {"id", "category_id", "name", "description", "price", "image_url", "stock", "cat_name", "created_at"};
+    PGresAttDesc text_attrs[COLUMNS], binary_attrs[COLUMNS];
+    for (int c = 0; c < COLUMNS; c++) {
+        text_attrs[c] = {const_cast<char*>(names[c]), 0, 0, 0, TYPES[c], -1, -1};
+        binary_attrs[c] = {const_cast<char*>(names[c]), 0, 0, 1, TYPES[c], -1, -1};
+    }
+    PQsetResultAttrs(text, COLUMNS, text_attrs);
+    PQsetResultAttrs(binary, COLUMNS, binary_attrs);
+    for (int i = 0; i < rows; i++) {
+        std::string name = std::string(NAMES[i % 8]) + " " + std::to_string(i);
+        int64_t cents = 1999 + i * 37 % 200 * 100;
+        // 2024-01-15 10:MM:SS.123456, in microseconds since 2000-01-01.
+        int64_t us = ((8780LL * 86400 + 36000 + (10 + i % 50) * 60 + i % 60) * 1000000) + 123456;
+        char ts[pg_binary::TIMESTAMP_CHARS];
+        std::string values_text[COLUMNS] = {
+            std::to_string(i + 1), std::to_string(i % 2 + 1), name,
+            "Comfortable " + name + " made from premium materials, item " + std::to_string(i * 7919 % 10007) + ".",
+            Money::from_cents(cents).str(), "https://images.example.com/products/" + std::to_string(i + 1) + ".jpg",
+            std::to_string(i * 13 % 120), i % 2 ? "Women" : "Men", std::string(ts, pg_binary::format_timestamp(us, ts))};
+        std::string values_binary[COLUMNS] = {
+            be(static_cast<uint32_t>(i + 1), 4), be(static_cast<uint32_t>(i % 2 + 1), 4), values_text[2], values_text[3],
+            numeric_binary(cents), values_text[5], be(static_cast<uint32_t>(i * 13 % 120), 4), values_text[7],
+            be(static_cast<uint64_t>(us), 8)};
+        for (int c = 0; c < COLUMNS; c++) {
+            PQsetvalue(text, i, c, values_text[c].data(), static_cast<int>(values_text[c].size()));
+            PQsetvalue(binary, i, c, values_binary[c].data(), static_cast<int>(values_binary[c].size()));
+        }
+    }
+}
+
+// DataRow messages: type byte, int32 length, int16 column count, then int32 length + bytes per value.
+size_t wire_bytes(const PGresult* r) {
+    size_t total = 0;
+    for (int i = 0; i < PQntuples(r); i++) {
+        total += 1 + 4 + 2;
+        for (int c = 0; c < PQnfields(r); c++) total += 4 + static_cast<size_t>(PQgetisnull(r, i, c) ? 0 : PQgetlength(r, i, c));
+    }
+    return total;
+}
+
+// What row_mapping's text path does per value (pqxx's as<int> is from_chars-based).
+int text_int(const PGresult* r, int row, int col) {
+    const char* v = PQgetvalue(r, row, col);
+    int out = 0;
+    std::from_chars(v, v + PQgetlength(r, row, col), out);
+    return out;
+}
+
+std::string_view text_view(const PGresult* r, int row, int col) {
+    return std::string_view(PQgetvalue(r, row, col), static_cast<size_t>(PQgetlength(r, row, col)));
+}
+
+Product decode_text(const PGresult* r, int row) {
+    Product p{};
+    p.id = text_int(r, row, 0);
+    p.category_id = text_int(r, row, 1);
+    p.name = text_view(r, row, 2);
+    p.description = text_view(r, row, 3);
+    Money::parse(text_view(r, row, 4), p.price);
+    p.image_url = text_view(r, row, 5);
+    p.stock = text_int(r, row, 6);
+    p.category_name = text_view(r, row, 7);
+    p.created_at = text_view(r, row, 8);
+    return p;
+}
+
+std::string json_text(const PGresult* r) {
+    serializer::JsonWriter w;
+    w.begin_array(0);
+    for (int i = 0; i < PQntuples(r); i++) {
+        w.begin_object(COLUMNS);
+        w.key("id"); w.integer(text_int(r, i, 0));
+        w.key("category_id"); w.integer(text_int(r, i, 1));
+        w.key("name"); w.string(text_view(r, i, 2));
+        w.key("description"); w.string(text_view(r, i, 3));
+        Money price;
+        Money::parse(text_view(r, i, 4), price);
+        w.key("price"); w.money(price);
+        w.key("image_url"); w.string(text_view(r, i, 5));
+        w.key("stock"); w.integer(text_int(r, i, 6));
+        w.key("category_name"); w.string(text_view(r, i, 7));
+        w.key("created_at"); w.string(text_view(r, i, 8));
+        w.end_object();
+    }
+    w.end_array();
+    return w.take();
+}
+
+double time_us(int iterations, const std::function<size_t()>& fn) {
+    volatile size_t sink = fn();
+    auto t0 = Clock::now();
+    for (int i = 0; i < iterations; i++) sink = sink + fn();
+    return std::chrono::duration<double, std::micro>(Clock::now() - t0).count() / iterations;
+}
+
+void report(const char* source, size_t rows, const char* format, size_t bytes, double decode_us, double json_us) {
+    std::printf("%-9s %6zu %-7s %10zu %8.1f %11.1f %9.1f %9.1f\n", source, rows, format, bytes,
+                static_cast<double>(bytes) / static_cast<double>(std::max<size_t>(1, rows)), decode_us,
+                decode_us * 1000.0 / static_cast<double>(std::max<size_t>(1, rows)), json_us);
+}
+
+void run_synthetic(int rows, int iterations) {
+    PGresult* text = nullptr;
+    PGresult* binary_raw = nullptr;
+    make_results(rows, text, binary_raw);
+    pg_binary::Result binary(binary_raw);
+
+    serializer::JsonWriter w;
+    row_mapping::write_rows<Product>(w, binary);
+    if (w.take() != json_text(text)) {
+        std::fprintf(stderr, "rows=%d: binary and text JSON differ\n", rows);
+        std::exit(1);
+    }
+
+    double text_decode = time_us(iterations, [&] {
+        size_t sum = 0;
+        for (int i = 0; i < rows; i++) sum += static_cast<size_t>(decode_text(text, i).price.cents());
+        return sum;
+    });
+    double text_json = time_us(iterations, [&] { return json_text(text).size(); });
+    double binary_decode = time_us(iterations, [&] {
+        size_t sum = 0;
+        for (const auto& row : binary) sum += static_cast<size_t>(row_mapping::decode<Product>(row).price.cents());
+        return sum;
+    });
+    double binary_json = time_us(iterations, [&] {
+        serializer::JsonWriter out;
+        row_mapping::write_rows<Product>(out, binary);
+        return out.take().size();
+    });
+    report("synthetic", static_cast<size_t>(rows), "text", wire_bytes(text), text_decode, text_json);
+    report("synthetic", static_cast<size_t>(rows), "binary", wire_bytes(binary_raw), binary_decode, binary_json);
+    PQclear(text);
+}
+
+void run_live(const std::string& conninfo, int iterations) {
+    std::printf("\n%-9s %6s %-7s %10s %8s %11s %9s %9s\n", "source", "rows", "format", "wire_B", "B/row", "decode_us",
+                "ns/row", "query_us");
+    PGconn* conn = PQconnectdb(conninfo.c_str());
+    if (PQstatus(conn) != CONNECTION_OK) {
+        std::fprintf(stderr, "connect: %s", PQerrorMessage(conn));
+        std::exit(1);
+    }
+    size_t count = 0;
+    const db_statements::Statement* all = db_statements::all(count);
+    const char* sql = nullptr;
+    for (size_t i = 0; i < count; i++) {
+        if (std::strcmp(all[i].name, "products_all") == 0) sql = all[i].sql;
+    }
+    for (int format : {0, 1}) {
+        size_t bytes = 0, rows = 0;
+        double round_trip = 0, decode = 0;
+        for (int i = 0; i < iterations; i++) {
+            auto t0 = Clock::now();
+            PGresult* r = PQexecParams(conn, sql, 0, nullptr, nullptr, nullptr, nullptr, format);
+            auto t1 = Clock::now();
+            if (PQresultStatus(r) != PGRES_TUPLES_OK) {
+                std::fprintf(stderr, "products_all: %s", PQresultErrorMessage(r));
+                std::exit(1);
+            }
+            rows = static_cast<size_t>(PQntuples(r));
+            bytes = wire_bytes(r);
+            volatile size_t sum = 0;
+            if (format == 0) {
+                for (int k = 0; k < PQntuples(r); k++) sum = sum + static_cast<size_t>(decode_text(r, k).stock);
+                PQclear(r);
+            } else {
+                pg_binary::Result result(r);
+                for (const auto& row : result) sum = sum + static_cast<size_t>(row_mapping::decode<Product>(row).stock);
+            }
+            auto t2 = Clock::now();
+            round_trip += std::chrono::duration<double, std::micro>(t1 - t0).count();
+            decode += std::chrono::duration<double, std::micro>(t2 - t1).count();
+        }
+        report("live", rows, format ? "binary" : "text", bytes, decode / iterations, round_trip / iterations);
+    }
+    PQfinish(conn);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string rows_arg = "24,1000,20000";
+    std::string conninfo;
+    int iterations = 50;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        bool v = i + 1 < argc;
+        if (a == "--rows" && v) rows_arg = argv[++i];
+        else if (a == "--iterations" && v) iterations = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--conninfo" && v) conninfo = argv[++i];
+    }
+
+    std::printf("%-9s %6s %-7s %10s %8s %11s %9s %9s\n", "source", "rows", "format", "wire_B", "B/row", "decode_us",
+                "ns/row", "json_us");
+    for (int rows : parse_list(rows_arg)) run_synthetic(rows, iterations);
+    if (!conninfo.empty()) run_live(conninfo, iterations);
+    return 0;
+}
@@ -0,0 +1,183 @@
+/**
+ * Benchmark: response encoding cost and payload size per wire format.
+ * Builds products, cart items and orders shaped like the seed data, then
+ * encodes each list as the routes do — the {"success":true,"data":[...]}
+ * envelope — with the JSON, MessagePack and CBOR writers, plus the string
+ * concatenation the JSON routes used before (json_helper) as a baseline.
+ * Prints bytes, gzip bytes, encode time per list and per item, and MB/s.
+ *
+ * Build: cmake -DBUILD_BENCHMARKS=ON .. && cmake --build . --target serialization_bench
+ * Run:   ./serialization_bench [--rows 24,1000,20000] [--iterations 50]
+ */
+
+#include "models/CartItem.h"
+#include "models/Order.h"
+#include "models/Product.h"
+#include "server/compression.h"
+#include "utils/response_helper.h"
+#include "utils/serializer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::vector<int> parse_list(const std::string& s) {
+    std::vector<int> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) out.push_back(std::atoi(item.c_str()));
+    }
+    return out;
+}
+
+const char* NAMES[] = {"Classic Denim Jacket", "Slim Fit Chinos", "Wool Blend Coat", "Linen Summer Shirt",
+                       "Floral Midi Dress", "Cashmere Sweater", "Leather Ankle Boots", "Pleated Skirt"};
+
+std::vector<Product> make_products(int n) {
+    std::vector<Product> out;
+    for (int i = 0; i < n; i++) {
+        std::string name = std::string(NAMES[i % 8]) + " " + std::to_string(i);
+        out.push_back({i + 1, i % 2 + 1, name,
+                       "Comfortable " + name + " made from \"premium\" materials, item " + std::to_string(i * 7919 % 10007) + ".",
+                       Money::from_cents(1999 + i * 37 % 200 * 100), "https://images.example.com/products/" + std::to_string(i + 1) + ".jpg",
+                       i * 13 % 120, i % 2 ? "Women" : "Men", "2024-01-15 10:" + std::to_string(10 + i % 50) + ":00.123456"});
+    }
+    return out;
+}
+
+std::vector<CartItem> make_cart(int n) {
+    std::vector<CartItem> out;
+    for (int i = 0; i < n; i++) {
+        out.push_back({i + 1, 42, i * 7 % 500 + 1, i % 4 + 1, std::string(NAMES[i % 8]) + " " + std::to_string(i),
+                       Money::from_cents(1999 + i * 37 % 200 * 100), "https://images.example.com/products/" + std::to_string(i + 1) + ".jpg"});
+    }
+    return out;
+}
+
+// n orders of three items each.
+std::vector<Order> make_orders(int n) {
+    std::vector<Order> out;
+    for (int i = 0; i < n; i++) {
+        Order o{i + 1, 42, Money(), i % 3 ? "completed" : "pending", "2024-02-0" + std::to_string(1 + i % 9) + " 12:00:00.5", {}};
+        for (int k = 0; k < 3; k++) {
+            o.items.push_back({(i + k) % 500 + 1, std::string(NAMES[(i + k) % 8]), k + 1, Money::from_cents(2950 + k * 100)});
+            o.total += o.items.back().price_at_purchase * (k + 1);
+        }
+        out.push_back(std::move(o));
+    }
+    return out;
+}
+
+// What the routes built before the writers: one string per field, joined.
+std::string concat_json(const Product& p) {
+    return "{\"id\":" + std::to_string(p.id) + ",\"category_id\":" + std::to_string(p.category_id) +
+        ",\"name\":" + json_helper::quote(p.name) + ",\"description\":" + json_helper::quote(p.description) +
+        ",\"price\":" + json_helper::double_to_str(p.price.to_double()) + ",\"image_url\":" + json_helper::quote(p.image_url) +
+        ",\"stock\":" + std::to_string(p.stock) + ",\"category_name\":" + json_helper::quote(p.category_name) +
+        ",\"created_at\":" + json_helper::quote(p.created_at) + "}";
+}
+
+std::string concat_json(const CartItem& c) {
+    return "{\"id\":" + std::to_string(c.id) + ",\"user_id\":" + std::to_string(c.user_id) +
+        ",\"product_id\":" + std::to_string(c.product_id) + ",\"quantity\":" + std::to_string(c.quantity) +
+        ",\"product_name\":" + json_helper::quote(c.product_name) + ",\"price\":" + json_helper::double_to_str(c.price.to_double()) +
+        ",\"image_url\":" + json_helper::quote(c.image_url) + "}";
+}
+
+std::string concat_json(const Order& o) {
+    std::string items = "[";
+    for (size_t i = 0; i < o.items.size(); i++) {
+        if (i > 0) items += ",";
+        const auto& it = o.items[i];
+        items += "{\"product_id\":" + std::to_string(it.product_id) + ",\"product_name\":" + json_helper::quote(it.product_name) +
+            ",\"quantity\":" + std::to_string(it.quantity) +
+            ",\"price_at_purchase\":" + json_helper::double_to_str(it.price_at_purchase.to_double()) + "}";
+    }
+    items += "]";
+    return "{\"id\":" + std::to_string(o.id) + ",\"user_id\":" + std::to_string(o.user_id) +
+        ",\"total\":" + json_helper::double_to_str(o.total.to_double()) + ",\"status\":\"" + json_helper::escape(o.status) + "\"" +
+        ",\"created_at\":\"" + json_helper::escape(o.created_at) + "\"" + ",\"items\":" + items + "}";
+}
+
+template <typename T>
+std::string encode_concat(const std::vector<T>& list) {
+    std::string arr = "[";
+    for (size_t i = 0; i < list.size(); i++) {
+        if (i > 0) arr += ",";
+        arr += concat_json(list[i]);
+    }
+    return response_helper::success_json(arr + "]");
+}
+
+// Same envelope as server::data_response.
+template <typename W, typename T>
+std::string encode(const std::vector<T>& list) {
+    W w;
+    w.begin_object(2);
+    w.key("success");
+    w.boolean(true);
+    w.key("data");
+    schema::write_array(w, list);
+    w.end_object();
+    return w.take();
+}
+
+template <typename T>
+void run(const char* entity, const std::vector<T>& list, int iterations) {
+    struct Encoder {
+        const char* name;
+        std::function<std::string()> fn;
+    };
+    std::vector<Encoder> encoders = {
+        {"json-concat", [&] { return encode_concat(list); }},
+        {"json", [&] { return encode<serializer::JsonWriter>(list); }},
+        {"msgpack", [&] { return encode<serializer::MsgPackWriter>(list); }},
+        {"cbor", [&] { return encode<serializer::CborWriter>(list); }},
+    };
+    std::string reference = encoders[0].fn();
+    for (const auto& e : encoders) {
+        std::string body = e.fn();
+        if (std::string(e.name) == "json" && body != reference) {
+            std::fprintf(stderr, "%s: JSON writer output differs from the concatenated JSON\n", entity);
+            std::exit(1);
+        }
+        auto t0 = Clock::now();
+        for (int i = 0; i < iterations; i++) body = e.fn();
+        double us = std::chrono::duration<double, std::micro>(Clock::now() - t0).count() / iterations;
+        size_t gz = server::compress(body, server::Encoding::Gzip, 6).size();
+        std::printf("%-8s %6zu %-12s %10zu %9zu %11.1f %9.1f %8.1f\n", entity, list.size(), e.name, body.size(), gz,
+                    us, us * 1000.0 / static_cast<double>(std::max<size_t>(1, list.size())),
+                    static_cast<double>(body.size()) / us);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string rows_arg = "24,1000,20000";
+    int iterations = 50;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        bool v = i + 1 < argc;
+        if (a == "--rows" && v) rows_arg = argv[++i];
+        else if (a == "--iterations" && v) iterations = std::max(1, std::atoi(argv[++i]));
+    }
+
+    std::printf("%-8s %6s %-12s %10s %9s %11s %9s %8s\n", "entity", "rows", "format", "bytes", "gzip", "encode_us",
+                "ns/item", "MB/s");
+    for (int rows : parse_list(rows_arg)) {
+        run("products", make_products(rows), iterations);
+        run("cart", make_cart(rows), iterations);
+        run("orders", make_orders(rows), iterations);
+    }
+    return 0;
+}
@@ -0,0 +1,191 @@
+/**
+ * Benchmark: flash-sale contention on one product. Part one checks the stock
+ * ledger (server/stock_ledger.h) for overselling: in every round, --buyers
+ * threads are released at once on a product with --stock units, each
+ * reserving 1 to --max-qty units, and --fail-pct of them give their units
+ * back (an order that failed after reserving). The run fails if the units
+ * kept ever exceed the stock or stop reconciling with what a group commit
+ * would write, and, with single units and no failures, if any unit is left
+ * unsold while buyers were refused.
+ *
+ * Part two compares throughput with --threads buyers on one product: the
+ * old path, where each order holds the product's row lock for a simulated
+ * --txn-us transaction, against the ledger, where the check is a CAS and the
+ * same transaction runs without a shared lock, and stock is written by one
+ * simulated group commit every --commit-ms.
+ *
+ * Build: cmake -DBUILD_BENCHMARKS=ON .. && cmake --build . --target stock_ledger_bench
+ * Run:   ./stock_ledger_bench [--buyers 1000] [--stock 100] [--max-qty 1] [--fail-pct 10] [--rounds 20]
+ *                             [--threads 64] [--orders 20000] [--txn-us 200] [--commit-ms 10]
+ */
+
+#include "server/stock_ledger.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using server::StockLedger;
+
+constexpr int PRODUCT = 1;
+
+struct Round {
+    int64_t kept = 0;      // units in orders that "committed"
+    int64_t rejected = 0;  // buyers refused
+};
+
+Round oversell_round(int buyers, int stock, int max_qty, int fail_pct, uint64_t seed) {
+    StockLedger ledger;
+    ledger.add(PRODUCT, stock);
+    std::atomic<bool> go{false};
+    std::atomic<int64_t> kept{0}, rejected{0};
+    std::vector<std::thread> threads;
+    threads.reserve(static_cast<size_t>(buyers));
+    for (int b = 0; b < buyers; b++) {
+        threads.emplace_back([&, b] {
+            std::mt19937_64 rng(seed + static_cast<uint64_t>(b));
+            int qty = 1 + static_cast<int>(rng() % static_cast<uint64_t>(max_qty));
+            bool fails = static_cast<int>(rng() % 100) < fail_pct;
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            if (ledger.reserve(PRODUCT, qty) != StockLedger::Reserve::Ok) {
+                rejected++;
+                return;
+            }
+            if (fails) ledger.release(PRODUCT, qty);
+            else kept += qty;
+        });
+    }
+    go.store(true, std::memory_order_release);
+    for (auto& t : threads) t.join();
+
+    Round r;
+    r.kept = kept.load();
+    r.rejected = rejected.load();
+    // What the committer does after writing the kept units to products.stock.
+    ledger.applied(PRODUCT, r.kept);
+    ledger.reconcile(PRODUCT, stock - r.kept);
+    auto m = ledger.metrics();
+    if (r.kept > stock || ledger.available(PRODUCT) != stock - r.kept || m.adjusted != 0) {
+        std::fprintf(stderr, "oversold or out of balance: stock %d, kept %lld, available %lld, adjusted %llu\n", stock,
+                     static_cast<long long>(r.kept), static_cast<long long>(ledger.available(PRODUCT)),
+                     static_cast<unsigned long long>(m.adjusted));
+        std::exit(1);
+    }
+    return r;
+}
+
+// Each order: one shared row lock held across its whole transaction.
+double row_lock_orders_per_s(int threads, int orders, int txn_us) {
+    std::mutex row;
+    int64_t stock = INT64_MAX;
+    std::atomic<int> next{0};
+    auto t0 = Clock::now();
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&] {
+            while (next.fetch_add(1) < orders) {
+                std::lock_guard<std::mutex> lock(row);
+                if (stock >= 1) stock--;
+                std::this_thread::sleep_for(std::chrono::microseconds(txn_us));
+            }
+        });
+    }
+    for (auto& t : pool) t.join();
+    return orders / std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+// Each order: a CAS on the ledger, then its transaction with no shared lock;
+// one committer thread writes the stock every commit_ms (holding the row for txn_us).
+double ledger_orders_per_s(int threads, int orders, int txn_us, int commit_ms, uint64_t& flushes) {
+    StockLedger ledger;
+    ledger.add(PRODUCT, INT32_MAX);
+    std::mutex row;
+    std::atomic<int64_t> pending{0};
+    std::atomic<bool> done{false};
+    std::atomic<int> next{0};
+    flushes = 0;
+    std::thread committer([&] {
+        while (!done.load() || pending.load() > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(commit_ms));
+            int64_t units = pending.exchange(0);
+            if (units == 0) continue;
+            std::lock_guard<std::mutex> lock(row);
+            std::this_thread::sleep_for(std::chrono::microseconds(txn_us));
+            ledger.applied(PRODUCT, units);
+            flushes++;
+        }
+    });
+    auto t0 = Clock::now();
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&] {
+            while (next.fetch_add(1) < orders) {
+                if (ledger.reserve(PRODUCT, 1) != StockLedger::Reserve::Ok) continue;
+                std::this_thread::sleep_for(std::chrono::microseconds(txn_us));
+                pending++;
+            }
+        });
+    }
+    for (auto& t : pool) t.join();
+    double s = std::chrono::duration<double>(Clock::now() - t0).count();
+    done = true;
+    committer.join();
+    return orders / s;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int buyers = 1000, stock = 100, max_qty = 1, fail_pct = 10, rounds = 20;
+    int threads = 64, orders = 20000, txn_us = 200, commit_ms = 10;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        bool v = i + 1 < argc;
+        if (a == "--buyers" && v) buyers = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--stock" && v) stock = std::max(0, std::atoi(argv[++i]));
+        else if (a == "--max-qty" && v) max_qty = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--fail-pct" && v) fail_pct = std::clamp(std::atoi(argv[++i]), 0, 100);
+        else if (a == "--rounds" && v) rounds = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--threads" && v) threads = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--orders" && v) orders = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--txn-us" && v) txn_us = std::max(0, std::atoi(argv[++i]));
+        else if (a == "--commit-ms" && v) commit_ms = std::max(1, std::atoi(argv[++i]));
+    }
+
+    std::printf("oversell check: %d buyers x %d rounds, %d units, 1-%d each, %d%% fail after reserving\n", buyers,
+                rounds, stock, max_qty, fail_pct);
+    int64_t kept = 0, rejected = 0;
+    for (int r = 0; r < rounds; r++) {
+        Round round = oversell_round(buyers, stock, max_qty, fail_pct, static_cast<uint64_t>(r) * 7919);
+        // Releases can free units after someone was refused; without them nothing may be left over.
+        if (max_qty == 1 && fail_pct == 0 && round.kept != std::min(stock, buyers)) {
+            std::fprintf(stderr, "round %d: sold %lld of %d units to %d buyers\n", r,
+                         static_cast<long long>(round.kept), stock, buyers);
+            return 1;
+        }
+        kept += round.kept;
+        rejected += round.rejected;
+    }
+    std::printf("  ok: %.1f units sold per round (max %d), %.1f buyers refused per round\n\n",
+                static_cast<double>(kept) / rounds, stock, static_cast<double>(rejected) / rounds);
+
+    std::printf("throughput: %d threads, %d orders on one product, %d us per transaction\n", threads, orders, txn_us);
+    double locked = row_lock_orders_per_s(threads, orders, txn_us);
+    uint64_t flushes = 0;
+    double ledgered = ledger_orders_per_s(threads, orders, txn_us, commit_ms, flushes);
+    std::printf("  %-22s %12.0f orders/s %10d stock updates\n", "row lock per order", locked, orders);
+    std::printf("  %-22s %12.0f orders/s %10llu stock updates (%d ms group commit)\n", "ledger", ledgered,
+                static_cast<unsigned long long>(flushes), commit_ms);
+    std::printf("  speedup: %.1fx\n", ledgered / locked);
+    return 0;
+}
@@ -0,0 +1,142 @@
+/**
+ * Benchmark: autocomplete lookups. Builds the suggest trie
+ * (server/suggest_index.h) from synthetic product names with random sales
+ * counts, then answers prefixes of 1-8 characters taken from those names,
+ * once through the trie and once by scanning every name for a word starting
+ * with the prefix and keeping the top 10 by sales (what a LIKE scan plus
+ * ORDER BY does, without the round trip). Prints build time, trie size and
+ * ns per lookup by prefix length. Exits with an error if the two disagree.
+ *
+ * Build: cmake -DBUILD_BENCHMARKS=ON .. && cmake --build . --target suggest_bench
+ * Run:   ./suggest_bench [--products 100000] [--lookups 20000]
+ */
+
+#include "server/suggest_index.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using server::SuggestIndex;
+
+const char* const ADJECTIVES[] = {"Classic", "Slim", "Relaxed", "Vintage", "Essential", "Premium", "Soft",
+                                  "Summer", "Winter", "Urban", "Oversized", "Cropped", "Tailored", "Light"};
+const char* const MATERIALS[] = {"Cotton", "Linen", "Denim", "Wool", "Leather", "Silk", "Fleece", "Jersey",
+                                 "Cashmere", "Canvas", "Suede", "Knit"};
+const char* const ITEMS[] = {"Shirt", "T-Shirt", "Jeans", "Jacket", "Dress", "Skirt", "Hoodie", "Sweater",
+                             "Blazer", "Coat", "Shorts", "Trousers", "Sneakers", "Boots", "Scarf", "Cap"};
+
+template <size_t N>
+const char* pick(const char* const (&words)[N], std::mt19937_64& rng) {
+    return words[rng() % N];
+}
+
+char lower(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+bool word_start_match(const std::string& name, const std::string& prefix) {
+    for (size_t i = 0; i + prefix.size() <= name.size(); i++) {
+        bool start = i == 0 || !std::isalnum(static_cast<unsigned char>(name[i - 1]));
+        if (!start || !std::isalnum(static_cast<unsigned char>(name[i]))) continue;
+        size_t j = 0;
+        while (j < prefix.size() && lower(name[i + j]) == lower(prefix[j])) j++;
+        if (j == prefix.size()) return true;
+    }
+    return false;
+}
+
+// Top-10 by sales (then id) of the names with a word starting with `prefix`, as (id) list.
+std::vector<int> scan(const std::vector<SuggestIndex::Entry>& entries, const std::string& prefix) {
+    std::vector<const SuggestIndex::Entry*> hits;
+    for (const auto& e : entries) {
+        if (word_start_match(e.name, prefix)) hits.push_back(&e);
+    }
+    auto better = [](const SuggestIndex::Entry* a, const SuggestIndex::Entry* b) {
+        return a->popularity != b->popularity ? a->popularity > b->popularity : a->id < b->id;
+    };
+    size_t keep = std::min(hits.size(), SuggestIndex::TOP_K);
+    std::partial_sort(hits.begin(), hits.begin() + static_cast<std::ptrdiff_t>(keep), hits.end(), better);
+    std::vector<int> ids;
+    for (size_t i = 0; i < keep; i++) ids.push_back(hits[i]->id);
+    return ids;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t count = 100000;
+    size_t lookups = 20000;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        bool v = i + 1 < argc;
+        if (a == "--products" && v) count = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        else if (a == "--lookups" && v) lookups = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+    }
+
+    std::mt19937_64 rng(7);
+    std::vector<SuggestIndex::Entry> entries(count);
+    for (size_t i = 0; i < count; i++) {
+        entries[i].id = static_cast<int>(i + 1);
+        entries[i].name = std::string(pick(ADJECTIVES, rng)) + " " + pick(MATERIALS, rng) + " " + pick(ITEMS, rng) +
+            " " + std::to_string(rng() % 1000);
+        entries[i].popularity = static_cast<int64_t>(rng() % 5000);
+    }
+
+    auto t0 = Clock::now();
+    SuggestIndex index(entries);
+    double build_ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    std::printf("products: %zu, built in %.1f ms, %zu nodes, %.1f MiB\n\n", count, build_ms, index.nodes(),
+                static_cast<double>(index.bytes()) / (1024.0 * 1024.0));
+
+    std::printf("%-7s %10s %12s %12s %9s\n", "prefix", "avg_hits", "trie_ns", "scan_ns", "speedup");
+    std::vector<uint32_t> out;
+    for (size_t len : {1, 2, 3, 5, 8}) {
+        // Prefixes of real words, so most lookups have hits.
+        std::vector<std::string> prefixes;
+        for (size_t i = 0; i < lookups; i++) {
+            const std::string& name = entries[rng() % count].name;
+            size_t start = 0;
+            for (size_t w = rng() % 3; w > 0; w--) start = name.find(' ', start) + 1;
+            prefixes.push_back(name.substr(start, len));
+        }
+
+        // The scan is slow; check and time it on a sample.
+        size_t sample = std::min<size_t>(prefixes.size(), 200);
+        size_t hits = 0;
+        auto s0 = Clock::now();
+        for (size_t i = 0; i < sample; i++) {
+            auto expected = scan(entries, prefixes[i]);
+            index.suggest(prefixes[i], SuggestIndex::TOP_K, out);
+            std::vector<int> got;
+            for (uint32_t e : out) got.push_back(index.entry(e).id);
+            if (got != expected) {
+                std::fprintf(stderr, "prefix \"%s\": trie and scan disagree\n", prefixes[i].c_str());
+                return 1;
+            }
+            hits += got.size();
+        }
+        double scan_ns = std::chrono::duration<double, std::nano>(Clock::now() - s0).count() / static_cast<double>(sample);
+
+        auto t1 = Clock::now();
+        size_t sink = 0;
+        for (const auto& p : prefixes) {
+            index.suggest(p, SuggestIndex::TOP_K, out);
+            sink += out.size();
+        }
+        double trie_ns = std::chrono::duration<double, std::nano>(Clock::now() - t1).count() / static_cast<double>(prefixes.size());
+        char speedup[16];
+        std::snprintf(speedup, sizeof(speedup), "%.0fx", scan_ns / trie_ns);
+        std::printf("%-7zu %10.1f %12.0f %12.0f %9s%s\n", len, static_cast<double>(hits) / static_cast<double>(sample),
+                    trie_ns, scan_ns, speedup, sink == 0 ? " (no hits)" : "");
+    }
+    return 0;
+}
@@ -1,34 +1,60 @@
 #pragma once
 
+#include "connection_pool.h"
+#include "pg_binary.h"
 #include <pqxx/pqxx>
 #include <memory>
 #include <string>
 
+/// Database part of the backend config (see server::AppConfig for defaults and validation).
 struct DbConfig {
-    std::string host;
-    int port;
-    std::string dbname;
-    std::string user;
-    std::string password;
+    std::string host = "localhost";
+    int port = 5432;
+    std::string dbname = "lala_store";
+    std::string user = "postgres";
+    std::string password = "postgres";
     std::string lab_user;
     std::string lab_password;
+    int pool_size = 8;         // app_user connections
+    int db_threads = 0;        // DB executor workers; 0 = pool_size
+    int binary_pool_size = 0;  // extra app_user connections for binary-format catalog reads; 0 = off
 };
 
+using BinaryPool = BasicConnectionPool<pg_binary::Connection>;
+
 class Database {
 public:
     static Database& instance();
-    void loadConfig(const std::string& configPath);
-    /// Main app connection (app_user). Use for normal routes.
-    pqxx::connection& getConnection();
-    /// Lab connection (lab_readonly). Use for /lab routes. SELECT only on products/categories.
-    pqxx::connection& getLabConnection();
+    /// Use `config` for the next connect(). Does not connect.
+    void configure(const DbConfig& config);
+    /// Open the app pool (all connections, in parallel) and the lab connection.
+    void connect();
+    /// Prepare db_statements on every app connection, now and on reconnect.
+    void prepareStatements();
+    const DbConfig& config() const { return config_; }
+    /// Lease a main app connection (app_user) from the pool. Use for normal routes.
+    ConnectionPool::Lease acquire();
+    /// Whether hot reads should use acquireBinary() (binary_pool_size > 0).
+    bool binaryResults() const { return binary_pool_ != nullptr; }
+    /// Lease a binary-results connection (app_user). Throws unless binaryResults().
+    BinaryPool::Lease acquireBinary();
+    /// Lease the lab connection (lab_readonly). Use for /lab routes. SELECT only on products/categories.
+    ConnectionPool::Lease acquireLab();
+    ConnectionPool& pool();
+    /// Change the app pool's connection limit at runtime (config reload).
+    void resizePool(int size);
+    /// Close both pools (shutdown). Later acquire() calls throw.
+    void close();
     bool isSecurityLabMode() const { return security_lab_mode_; }
     void setSecurityLabMode(bool v) { security_lab_mode_ = v; }
 
 private:
     Database() = default;
-    std::unique_ptr<pqxx::connection> conn_;
-    std::unique_ptr<pqxx::connection> lab_conn_;
+    std::unique_ptr<ConnectionPool> pool_;
+    std::unique_ptr<ConnectionPool> lab_pool_;
+    std::unique_ptr<BinaryPool> binary_pool_;
     DbConfig config_;
+    std::string conn_str_;
+    std::string lab_conn_str_;
     bool security_lab_mode_ = false;
 };
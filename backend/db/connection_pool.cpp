@@ -0,0 +1,25 @@
+#include "connection_pool.h"
+#include <exception>
+#include <thread>
+
+namespace connection_pool_detail {
+
+void run_parallel(size_t n, const std::function<void(size_t)>& job) {
+    std::vector<std::exception_ptr> errors(n);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < n; i++) {
+        threads.emplace_back([&, i] {
+            try {
+                job(i);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    for (auto& e : errors) {
+        if (e) std::rethrow_exception(e);
+    }
+}
+
+} // namespace connection_pool_detail
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <pqxx/pqxx>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace connection_pool_detail {
+/// Run job(i) for i in [0, n) on n threads; rethrow the first failure after all finish.
+void run_parallel(size_t n, const std::function<void(size_t)>& job);
+}
+
+/// Bounded pool of libpq connections. pqxx::connection is not thread-safe, so
+/// every request (or DB executor task) leases its own connection for the
+/// duration of its transaction(s). `Conn` is pqxx::connection for the app and
+/// lab pools, pg_binary::Connection for binary results; it needs a
+/// constructor from the connection string (throwing on failure) and is_open().
+template <typename Conn>
+class BasicConnectionPool {
+public:
+    /// RAII lease; returns the connection to the pool on destruction.
+    class Lease {
+    public:
+        Lease(BasicConnectionPool* pool, std::unique_ptr<Conn> conn)
+            : pool_(pool), conn_(std::move(conn)) {}
+        Lease(Lease&& other) noexcept = default;
+        Lease& operator=(Lease&&) = delete;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease() {
+            if (pool_ && conn_) pool_->release(std::move(conn_));
+        }
+        Conn& operator*() const { return *conn_; }
+        Conn* operator->() const { return conn_.get(); }
+
+    private:
+        BasicConnectionPool* pool_;
+        std::unique_ptr<Conn> conn_;
+    };
+
+    BasicConnectionPool(std::string conn_str, size_t size)
+        : conn_str_(std::move(conn_str)), size_(size == 0 ? 1 : size) {}
+
+    using Initializer = std::function<void(Conn&)>;
+
+    /// Run `init` on every connection the pool opens from now on (reconnects in
+    /// acquire() included), e.g. to prepare statements.
+    void set_initializer(Initializer init) {
+        std::lock_guard<std::mutex> lock(mu_);
+        init_ = std::move(init);
+    }
+
+    /// Open all connections up front, in parallel. Throws if any fails.
+    void open() {
+        std::lock_guard<std::mutex> lock(mu_);
+        size_t missing = size_ > created_ ? size_ - created_ : 0;
+        std::vector<std::unique_ptr<Conn>> opened(missing);
+        connection_pool_detail::run_parallel(missing, [&](size_t i) {
+            opened[i] = std::make_unique<Conn>(conn_str_);
+            if (init_) init_(*opened[i]);
+        });
+        for (auto& c : opened) idle_.push_back(std::move(c));
+        created_ += missing;
+    }
+
+    /// Run `fn` on every idle connection, one thread per connection. Use at
+    /// startup (prepare, warm caches) before traffic arrives. Throws if any fails.
+    void for_each_idle(const std::function<void(Conn&)>& fn) {
+        std::lock_guard<std::mutex> lock(mu_);
+        connection_pool_detail::run_parallel(idle_.size(), [&](size_t i) { fn(*idle_[i]); });
+    }
+
+    /// Block until a connection is free. Broken connections are reopened here.
+    /// Throws once the pool is closed.
+    Lease acquire() {
+        std::unique_lock<std::mutex> lock(mu_);
+        cv_.wait(lock, [this] { return closed_ || !idle_.empty() || created_ < size_; });
+        if (closed_) throw std::runtime_error("Connection pool closed");
+        std::unique_ptr<Conn> conn;
+        if (!idle_.empty()) {
+            conn = std::move(idle_.back());
+            idle_.pop_back();
+        } else {
+            created_++;
+        }
+        lock.unlock();
+
+        if (!conn || !conn->is_open()) {
+            try {
+                conn = std::make_unique<Conn>(conn_str_);
+                if (init_) init_(*conn);
+            } catch (...) {
+                std::lock_guard<std::mutex> relock(mu_);
+                created_--;
+                cv_.notify_one();
+                throw;
+            }
+        }
+        return Lease(this, std::move(conn));
+    }
+
+    /// Close idle connections now and leased ones as they are returned.
+    void close() {
+        std::lock_guard<std::mutex> lock(mu_);
+        closed_ = true;
+        created_ -= idle_.size();
+        idle_.clear();  // ~Conn closes the socket
+        cv_.notify_all();
+    }
+
+    /// Change the connection limit. Shrinking closes idle connections now and
+    /// leased ones as they come back; growing lets waiters open new ones.
+    void resize(size_t size) {
+        std::lock_guard<std::mutex> lock(mu_);
+        size_ = size == 0 ? 1 : size;
+        while (created_ > size_ && !idle_.empty()) {
+            idle_.pop_back();
+            created_--;
+        }
+        cv_.notify_all();
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mu_);
+        return size_;
+    }
+
+    size_t idle() const {
+        std::lock_guard<std::mutex> lock(mu_);
+        return idle_.size();
+    }
+
+private:
+    void release(std::unique_ptr<Conn> conn) {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (conn->is_open() && !closed_ && created_ <= size_) idle_.push_back(std::move(conn));
+        else created_--;  // reopened lazily by the next acquire() (unless the pool shrank)
+        cv_.notify_one();
+    }
+
+    std::string conn_str_;
+    size_t size_;
+    size_t created_ = 0;
+    bool closed_ = false;
+    mutable std::mutex mu_;
+    std::condition_variable cv_;
+    std::vector<std::unique_ptr<Conn>> idle_;
+    Initializer init_;
+};
+
+using ConnectionPool = BasicConnectionPool<pqxx::connection>;
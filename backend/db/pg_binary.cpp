@@ -0,0 +1,255 @@
+#include "pg_binary.h"
+#include <pqxx/pqxx>
+#include <charconv>
+#include <climits>
+#include <cstring>
+
+namespace pg_binary {
+
+namespace {
+
+uint64_t be(const char* p, size_t n) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < n; i++) v = v << 8 | static_cast<unsigned char>(p[i]);
+    return v;
+}
+
+[[noreturn]] void mismatch(const Field& f, const char* wanted) {
+    throw pqxx::conversion_error(std::string("Cannot read ") + (f.null ? "NULL" : "type " + std::to_string(f.type)) +
+                                 " as " + wanted);
+}
+
+char* two_digits(char* p, unsigned v) {
+    p[0] = static_cast<char>('0' + v / 10);
+    p[1] = static_cast<char>('0' + v % 10);
+    return p + 2;
+}
+
+constexpr int64_t US_PER_DAY = 86400LL * 1000000;
+constexpr int64_t DAYS_1970_TO_2000 = 10957;
+
+} // namespace
+
+int32_t int4(const Field& f) {
+    if (!f.null && f.type == INT4_OID && f.size == 4) return static_cast<int32_t>(be(f.data, 4));
+    if (!f.null && f.type == INT2_OID && f.size == 2) return static_cast<int16_t>(be(f.data, 2));
+    mismatch(f, "int4");
+}
+
+int64_t int8(const Field& f) {
+    if (!f.null && f.type == INT8_OID && f.size == 8) return static_cast<int64_t>(be(f.data, 8));
+    return int4(f);
+}
+
+Money numeric(const Field& f) {
+    Money m;
+    if (f.null || f.type != NUMERIC_OID || !Money::parse_numeric(f.data, f.size, m)) mismatch(f, "numeric");
+    return m;
+}
+
+int64_t timestamp(const Field& f) {
+    if (f.null || f.type != TIMESTAMP_OID || f.size != 8) mismatch(f, "timestamp");
+    return static_cast<int64_t>(be(f.data, 8));
+}
+
+size_t format_timestamp(int64_t us, char* buf) {
+    if (us == INT64_MAX || us == INT64_MIN) {
+        const char* word = us == INT64_MAX ? "infinity" : "-infinity";
+        size_t n = std::strlen(word);
+        std::memcpy(buf, word, n);
+        return n;
+    }
+    int64_t days = us / US_PER_DAY;
+    int64_t time = us % US_PER_DAY;
+    if (time < 0) {
+        time += US_PER_DAY;
+        days--;
+    }
+    // Proleptic Gregorian date from days since 1970-01-01 (H. Hinnant's civil_from_days).
+    int64_t z = days + DAYS_1970_TO_2000 + 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    auto doe = static_cast<uint32_t>(z - era * 146097);  // [0, 146096]
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp = (5 * doy + 2) / 153;
+    unsigned day = doy - (153 * mp + 2) / 5 + 1;
+    unsigned month = mp < 10 ? mp + 3 : mp - 9;
+    int64_t year = yoe + era * 400 + (month <= 2);
+    bool bc = year <= 0;
+    if (bc) year = 1 - year;  // there is no year 0: 0 is 1 BC
+
+    char* p = buf;
+    if (year < 10000) {
+        p = two_digits(p, static_cast<unsigned>(year / 100));
+        p = two_digits(p, static_cast<unsigned>(year % 100));
+    } else {
+        p = std::to_chars(p, p + 24, year).ptr;
+    }
+    *p++ = '-';
+    p = two_digits(p, month);
+    *p++ = '-';
+    p = two_digits(p, day);
+    *p++ = ' ';
+    auto secs = static_cast<uint32_t>(time / 1000000);
+    auto frac = static_cast<uint32_t>(time % 1000000);
+    p = two_digits(p, secs / 3600);
+    *p++ = ':';
+    p = two_digits(p, secs / 60 % 60);
+    *p++ = ':';
+    p = two_digits(p, secs % 60);
+    // Microseconds without trailing zeros, and no point at all for whole seconds.
+    if (frac != 0) {
+        *p++ = '.';
+        p = two_digits(p, frac / 10000);
+        p = two_digits(p, frac / 100 % 100);
+        p = two_digits(p, frac % 100);
+        while (p[-1] == '0') p--;
+    }
+    if (bc) {
+        std::memcpy(p, " BC", 3);
+        p += 3;
+    }
+    return static_cast<size_t>(p - buf);
+}
+
+bool parse_timestamp(std::string_view s, int64_t& us) {
+    if (s == "infinity" || s == "-infinity") {
+        us = s[0] == '-' ? INT64_MIN : INT64_MAX;
+        return true;
+    }
+    bool bc = s.size() > 3 && s.substr(s.size() - 3) == " BC";
+    if (bc) s.remove_suffix(3);
+    const char* p = s.data();
+    const char* end = p + s.size();
+    int64_t year = 0;
+    auto [ye, yerr] = std::from_chars(p, end, year);
+    if (yerr != std::errc() || ye - p < 4 || year < 1) return false;
+    p = ye;
+    // "-MM-DD HH:MM:SS" after the year
+    static constexpr char SHAPE[] = "-00-00 00:00:00";
+    unsigned parts[5];
+    if (end - p < 15) return false;
+    for (int i = 0; i < 15; i++) {
+        bool digit = p[i] >= '0' && p[i] <= '9';
+        if (SHAPE[i] == '0' ? !digit : p[i] != SHAPE[i]) return false;
+    }
+    for (int i = 0; i < 5; i++) parts[i] = static_cast<unsigned>((p[1 + 3 * i] - '0') * 10 + (p[2 + 3 * i] - '0'));
+    p += 15;
+    unsigned month = parts[0], day = parts[1];
+    if (month < 1 || month > 12 || day < 1 || day > 31 || parts[2] > 23 || parts[3] > 59 || parts[4] > 59) return false;
+    int64_t frac = 0;
+    if (p != end) {
+        if (*p++ != '.' || end - p < 1 || end - p > 6) return false;
+        int digits = 0;
+        for (; p != end; p++, digits++) {
+            if (*p < '0' || *p > '9') return false;
+            frac = frac * 10 + (*p - '0');
+        }
+        for (; digits < 6; digits++) frac *= 10;
+    }
+    if (bc) year = 1 - year;
+    // Days since 1970-01-01 (H. Hinnant's days_from_civil), the inverse of format_timestamp's date.
+    int64_t y = year - (month <= 2);
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    auto yoe = static_cast<unsigned>(y - era * 400);
+    unsigned doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int64_t days = era * 146097 + static_cast<int64_t>(doe) - 719468 - DAYS_1970_TO_2000;
+    us = (days * 86400 + parts[2] * 3600 + parts[3] * 60 + parts[4]) * 1000000 + frac;
+    return true;
+}
+
+std::string_view text(const Field& f, char* buf) {
+    if (f.null) return {};
+    switch (f.type) {
+    case TEXT_OID:
+    case VARCHAR_OID:
+    case BPCHAR_OID:
+    case NAME_OID:
+        return std::string_view(f.data, f.size);
+    case TIMESTAMP_OID:
+        return std::string_view(buf, format_timestamp(timestamp(f), buf));
+    default:
+        mismatch(f, "text");
+    }
+}
+
+void throw_column_range(int column) {
+    throw pqxx::range_error("Column " + std::to_string(column) + " out of range");
+}
+
+Result::Result(PGresult* res) : res_(res, PQclear), rows_(PQntuples(res)), types_(static_cast<size_t>(PQnfields(res))) {
+    for (size_t c = 0; c < types_.size(); c++) types_[c] = PQftype(res, static_cast<int>(c));
+}
+
+size_t Result::value_bytes() const {
+    size_t total = 0;
+    int cols = columns();
+    for (int i = 0; i < rows_; i++) {
+        for (int c = 0; c < cols; c++) total += static_cast<size_t>(PQgetlength(res_.get(), i, c));
+    }
+    return total;
+}
+
+Connection::Connection(const std::string& conn_str) : conn_(PQconnectdb(conn_str.c_str())) {
+    if (PQstatus(conn_) != CONNECTION_OK) {
+        std::string error = conn_ ? PQerrorMessage(conn_) : "out of memory";
+        PQfinish(conn_);
+        throw pqxx::broken_connection(error);
+    }
+}
+
+Connection::~Connection() {
+    PQfinish(conn_);
+}
+
+bool Connection::is_open() const {
+    return PQstatus(conn_) == CONNECTION_OK;
+}
+
+void Connection::prepare(const char* name, const char* sql) {
+    check(PQprepare(conn_, name, sql, 0, nullptr), sql);
+}
+
+Result Connection::exec(const char* sql) {
+    return check(PQexec(conn_, sql), sql);
+}
+
+Result Connection::exec_prepared(const std::string& name, const std::vector<std::string>& params) {
+    std::vector<const char*> values(params.size());
+    for (size_t i = 0; i < params.size(); i++) values[i] = params[i].c_str();
+    return check(PQexecPrepared(conn_, name.c_str(), static_cast<int>(params.size()), values.data(), nullptr,
+                                nullptr, 1), name.c_str());
+}
+
+Result Connection::check(PGresult* res, const char* what) {
+    Result result(res);
+    ExecStatusType status = res ? PQresultStatus(res) : PGRES_FATAL_ERROR;
+    if (status == PGRES_COMMAND_OK || status == PGRES_TUPLES_OK) return result;
+    std::string error = res ? PQresultErrorMessage(res) : PQerrorMessage(conn_);
+    if (PQstatus(conn_) != CONNECTION_OK) throw pqxx::broken_connection(error);
+    const char* sqlstate = res ? PQresultErrorField(res, PG_DIAG_SQLSTATE) : nullptr;
+    // Same mapping as pqxx for the states db_error_response cares about.
+    if (sqlstate && std::strcmp(sqlstate, "57014") == 0) throw pqxx::query_canceled(error, what, sqlstate);
+    throw pqxx::sql_error(error, what, sqlstate);
+}
+
+Transaction::Transaction(Connection& conn) : conn_(conn) {
+    conn_.exec("BEGIN");
+}
+
+Transaction::~Transaction() {
+    if (!open_) return;
+    try {
+        conn_.exec("ROLLBACK");
+    } catch (...) {
+        // Connection gone: the server has rolled back already.
+    }
+}
+
+void Transaction::commit() {
+    open_ = false;
+    conn_.exec("COMMIT");
+}
+
+} // namespace pg_binary
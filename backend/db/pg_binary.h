@@ -0,0 +1,184 @@
+#pragma once
+
+#include "../utils/money.h"
+#include <libpq-fe.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Binary-format results straight from libpq. pqxx always asks for text, so
+ * Postgres formats every int, numeric and timestamp as text and the routes
+ * parse it back; here the server sends its internal wire form (big-endian
+ * int4, base-10000 numeric digits, int64 microseconds) and the decoders
+ * below read it in a few instructions. Used for the hot catalog and order
+ * reads when binary_pool_size is set (server/db_read.h picks the path).
+ *
+ * Errors are thrown as the pqxx exceptions the text path raises
+ * (sql_error, query_canceled, broken_connection, conversion_error), so
+ * server::db_error_response maps both paths the same way.
+ */
+namespace pg_binary {
+
+// Type OIDs (pg_type.dat) of the columns the decoders understand.
+constexpr Oid INT2_OID = 21;
+constexpr Oid INT4_OID = 23;
+constexpr Oid INT8_OID = 20;
+constexpr Oid NAME_OID = 19;
+constexpr Oid TEXT_OID = 25;
+constexpr Oid BPCHAR_OID = 1042;
+constexpr Oid VARCHAR_OID = 1043;
+constexpr Oid NUMERIC_OID = 1700;
+constexpr Oid TIMESTAMP_OID = 1114;
+
+/// Room for any timestamp as Postgres prints it ("294276-12-31 23:59:59.999999 BC").
+constexpr size_t TIMESTAMP_CHARS = 40;
+
+/// One value of a binary result: a view into the PGresult.
+struct Field {
+    const char* data;
+    size_t size;
+    bool null;
+    Oid type;
+
+    bool is_null() const { return null; }
+};
+
+/// int2/int4 columns. Throws pqxx::conversion_error on NULL or another type.
+int32_t int4(const Field& f);
+/// int2/int4/int8 columns.
+int64_t int8(const Field& f);
+/// numeric columns, rounded to cents (Money::parse_numeric).
+Money numeric(const Field& f);
+/// timestamp (without time zone) columns: microseconds since 2000-01-01 00:00:00.
+int64_t timestamp(const Field& f);
+/// `us` as Postgres prints a timestamp with DateStyle ISO ("2024-01-15 10:12:00.5"); returns the length.
+size_t format_timestamp(int64_t us, char* buf);
+/// The reverse, for timestamps that arrived as text: false unless `s` is in format_timestamp's form.
+bool parse_timestamp(std::string_view s, int64_t& us);
+/**
+ * A column the API sends as a string: text types as they are, timestamps
+ * formatted into `buf` (TIMESTAMP_CHARS bytes) like the text protocol would
+ * have sent them. NULL is "". Other types throw pqxx::conversion_error.
+ */
+std::string_view text(const Field& f, char* buf);
+
+class Result;
+
+[[noreturn]] void throw_column_range(int column);
+
+/// Row view, indexed by column like pqxx::row.
+class Row {
+public:
+    Row(const Result* result, int row) : result_(result), row_(row) {}
+    Field operator[](int column) const;
+    size_t size() const;
+
+private:
+    const Result* result_;
+    int row_;
+};
+
+/// Owns a PGresult with binary values.
+class Result {
+public:
+    class const_iterator {
+    public:
+        const_iterator(const Result* r, int row) : r_(r), row_(row) {}
+        Row operator*() const { return Row(r_, row_); }
+        const_iterator& operator++() {
+            row_++;
+            return *this;
+        }
+        bool operator!=(const const_iterator& o) const { return row_ != o.row_; }
+
+    private:
+        const Result* r_;
+        int row_;
+    };
+
+    explicit Result(PGresult* res);
+
+    size_t size() const { return static_cast<size_t>(rows_); }
+    bool empty() const { return rows_ == 0; }
+    int columns() const { return static_cast<int>(types_.size()); }
+    Row operator[](size_t row) const { return Row(this, static_cast<int>(row)); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, static_cast<int>(size())); }
+    Field field(int row, int column) const {
+        PGresult* r = res_.get();
+        int length = PQgetlength(r, row, column);
+        // NULL reads as length 0, so only empty values need the extra call.
+        bool null = length == 0 && PQgetisnull(r, row, column);
+        return {PQgetvalue(r, row, column), static_cast<size_t>(length), null, types_[static_cast<size_t>(column)]};
+    }
+    /// Total bytes of all values, i.e. the DataRow payload without the per-value length words.
+    size_t value_bytes() const;
+
+private:
+    std::unique_ptr<PGresult, void (*)(PGresult*)> res_;
+    int rows_;
+    std::vector<Oid> types_;  // per column, read once instead of per value
+};
+
+inline Field Row::operator[](int column) const {
+    if (column < 0 || column >= result_->columns()) throw_column_range(column);
+    return result_->field(row_, column);
+}
+
+inline size_t Row::size() const {
+    return static_cast<size_t>(result_->columns());
+}
+
+/// One libpq connection. Not thread-safe; leased from a BasicConnectionPool.
+class Connection {
+public:
+    /// Connects; throws pqxx::broken_connection on failure.
+    explicit Connection(const std::string& conn_str);
+    ~Connection();
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    bool is_open() const;
+    /// Prepare `sql` as `name` (binary results are chosen per execution, so any statement works).
+    void prepare(const char* name, const char* sql);
+    /// A statement without parameters, text results (BEGIN, COMMIT, ROLLBACK).
+    Result exec(const char* sql);
+    /// Run a prepared statement; parameters go as text, results come back binary.
+    Result exec_prepared(const std::string& name, const std::vector<std::string>& params);
+
+private:
+    Result check(PGresult* res, const char* what);
+
+    PGconn* conn_;
+};
+
+inline std::string param(const std::string& v) { return v; }
+inline std::string param(const char* v) { return v; }
+inline std::string param(int v) { return std::to_string(v); }
+inline std::string param(int64_t v) { return std::to_string(v); }
+
+/// BEGIN ... COMMIT on a Connection, with pqxx::work's shape: exec_prepared(name, args...),
+/// commit(), and a rollback if it goes out of scope uncommitted.
+class Transaction {
+public:
+    explicit Transaction(Connection& conn);
+    ~Transaction();
+    Transaction(const Transaction&) = delete;
+    Transaction& operator=(const Transaction&) = delete;
+
+    template <typename... Args>
+    Result exec_prepared(const std::string& name, const Args&... args) {
+        return conn_.exec_prepared(name, {param(args)...});
+    }
+    void commit();
+
+private:
+    Connection& conn_;
+    bool open_ = true;
+};
+
+} // namespace pg_binary
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "../models/schema.h"
+#include "../utils/money.h"
+#include "pg_binary.h"
+#include <pqxx/pqxx>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+/**
+ * pqxx side of the model descriptors (models/schema.h): rows are decoded by
+ * column index, and text columns are read as views of the result buffer, so
+ * write_row/write_rows copy each value once, into the response. NULL text
+ * reads as "" (the API has always sent empty strings); NULL numbers throw,
+ * as row[i].as<int>() did. Money columns are parsed from their text with
+ * Money::parse, never through double.
+ *
+ * The same templates take pg_binary rows and results (db/pg_binary.h): ints,
+ * numerics and timestamps are then decoded from their binary form, and the
+ * payload is identical to the text path's.
+ */
+namespace row_mapping {
+
+namespace detail {
+
+inline std::string_view text(const pqxx::field& f) {
+    return f.is_null() ? std::string_view() : std::string_view(f.c_str(), f.size());
+}
+
+} // namespace detail
+
+/// A NUMERIC column as Money, parsed from its text. Throws pqxx::conversion_error on NULL or non-numbers.
+inline Money money(const pqxx::field& f) {
+    Money m;
+    if (f.is_null() || !Money::parse(detail::text(f), m)) {
+        throw pqxx::conversion_error("Not a money amount: '" + std::string(detail::text(f)) + "'");
+    }
+    return m;
+}
+
+namespace detail {
+
+inline void read(const pqxx::field& f, int& out) { out = f.as<int>(); }
+inline void read(const pqxx::field& f, int64_t& out) { out = f.as<int64_t>(); }
+inline void read(const pqxx::field& f, double& out) { out = f.as<double>(); }
+inline void read(const pqxx::field& f, Money& out) { out = money(f); }
+inline void read(const pqxx::field& f, std::string& out) { out = text(f); }
+template <typename T>
+void read(const pqxx::field&, std::vector<T>&) {}  // NO_COLUMN members, filled by the caller
+
+inline void read(const pg_binary::Field& f, int& out) { out = pg_binary::int4(f); }
+inline void read(const pg_binary::Field& f, int64_t& out) { out = pg_binary::int8(f); }
+inline void read(const pg_binary::Field& f, Money& out) { out = pg_binary::numeric(f); }
+inline void read(const pg_binary::Field& f, std::string& out) {
+    char buf[pg_binary::TIMESTAMP_CHARS];
+    out = pg_binary::text(f, buf);
+}
+template <typename T>
+void read(const pg_binary::Field&, std::vector<T>&) {}
+
+template <typename W>
+void write_field(W& w, const pqxx::field& f, int*) { w.integer(f.as<int>()); }
+template <typename W>
+void write_field(W& w, const pqxx::field& f, int64_t*) { w.integer(f.as<int64_t>()); }
+template <typename W>
+void write_field(W& w, const pqxx::field& f, double*) { w.number(f.as<double>()); }
+template <typename W>
+void write_field(W& w, const pqxx::field& f, Money*) { w.money(money(f)); }
+template <typename W>
+void write_field(W& w, const pqxx::field& f, std::string*) { w.string(text(f)); }
+
+template <typename W>
+void write_field(W& w, const pg_binary::Field& f, int*) { w.integer(pg_binary::int4(f)); }
+template <typename W>
+void write_field(W& w, const pg_binary::Field& f, int64_t*) { w.integer(pg_binary::int8(f)); }
+template <typename W>
+void write_field(W& w, const pg_binary::Field& f, Money*) { w.money(pg_binary::numeric(f)); }
+template <typename W>
+void write_field(W& w, const pg_binary::Field& f, std::string*) {
+    char buf[pg_binary::TIMESTAMP_CHARS];
+    w.string(pg_binary::text(f, buf));
+}
+
+} // namespace detail
+
+/// A T from `row` (pqxx::row or pg_binary::Row), member by member from its descriptor columns.
+template <typename T, typename Row>
+T decode(const Row& row) {
+    T obj{};
+    std::apply([&](const auto&... f) {
+        ((f.column != schema::NO_COLUMN ? detail::read(row[f.column], obj.*(f.member)) : void()), ...);
+    }, schema::Fields<T>::list);
+    return obj;
+}
+
+/// The payload object for `row` without building a T. Every field needs a column.
+template <typename T, typename W, typename Row>
+void write_row(W& w, const Row& row) {
+    w.begin_object(schema::field_count<T>());
+    std::apply([&](const auto&... f) {
+        ((w.key(f.key), detail::write_field(w, row[f.column], static_cast<typename std::decay_t<decltype(f)>::type*>(nullptr))), ...);
+    }, schema::Fields<T>::list);
+    w.end_object();
+}
+
+/// All rows of `r` (pqxx::result or pg_binary::Result) as an array of T payloads.
+template <typename T, typename W, typename Result>
+void write_rows(W& w, const Result& r) {
+    w.begin_array(r.size());
+    for (const auto& row : r) write_row<T>(w, row);
+    w.end_array();
+}
+
+} // namespace row_mapping
@@ -0,0 +1,182 @@
+#include "statements.h"
+#include <atomic>
+#include <stdexcept>
+
+namespace db_statements {
+
+namespace {
+
+const Statement STATEMENTS[] = {
+    // Products
+    {"products_all",
+     "SELECT p.id, p.category_id, p.name, p.description, p.price, p.image_url, p.stock, "
+     "c.name as cat_name, p.created_at FROM products p "
+     "LEFT JOIN categories c ON p.category_id = c.id "
+     "ORDER BY p.id"},
+    {"product_by_id",
+     "SELECT p.id, p.category_id, p.name, p.description, p.price, p.image_url, p.stock, "
+     "c.name as cat_name, p.created_at FROM products p "
+     "LEFT JOIN categories c ON p.category_id = c.id "
+     "WHERE p.id = $1"},
+    {"products_by_category",
+     "SELECT p.id, p.category_id, p.name, p.description, p.price, p.image_url, p.stock, "
+     "c.name as cat_name, p.created_at FROM products p "
+     "LEFT JOIN categories c ON p.category_id = c.id "
+     "WHERE LOWER(c.name) = LOWER($1) ORDER BY p.id"},
+    {"products_search",
+     "SELECT p.id, p.category_id, p.name, p.description, p.price, p.image_url, p.stock, "
+     "c.name as cat_name, p.created_at FROM products p "
+     "LEFT JOIN categories c ON p.category_id = c.id "
+     "WHERE p.name ILIKE $1 OR p.description ILIKE $1 ORDER BY p.id"},
+    {"product_sales",
+     "SELECT product_id, SUM(quantity)::bigint FROM order_items GROUP BY product_id"},
+    {"categories_all",
+     "SELECT id, name FROM categories ORDER BY id"},
+
+    // Cart
+    {"cart_by_user",
+     "SELECT ci.id, ci.user_id, ci.product_id, ci.quantity, p.name, p.price, p.image_url "
+     "FROM cart_items ci JOIN products p ON ci.product_id = p.id "
+     "WHERE ci.user_id = $1"},
+    {"cart_add",
+     "INSERT INTO cart_items (user_id, product_id, quantity) "
+     "VALUES ($1, $2, $3) "
+     "ON CONFLICT (user_id, product_id) DO UPDATE SET quantity = cart_items.quantity + EXCLUDED.quantity"},
+    {"cart_remove",
+     "DELETE FROM cart_items WHERE user_id = $1 AND product_id = $2"},
+    {"cart_update_quantity",
+     "UPDATE cart_items SET quantity = $1 "
+     "WHERE user_id = $2 AND product_id = $3"},
+    {"cart_clear",
+     "DELETE FROM cart_items WHERE user_id = $1"},
+
+    // Auth
+    {"user_insert",
+     "INSERT INTO users (email, password_hash, name) VALUES ($1, $2, $3) "
+     "RETURNING id, email, name, created_at"},
+    {"user_login",
+     "SELECT id, email, name, created_at FROM users "
+     "WHERE email = $1 AND password_hash = $2"},
+
+    // Orders
+    // Without the stock ledger: locks the row, so two orders cannot both pass the check.
+    {"order_product_stock",
+     "SELECT price, stock FROM products WHERE id = $1 FOR UPDATE"},
+    {"order_insert",
+     "INSERT INTO orders (user_id, total, status) VALUES ($1, $2, 'pending') "
+     "RETURNING id, created_at"},
+    {"order_product_price",
+     "SELECT price, name FROM products WHERE id = $1"},
+    {"order_item_insert",
+     "INSERT INTO order_items (order_id, product_id, quantity, price_at_purchase) "
+     "VALUES ($1, $2, $3, $4)"},
+    {"product_stock_decrement",
+     "UPDATE products SET stock = stock - $1 WHERE id = $2 AND stock >= $1 RETURNING stock"},
+
+    // Stock ledger (server/stock_committer.h): items are inserted pending and
+    // applied to products.stock in batches, one row update per product.
+    // Stock never goes below zero: a shortfall (another process selling the
+    // same stock) is clamped and returned as the last column.
+    {"order_item_insert_pending",
+     "INSERT INTO order_items (order_id, product_id, quantity, price_at_purchase, stock_applied) "
+     "VALUES ($1, $2, $3, $4, false)", Feature::StockLedger},
+    {"stock_apply_pending",
+     "WITH applied AS ("
+     "UPDATE order_items SET stock_applied = true WHERE NOT stock_applied "
+     "RETURNING product_id, quantity), "
+     "totals AS (SELECT product_id, SUM(quantity)::int AS qty FROM applied GROUP BY product_id), "
+     "before AS (SELECT id, stock FROM products WHERE id IN (SELECT product_id FROM totals) FOR UPDATE) "
+     "UPDATE products p SET stock = GREATEST(b.stock - t.qty, 0) FROM totals t JOIN before b ON b.id = t.product_id "
+     "WHERE p.id = t.product_id "
+     "RETURNING p.id, t.qty, p.stock, GREATEST(t.qty - b.stock, 0)", Feature::StockLedger},
+    {"stock_all",
+     "SELECT p.id, p.stock, COALESCE(SUM(oi.quantity), 0)::int FROM products p "
+     "LEFT JOIN order_items oi ON oi.product_id = p.id AND NOT oi.stock_applied "
+     "GROUP BY p.id", Feature::StockLedger},
+    {"stock_by_product",
+     "SELECT p.stock, COALESCE(SUM(oi.quantity), 0)::int FROM products p "
+     "LEFT JOIN order_items oi ON oi.product_id = p.id AND NOT oi.stock_applied "
+     "WHERE p.id = $1 GROUP BY p.id", Feature::StockLedger},
+    // Async order pipeline (server/order_queue.h): one statement per step for a
+    // whole batch, arrays passed as literals ("{1,2,3}").
+    {"order_prices_batch",
+     "SELECT id, price FROM products WHERE id = ANY($1::int[])"},
+    {"orders_insert_batch",
+     "INSERT INTO orders (user_id, total, status, token) "
+     "SELECT u, t, 'pending', k FROM unnest($1::int[], $2::numeric[], $3::text[]) AS b(u, t, k) "
+     "RETURNING id, token", Feature::OrderQueue},
+    {"order_items_insert_batch",
+     "INSERT INTO order_items (order_id, product_id, quantity, price_at_purchase, stock_applied) "
+     "SELECT o, p, q, pr, false FROM unnest($1::int[], $2::int[], $3::int[], $4::numeric[]) AS b(o, p, q, pr)",
+     Feature::OrderQueue},
+    {"carts_clear_batch",
+     "DELETE FROM cart_items WHERE user_id = ANY($1::int[])"},
+    {"order_by_token",
+     "SELECT id, total FROM orders WHERE token = $1", Feature::OrderQueue},
+    {"order_exists",
+     "SELECT 1 FROM orders WHERE id = $1"},
+    {"orders_by_user",
+     "SELECT id, user_id, total, status, created_at FROM orders "
+     "WHERE user_id = $1 ORDER BY created_at DESC"},
+    {"order_items_by_order",
+     "SELECT oi.product_id, p.name, oi.quantity, oi.price_at_purchase "
+     "FROM order_items oi JOIN products p ON oi.product_id = p.id "
+     "WHERE oi.order_id = $1"},
+
+    // Request deadlines (server/deadline.cpp)
+    {"set_deadline",
+     "SELECT set_config('statement_timeout', $1, true), set_config('lock_timeout', $1, true)"},
+};
+
+std::atomic<unsigned> g_enabled{0};  // bit per Feature
+
+unsigned bit(Feature f) {
+    return f == Feature::Core ? 0u : 1u << static_cast<unsigned>(f);
+}
+
+const char* migration(Feature f) {
+    switch (f) {
+        case Feature::StockLedger: return "database/migrations/002_order_items_stock_applied.sql";
+        case Feature::OrderQueue: return "database/migrations/003_orders_token.sql";
+        default: return "";
+    }
+}
+
+} // namespace
+
+void enable(Feature feature) {
+    g_enabled.fetch_or(bit(feature));
+}
+
+bool enabled(Feature feature) {
+    return feature == Feature::Core || (g_enabled.load() & bit(feature)) != 0;
+}
+
+const Statement* all(size_t& count) {
+    count = sizeof(STATEMENTS) / sizeof(STATEMENTS[0]);
+    return STATEMENTS;
+}
+
+void prepare_all(pqxx::connection& conn) {
+    for (const auto& s : STATEMENTS) {
+        if (!enabled(s.feature)) continue;
+        if (s.feature == Feature::Core) {
+            conn.prepare(s.name, s.sql);
+            continue;
+        }
+        try {
+            conn.prepare(s.name, s.sql);
+        } catch (const pqxx::sql_error& e) {
+            throw std::runtime_error(std::string("statement ") + s.name + ": " + e.what() + " (does the database have " +
+                                     migration(s.feature) + "?)");
+        }
+    }
+}
+
+void prepare_all_binary(pg_binary::Connection& conn) {
+    for (const auto& s : STATEMENTS) {
+        if (enabled(s.feature)) conn.prepare(s.name, s.sql);
+    }
+}
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "pg_binary.h"
+#include <pqxx/pqxx>
+#include <cstddef>
+#include <string>
+
+/// Named SQL statements used by the app routes. Prepared on every app_user
+/// connection when the pool opens or reconnects it, so requests skip parsing
+/// and planning: routes call txn.exec_prepared("<name>", args...).
+namespace db_statements {
+
+/// Optional features whose statements need a schema migration. Their
+/// statements are only prepared once the feature is enabled, so a database
+/// without the migration still serves everything else.
+enum class Feature : unsigned {
+    Core = 0,
+    StockLedger = 1,  // database/migrations/002_order_items_stock_applied.sql
+    OrderQueue = 2,   // database/migrations/003_orders_token.sql (and 002)
+};
+
+struct Statement {
+    const char* name;
+    const char* sql;
+    Feature feature = Feature::Core;
+};
+
+const Statement* all(size_t& count);
+
+/// Prepare `feature`'s statements from now on; call before Database::prepareStatements().
+void enable(Feature feature);
+bool enabled(Feature feature);
+
+/// Prepare every enabled statement on `conn`. Throws on the first SQL error,
+/// naming the migration a feature statement needs.
+void prepare_all(pqxx::connection& conn);
+/// Same on a binary-results connection.
+void prepare_all_binary(pg_binary::Connection& conn);
+
+}
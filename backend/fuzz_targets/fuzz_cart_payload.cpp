@@ -1,27 +1,42 @@
 /**
- * Fuzz target: internal cart payload parsing (JSON body as in cart routes).
- * Fuzzes crow::json::load and cart-like field access - not HTTP endpoints.
+ * Fuzz target: cart payload parsing, as done by the cart routes.
+ * Fuzzes server::parse_cart_payload (schema-specific, no DOM) and, when it
+ * accepts a body, checks crow::json::load reads the same integers from it.
  * Build: -fsanitize=fuzzer,address,undefined
  */
 
 #include "crow/json.h"
+#include "server/body_parser.h"
 #include <cstdint>
 #include <cstdlib>
+#include <optional>
+#include <string_view>
+
+namespace {
+
+void check_same(const crow::json::rvalue& body, const char* key, const std::optional<int>& ours) {
+    if (!ours) return;
+    if (!body.has(key) || body[key].t() != crow::json::type::Number || body[key].i() != *ours) std::abort();
+}
+
+} // namespace
 
 extern "C" int LLVMFuzzerTestOneInput(const uint8_t* Data, size_t Size) {
-    if (Size == 0) return 0;
-    auto body = crow::json::load(reinterpret_cast<const char*>(Data), Size);
+    std::string_view input(reinterpret_cast<const char*>(Data), Size);
+    server::CartPayload payload;
+    if (!server::parse_cart_payload(input, payload).empty()) return 0;
+
+    // Keys are matched unescaped, so only compare bodies without escapes.
+    if (input.find('\\') != std::string_view::npos) return 0;
+    auto body = crow::json::load(input.data(), input.size());
     if (!body || body.t() != crow::json::type::Object) return 0;
     try {
-        if (!body["user_id"]) return 0;
-        if (!body["product_id"]) return 0;
-        int userId = body["user_id"].i();
-        int productId = body["product_id"].i();
-        int quantity = body["quantity"] ? static_cast<int>(body["quantity"].i()) : 1;
-        (void)userId;
-        (void)productId;
-        (void)quantity;
-    } catch (...) {}
+        check_same(body, "user_id", payload.user_id);
+        check_same(body, "product_id", payload.product_id);
+        check_same(body, "quantity", payload.quantity);
+    } catch (...) {
+        std::abort();
+    }
     return 0;
 }
 
@@ -0,0 +1,40 @@
+/**
+ * Fuzz target: order payload parsing, as done by POST /api/orders/create.
+ * Fuzzes server::parse_order_payload (schema-specific, no DOM) and checks
+ * two invariants of an accepted body: items only come from an "items" key,
+ * and there are no more of them than the body has room for.
+ * Build: -fsanitize=fuzzer,address,undefined
+ */
+
+#include "server/body_parser.h"
+#include <cstdint>
+#include <cstdlib>
+#include <string_view>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* Data, size_t Size) {
+    std::string_view input(reinterpret_cast<const char*>(Data), Size);
+    server::OrderPayload payload;
+    std::string error = server::parse_order_payload(input, payload);
+    if (!error.empty()) return 0;
+    if (!payload.has_items && !payload.items.empty()) std::abort();
+    constexpr size_t MIN_ITEM = sizeof("{\"product_id\":0,\"quantity\":0}") - 1;
+    if (payload.items.size() > Size / MIN_ITEM) std::abort();
+    return 0;
+}
+
+#ifndef FUZZING_BUILD_MODE
+#include <fstream>
+#include <iostream>
+#include <vector>
+int main(int argc, char** argv) {
+    std::string path = argc >= 2 ? argv[1] : "default_corpus.txt";
+    std::ifstream f(path, std::ios::binary);
+    if (!f) { std::cerr << "Open failed: " << path << "\n"; return 1; }
+    f.seekg(0, std::ios::end);
+    size_t len = static_cast<size_t>(f.tellg());
+    f.seekg(0);
+    std::vector<uint8_t> buf(len);
+    f.read(reinterpret_cast<char*>(buf.data()), len);
+    return LLVMFuzzerTestOneInput(buf.data(), buf.size());
+}
+#endif
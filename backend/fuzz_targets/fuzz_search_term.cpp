@@ -1,53 +1,53 @@
 /**
- * Fuzz target: internal search term processing (no HTTP).
- * Fuzzes length limit, trim, and "%term%" pattern building.
+ * Fuzz target: search term normalization, as done by /api/products/search
+ * before the query and the search cache (no HTTP).
+ * Fuzzes server::normalize_search_term and checks what the cache key relies
+ * on: bounded length, no control characters, no edge blanks, no upper-case
+ * ASCII, valid UTF-8 stays valid (the length cut never splits a sequence),
+ * and idempotence.
  * Build: -fsanitize=fuzzer,address,undefined
  */
 
+#include "server/search_term.h"
 #include <cstdint>
 #include <cstdlib>
 #include <string>
-#include <algorithm>
-#include <cctype>
+#include <string_view>
 
 namespace {
 
-constexpr size_t MAX_SEARCH_TERM_LEN = 500;
-
-std::string process_search_term(const std::string& raw) {
-    std::string term = raw;
-    if (term.size() > MAX_SEARCH_TERM_LEN)
-        term.resize(MAX_SEARCH_TERM_LEN);
-    return "%" + term + "%";
+// Lead bytes followed by the right number of continuation bytes (overlongs not checked).
+bool valid_utf8(std::string_view s) {
+    for (size_t i = 0; i < s.size();) {
+        auto b = static_cast<unsigned char>(s[i]);
+        size_t n = b < 0x80 ? 1 : (b & 0xE0) == 0xC0 ? 2 : (b & 0xF0) == 0xE0 ? 3 : (b & 0xF8) == 0xF0 ? 4 : 0;
+        if (n == 0 || i + n > s.size()) return false;
+        for (size_t j = 1; j < n; j++) {
+            if ((static_cast<unsigned char>(s[i + j]) & 0xC0) != 0x80) return false;
+        }
+        i += n;
+    }
+    return true;
 }
 
-void trim_leading_trailing(std::string& s) {
-    while (!s.empty() && s.back() == ' ') s.pop_back();
-    size_t i = 0;
-    while (i < s.size() && s[i] == ' ') ++i;
-    s.erase(0, i);
-}
-
-void strip_control_chars(std::string& s) {
-    for (size_t i = 0; i < s.size(); ) {
-        unsigned char u = static_cast<unsigned char>(s[i]);
-        if (u < 32 && u != '\t')
-            s.erase(i, 1);
-        else
-            ++i;
-    }
+bool blank(char c) {
+    return c == ' ' || c == '\t';
 }
 
 } // namespace
 
 extern "C" int LLVMFuzzerTestOneInput(const uint8_t* Data, size_t Size) {
-    if (Size == 0) return 0;
-    std::string input(reinterpret_cast<const char*>(Data), Size);
-    (void)process_search_term(input);
-    trim_leading_trailing(input);
-    if (input.size() > MAX_SEARCH_TERM_LEN) input.resize(MAX_SEARCH_TERM_LEN);
-    (void)("%" + input + "%");
-    strip_control_chars(input);
+    std::string_view input(reinterpret_cast<const char*>(Data), Size);
+    std::string term = server::normalize_search_term(input);
+
+    if (term.size() > server::MAX_SEARCH_TERM_BYTES) std::abort();
+    for (char c : term) {
+        auto u = static_cast<unsigned char>(c);
+        if ((u < 32 && c != '\t') || u == 127 || (c >= 'A' && c <= 'Z')) std::abort();
+    }
+    if (!term.empty() && (blank(term.front()) || blank(term.back()))) std::abort();
+    if (valid_utf8(input) && !valid_utf8(term)) std::abort();
+    if (server::normalize_search_term(term) != term) std::abort();
     return 0;
 }
 
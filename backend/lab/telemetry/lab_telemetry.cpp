@@ -20,6 +20,8 @@ namespace {
 
 std::string g_log_path = "logs/lab.log";
 std::mutex g_log_mutex;
+std::ofstream g_out;  // opened on first write, kept open
+std::chrono::steady_clock::time_point g_last_flush;
 
 std::string current_timestamp() {
     auto now = std::chrono::system_clock::now();
@@ -49,23 +51,36 @@ void ensure_log_dir() {
 
 void set_log_path(const std::string& path) {
     std::lock_guard<std::mutex> lock(g_log_mutex);
+    if (g_out.is_open()) g_out.close();
     g_log_path = path;
 }
 
+void flush() {
+    std::lock_guard<std::mutex> lock(g_log_mutex);
+    if (g_out.is_open()) g_out.flush();
+}
+
 void log_request(const std::string& endpoint,
                  const std::string& params_redacted,
                  const std::string& injection_pattern,
                  int response_code) {
     std::lock_guard<std::mutex> lock(g_log_mutex);
-    ensure_log_dir();
-    std::ofstream out(g_log_path, std::ios::app);
-    if (!out) return;
-    out << current_timestamp()
+    if (!g_out.is_open()) {
+        ensure_log_dir();
+        g_out.open(g_log_path, std::ios::app);
+    }
+    if (!g_out) return;
+    g_out << current_timestamp()
         << " endpoint=" << endpoint
         << " params=" << (params_redacted.empty() ? "(none)" : params_redacted)
         << " injection=" << injection_pattern
         << " response=" << response_code
         << "\n";
+    auto now = std::chrono::steady_clock::now();
+    if (now - g_last_flush >= std::chrono::seconds(1)) {
+        g_out.flush();
+        g_last_flush = now;
+    }
 }
 
 } // namespace telemetry
@@ -16,5 +16,9 @@ void log_request(const std::string& endpoint,
 /// Optional: set log file path (default: "logs/lab.log" relative to cwd).
 void set_log_path(const std::string& path);
 
+/// Write buffered entries to disk. Entries are flushed at most once a second
+/// while serving; call this on shutdown so the tail is not lost.
+void flush();
+
 } // namespace telemetry
 } // namespace lab
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tcp_lab {
+
+/// LEN is a 2-byte big-endian field, so a frame body can never exceed this.
+constexpr uint32_t MAX_DATA_LEN = 65535;
+
+enum class FrameState { NeedMore, Complete, Error };
+
+/**
+ * Incremental parser for one LEN(2)+DATA frame. Shared by every TCP lab
+ * backend (blocking, epoll, io_uring) so they accept exactly the same input
+ * regardless of how the bytes were split across recv() calls.
+ * DATA is only counted, never copied: the service acknowledges frames, it does
+ * not inspect them.
+ */
+class FrameParser {
+public:
+    /// Consume up to n bytes. Returns the number of bytes used; bytes after a
+    /// complete frame are left for the caller (the service ignores them).
+    size_t feed(const unsigned char* data, size_t n) {
+        size_t used = 0;
+        while (used < n && state_ == FrameState::NeedMore) {
+            if (header_read_ < 2) {
+                header_[header_read_++] = data[used++];
+                if (header_read_ == 2) {
+                    data_len_ = (static_cast<uint32_t>(header_[0]) << 8) | header_[1];
+                    if (data_len_ > MAX_DATA_LEN) state_ = FrameState::Error;
+                    else if (data_len_ == 0) state_ = FrameState::Complete;
+                }
+                continue;
+            }
+            size_t want = data_len_ - data_read_;
+            size_t take = (n - used) < want ? (n - used) : want;
+            data_read_ += static_cast<uint32_t>(take);
+            used += take;
+            if (data_read_ == data_len_) state_ = FrameState::Complete;
+        }
+        return used;
+    }
+
+    /// Peer closed or recv failed before the frame was complete.
+    void fail() {
+        if (state_ == FrameState::NeedMore) state_ = FrameState::Error;
+    }
+
+    FrameState state() const { return state_; }
+    bool done() const { return state_ != FrameState::NeedMore; }
+    uint32_t data_len() const { return data_len_; }
+
+    void reset() { *this = FrameParser(); }
+
+private:
+    FrameState state_ = FrameState::NeedMore;
+    unsigned char header_[2] = {0, 0};
+    uint32_t header_read_ = 0;
+    uint32_t data_len_ = 0;
+    uint32_t data_read_ = 0;
+};
+
+/// Reply bytes for a finished frame: "OK" on success, "ERR" otherwise.
+inline const char* reply_for(FrameState s) { return s == FrameState::Complete ? "OK" : "ERR"; }
+inline size_t reply_len(FrameState s) { return s == FrameState::Complete ? 2 : 3; }
+
+} // namespace tcp_lab
@@ -2,11 +2,16 @@
  * TCP lab service (NOT HTTP). Only started when ENABLE_LABS=ON and LAB_MODE=true.
  * Listens on 127.0.0.1:9001 only.
  * Protocol: client sends LEN(2 bytes, big-endian) + DATA; server responds "OK" or "ERR".
+ * Backends: blocking accept loop (default), epoll (Linux), io_uring (tcp_lab_uring.cpp).
  */
 
 #include "tcp_lab_server.h"
+#include "tcp_lab_frame.h"
+#include <cerrno>
 #include <cstring>
+#include <cstdlib>
 #include <iostream>
+#include <unordered_map>
 #include <vector>
 #include <cstdint>
 
@@ -16,16 +21,18 @@
 #pragma comment(lib, "ws2_32.lib")
 #else
 #include <arpa/inet.h>
+#include <fcntl.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <unistd.h>
+#include "tcp_lab_uring.h"
 #endif
 
-namespace {
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
 
-const char* BIND_HOST = "127.0.0.1";
-const int BIND_PORT = 9001;
-constexpr uint32_t MAX_DATA_LEN = 65535;
+namespace {
 
 #ifdef _WIN32
 using sock_t = SOCKET;
@@ -35,49 +42,127 @@ using sock_t = int;
 inline int close_sock(sock_t s) { return close(s); }
 #endif
 
-void handle_client(sock_t fd) {
-    unsigned char len_buf[2];
-    int n = recv(fd, reinterpret_cast<char*>(len_buf), 2, 0);
-    if (n != 2) {
-        send(fd, "ERR", 3, 0);
-        return;
-    }
-    uint32_t data_len = (static_cast<uint32_t>(len_buf[0]) << 8) | len_buf[1];
-    if (data_len > MAX_DATA_LEN) {
-        send(fd, "ERR", 3, 0);
-        return;
-    }
-    std::vector<char> data(data_len);
-    size_t total = 0;
-    while (total < data_len) {
-        n = recv(fd, data.data() + total, static_cast<int>(data_len - total), 0);
+constexpr size_t RECV_CHUNK = 4096;
+
+void handle_client(sock_t fd, TcpLabStats& stats) {
+    tcp_lab::FrameParser parser;
+    unsigned char buf[RECV_CHUNK];
+    while (!parser.done()) {
+        int n = recv(fd, reinterpret_cast<char*>(buf), static_cast<int>(sizeof(buf)), 0);
+        stats.syscalls++;
         if (n <= 0) {
-            send(fd, "ERR", 3, 0);
-            return;
+            parser.fail();
+            break;
         }
-        total += static_cast<size_t>(n);
+        parser.feed(buf, static_cast<size_t>(n));
     }
-    send(fd, "OK", 2, 0);
+    send(fd, tcp_lab::reply_for(parser.state()), static_cast<int>(tcp_lab::reply_len(parser.state())), 0);
+    stats.syscalls++;
+    if (parser.state() == tcp_lab::FrameState::Complete) stats.frames_ok++;
+    else stats.frames_err++;
 }
 
-void server_loop(sock_t listen_fd) {
+void server_loop(sock_t listen_fd, TcpLabStats& stats) {
     for (;;) {
         struct sockaddr_in client_addr = {};
         socklen_t len = sizeof(client_addr);
         sock_t client = accept(listen_fd, reinterpret_cast<struct sockaddr*>(&client_addr), &len);
+        stats.syscalls++;
         if (client == (sock_t)-1
 #ifdef _WIN32
             || client == INVALID_SOCKET
 #endif
         ) continue;
-        handle_client(client);
+        handle_client(client, stats);
         close_sock(client);
+        stats.syscalls++;
     }
 }
 
+#ifdef __linux__
+// Level-triggered epoll loop: one FrameParser per connection, reply + close once done.
+bool epoll_server_loop(sock_t listen_fd, TcpLabStats& stats) {
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    if (ep < 0) return false;
+
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = listen_fd;
+    if (epoll_ctl(ep, EPOLL_CTL_ADD, listen_fd, &ev) < 0) {
+        close(ep);
+        return false;
+    }
+    fcntl(listen_fd, F_SETFL, fcntl(listen_fd, F_GETFL, 0) | O_NONBLOCK);
+
+    std::unordered_map<int, tcp_lab::FrameParser> conns;
+    std::vector<struct epoll_event> events(256);
+    unsigned char buf[RECV_CHUNK];
+
+    auto finish = [&](int fd, tcp_lab::FrameParser& parser) {
+        send(fd, tcp_lab::reply_for(parser.state()), tcp_lab::reply_len(parser.state()), MSG_NOSIGNAL);
+        close(fd);  // also removes fd from the epoll set
+        stats.syscalls += 2;
+        if (parser.state() == tcp_lab::FrameState::Complete) stats.frames_ok++;
+        else stats.frames_err++;
+        conns.erase(fd);
+    };
+
+    for (;;) {
+        int n = epoll_wait(ep, events.data(), static_cast<int>(events.size()), -1);
+        stats.syscalls++;
+        if (n < 0) continue;
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            if (fd == listen_fd) {
+                for (;;) {
+                    int client = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    stats.syscalls++;
+                    if (client < 0) break;
+                    struct epoll_event cev = {};
+                    cev.events = EPOLLIN | EPOLLRDHUP;
+                    cev.data.fd = client;
+                    epoll_ctl(ep, EPOLL_CTL_ADD, client, &cev);
+                    stats.syscalls++;
+                    conns.emplace(client, tcp_lab::FrameParser());
+                }
+                continue;
+            }
+            auto it = conns.find(fd);
+            if (it == conns.end()) continue;
+            ssize_t r = recv(fd, buf, sizeof(buf), 0);
+            stats.syscalls++;
+            if (r > 0) it->second.feed(buf, static_cast<size_t>(r));
+            else if (r == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) it->second.fail();
+            if (it->second.done()) finish(fd, it->second);
+        }
+    }
+}
+#endif
+
 } // namespace
 
+TcpLabBackend parse_tcp_lab_backend(const std::string& name) {
+    if (name == "epoll") return TcpLabBackend::Epoll;
+    if (name == "io_uring" || name == "uring") return TcpLabBackend::IoUring;
+    return TcpLabBackend::Blocking;
+}
+
+const char* tcp_lab_backend_name(TcpLabBackend backend) {
+    switch (backend) {
+        case TcpLabBackend::Epoll: return "epoll";
+        case TcpLabBackend::IoUring: return "io_uring";
+        default: return "blocking";
+    }
+}
+
 void run_tcp_lab_server() {
+    TcpLabOptions options;
+    const char* backendEnv = std::getenv("TCP_LAB_BACKEND");
+    if (backendEnv) options.backend = parse_tcp_lab_backend(backendEnv);
+    run_tcp_lab_server(options);
+}
+
+void run_tcp_lab_server(const TcpLabOptions& options) {
 #ifdef _WIN32
     WSADATA wsa;
     if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
@@ -86,6 +171,9 @@ void run_tcp_lab_server() {
     }
 #endif
 
+    TcpLabStats local_stats;
+    TcpLabStats& stats = options.stats ? *options.stats : local_stats;
+
     sock_t sock = socket(AF_INET, SOCK_STREAM, 0);
     if (sock == (sock_t)-1
 #ifdef _WIN32
@@ -105,26 +193,51 @@ void run_tcp_lab_server() {
 
     struct sockaddr_in addr = {};
     addr.sin_family = AF_INET;
-    addr.sin_port = htons(static_cast<uint16_t>(BIND_PORT));
-    if (inet_pton(AF_INET, BIND_HOST, &addr.sin_addr) <= 0) {
+    addr.sin_port = htons(static_cast<uint16_t>(options.port));
+    if (inet_pton(AF_INET, options.host.c_str(), &addr.sin_addr) <= 0) {
         std::cerr << "TCP lab server: inet_pton failed\n";
         close_sock(sock);
         return;
     }
 
     if (bind(sock, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
-        std::cerr << "TCP lab server: bind 127.0.0.1:" << BIND_PORT << " failed\n";
+        std::cerr << "TCP lab server: bind " << options.host << ":" << options.port << " failed\n";
         close_sock(sock);
         return;
     }
-    if (listen(sock, 5) < 0) {
+    if (listen(sock, SOMAXCONN) < 0) {
         std::cerr << "TCP lab server: listen failed\n";
         close_sock(sock);
         return;
     }
 
-    std::cout << "TCP lab service listening on 127.0.0.1:" << BIND_PORT << " (LEN(2)+DATA -> OK/ERR)\n";
-    server_loop(sock);
+    TcpLabBackend backend = options.backend;
+    std::cout << "TCP lab service listening on " << options.host << ":" << options.port
+              << " (LEN(2)+DATA -> OK/ERR, backend=" << tcp_lab_backend_name(backend) << ")\n";
+
+#ifndef _WIN32
+    if (backend == TcpLabBackend::IoUring) {
+        stats.running = TcpLabBackend::IoUring;
+        if (run_tcp_lab_uring_loop(sock, stats)) {
+            close_sock(sock);
+            return;
+        }
+        std::cerr << "TCP lab server: io_uring unavailable, falling back to epoll\n";
+        backend = TcpLabBackend::Epoll;
+    }
+#endif
+#ifdef __linux__
+    if (backend == TcpLabBackend::Epoll) {
+        stats.running = TcpLabBackend::Epoll;
+        if (epoll_server_loop(sock, stats)) {
+            close_sock(sock);
+            return;
+        }
+        std::cerr << "TCP lab server: epoll setup failed, falling back to blocking\n";
+    }
+#endif
+    stats.running = TcpLabBackend::Blocking;
+    server_loop(sock, stats);
     close_sock(sock);
 
 #ifdef _WIN32
@@ -1,6 +1,39 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/// I/O strategy for the TCP lab service. All backends share tcp_lab::FrameParser.
+enum class TcpLabBackend { Blocking, Epoll, IoUring };
+
+/// Parse "blocking" / "epoll" / "io_uring" (also "uring"). Unknown values map to Blocking.
+TcpLabBackend parse_tcp_lab_backend(const std::string& name);
+const char* tcp_lab_backend_name(TcpLabBackend backend);
+
+/// Counters updated by the server loop. `syscalls` counts socket/epoll calls made
+/// by the loop (for io_uring: io_uring_enter submissions), so syscalls/frame can be
+/// compared across backends.
+struct TcpLabStats {
+    std::atomic<uint64_t> frames_ok{0};
+    std::atomic<uint64_t> frames_err{0};
+    std::atomic<uint64_t> syscalls{0};
+    std::atomic<TcpLabBackend> running{TcpLabBackend::Blocking};  // after any fallback
+};
+
+struct TcpLabOptions {
+    std::string host = "127.0.0.1";
+    int port = 9001;
+    TcpLabBackend backend = TcpLabBackend::Blocking;
+    TcpLabStats* stats = nullptr;  // optional; the server keeps its own when null
+};
+
 /// Runs the TCP lab server (blocking). Listens on 127.0.0.1:9001 only.
 /// Protocol: client sends LEN(2 bytes, big-endian) + DATA; server responds "OK" or "ERR".
+/// Backend is taken from TCP_LAB_BACKEND (blocking | epoll | io_uring, default blocking).
 /// Call from a separate thread when ENABLE_LABS=ON and LAB_MODE=true.
 void run_tcp_lab_server();
+
+/// Same, with explicit options (used by bench/tcp_lab_bench). io_uring falls back to
+/// epoll when the kernel or build lacks support; epoll falls back to blocking off Linux.
+void run_tcp_lab_server(const TcpLabOptions& options);
@@ -0,0 +1,204 @@
+/**
+ * io_uring backend for the TCP lab service (Linux only, liburing >= 2.4).
+ * Same protocol and FrameParser as the blocking/epoll loops in tcp_lab_server.cpp:
+ * - one multishot accept SQE stays armed on the listening socket;
+ * - recv uses a provided-buffer ring (IOSQE_BUFFER_SELECT), so no buffer is
+ *   pinned per idle connection;
+ * - "OK"/"ERR" replies are written from a registered (fixed) buffer;
+ * - close is queued on the ring as well, so the only syscall per batch is
+ *   io_uring_enter.
+ */
+
+#include "tcp_lab_uring.h"
+
+#ifdef LALA_HAVE_LIBURING
+
+#include "tcp_lab_frame.h"
+#include <liburing.h>
+#include <cerrno>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr unsigned QUEUE_DEPTH = 512;
+constexpr unsigned BUF_COUNT = 256;   // must be a power of two for the buf ring
+constexpr unsigned BUF_SIZE = 4096;
+constexpr int BUF_GROUP = 1;
+
+enum class Op : uint32_t { Accept = 1, Recv, Send, Close };
+
+inline uint64_t pack(Op op, int fd) {
+    return (static_cast<uint64_t>(op) << 32) | static_cast<uint32_t>(fd);
+}
+inline Op op_of(uint64_t data) { return static_cast<Op>(data >> 32); }
+inline int fd_of(uint64_t data) { return static_cast<int>(data & 0xffffffffu); }
+
+// Reply bytes live in one registered buffer: "OK" at offset 0, "ERR" at offset 2.
+char g_replies[8] = {'O', 'K', 'E', 'R', 'R', 0, 0, 0};
+
+class UringLoop {
+public:
+    UringLoop(int listen_fd, TcpLabStats& stats) : listen_fd_(listen_fd), stats_(stats) {}
+
+    ~UringLoop() {
+        if (buf_ring_) io_uring_free_buf_ring(&ring_, buf_ring_, BUF_COUNT, BUF_GROUP);
+        if (ring_ready_) io_uring_queue_exit(&ring_);
+    }
+
+    bool init() {
+        if (io_uring_queue_init(QUEUE_DEPTH, &ring_, 0) < 0) return false;
+        ring_ready_ = true;
+
+        // Multishot accept and provided-buffer rings both arrived in 5.19, as did
+        // IORING_OP_SOCKET; use that opcode as the feature probe.
+        struct io_uring_probe* probe = io_uring_get_probe_ring(&ring_);
+        if (!probe) return false;
+        bool supported = io_uring_opcode_supported(probe, IORING_OP_SOCKET);
+        io_uring_free_probe(probe);
+        if (!supported) return false;
+
+        struct iovec iov = {g_replies, sizeof(g_replies)};
+        if (io_uring_register_buffers(&ring_, &iov, 1) < 0) return false;
+
+        int err = 0;
+        buf_ring_ = io_uring_setup_buf_ring(&ring_, BUF_COUNT, BUF_GROUP, 0, &err);
+        if (!buf_ring_) return false;
+        buffers_.resize(static_cast<size_t>(BUF_COUNT) * BUF_SIZE);
+        for (unsigned i = 0; i < BUF_COUNT; i++) {
+            io_uring_buf_ring_add(buf_ring_, buffer(i), BUF_SIZE, static_cast<unsigned short>(i),
+                                  io_uring_buf_ring_mask(BUF_COUNT), static_cast<int>(i));
+        }
+        io_uring_buf_ring_advance(buf_ring_, BUF_COUNT);
+        return true;
+    }
+
+    void run() {
+        arm_accept();
+        for (;;) {
+            io_uring_submit_and_wait(&ring_, 1);
+            stats_.syscalls++;
+            struct io_uring_cqe* cqe;
+            unsigned head;
+            unsigned seen = 0;
+            io_uring_for_each_cqe(&ring_, head, cqe) {
+                handle(cqe);
+                seen++;
+            }
+            io_uring_cq_advance(&ring_, seen);
+        }
+    }
+
+private:
+    char* buffer(unsigned bid) { return buffers_.data() + static_cast<size_t>(bid) * BUF_SIZE; }
+
+    struct io_uring_sqe* sqe() {
+        struct io_uring_sqe* s = io_uring_get_sqe(&ring_);
+        while (!s) {
+            io_uring_submit(&ring_);
+            stats_.syscalls++;
+            s = io_uring_get_sqe(&ring_);
+        }
+        return s;
+    }
+
+    void arm_accept() {
+        struct io_uring_sqe* s = sqe();
+        io_uring_prep_multishot_accept(s, listen_fd_, nullptr, nullptr, 0);
+        io_uring_sqe_set_data64(s, pack(Op::Accept, listen_fd_));
+    }
+
+    void arm_recv(int fd) {
+        struct io_uring_sqe* s = sqe();
+        io_uring_prep_recv(s, fd, nullptr, BUF_SIZE, 0);
+        s->flags |= IOSQE_BUFFER_SELECT;
+        s->buf_group = BUF_GROUP;
+        io_uring_sqe_set_data64(s, pack(Op::Recv, fd));
+    }
+
+    void reply_and_close(int fd, tcp_lab::FrameState state) {
+        unsigned offset = state == tcp_lab::FrameState::Complete ? 0 : 2;
+        struct io_uring_sqe* s = sqe();
+        io_uring_prep_write_fixed(s, fd, g_replies + offset,
+                                  static_cast<unsigned>(tcp_lab::reply_len(state)), 0, 0);
+        // Hard link: the close runs after the write even if the write failed.
+        s->flags |= IOSQE_IO_HARDLINK;
+        io_uring_sqe_set_data64(s, pack(Op::Send, fd));
+        struct io_uring_sqe* c = sqe();
+        io_uring_prep_close(c, fd);
+        io_uring_sqe_set_data64(c, pack(Op::Close, fd));
+
+        if (state == tcp_lab::FrameState::Complete) stats_.frames_ok++;
+        else stats_.frames_err++;
+        conns_.erase(fd);
+    }
+
+    void recycle(unsigned bid) {
+        io_uring_buf_ring_add(buf_ring_, buffer(bid), BUF_SIZE, static_cast<unsigned short>(bid),
+                              io_uring_buf_ring_mask(BUF_COUNT), 0);
+        io_uring_buf_ring_advance(buf_ring_, 1);
+    }
+
+    void handle(struct io_uring_cqe* cqe) {
+        uint64_t data = io_uring_cqe_get_data64(cqe);
+        int fd = fd_of(data);
+        switch (op_of(data)) {
+            case Op::Accept:
+                if (cqe->res >= 0) {
+                    conns_.emplace(cqe->res, tcp_lab::FrameParser());
+                    arm_recv(cqe->res);
+                }
+                if (!(cqe->flags & IORING_CQE_F_MORE)) arm_accept();
+                break;
+            case Op::Recv: {
+                auto it = conns_.find(fd);
+                if (it == conns_.end()) break;
+                if (cqe->res == -ENOBUFS) {
+                    // Every provided buffer is in flight; try again on the next batch.
+                    arm_recv(fd);
+                    break;
+                }
+                if (cqe->res > 0 && (cqe->flags & IORING_CQE_F_BUFFER)) {
+                    unsigned bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+                    it->second.feed(reinterpret_cast<unsigned char*>(buffer(bid)),
+                                    static_cast<size_t>(cqe->res));
+                    recycle(bid);
+                } else {
+                    it->second.fail();
+                }
+                if (it->second.done()) reply_and_close(fd, it->second.state());
+                else arm_recv(fd);
+                break;
+            }
+            case Op::Send:
+            case Op::Close:
+                break;
+        }
+    }
+
+    int listen_fd_;
+    TcpLabStats& stats_;
+    struct io_uring ring_ = {};
+    bool ring_ready_ = false;
+    struct io_uring_buf_ring* buf_ring_ = nullptr;
+    std::vector<char> buffers_;
+    std::unordered_map<int, tcp_lab::FrameParser> conns_;
+};
+
+} // namespace
+
+bool run_tcp_lab_uring_loop(int listen_fd, TcpLabStats& stats) {
+    UringLoop loop(listen_fd, stats);
+    if (!loop.init()) return false;
+    loop.run();
+    return true;
+}
+
+#else
+
+bool run_tcp_lab_uring_loop(int, TcpLabStats&) {
+    return false;
+}
+
+#endif
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "tcp_lab_server.h"
+
+/// Runs the io_uring accept/recv/send loop on an already-listening socket
+/// (multishot accept, provided-buffer ring for recv, registered reply buffers).
+/// Returns false without touching listen_fd when io_uring is unavailable: built
+/// without liburing, kernel < 5.19, or io_uring disabled (e.g. by seccomp/sysctl).
+bool run_tcp_lab_uring_loop(int listen_fd, TcpLabStats& stats);
@@ -0,0 +1,507 @@
+/**
+ * Native load generator and fuzz client for the TCP lab protocol (LEN(2) + DATA).
+ * Replaces boofuzz_tcp_lab.py when you need more than a few hundred cases/s.
+ *
+ * - Many concurrent non-blocking connections per thread (epoll, Linux only).
+ * - bench mode: valid frames only, reports throughput + latency histogram.
+ * - fuzz mode: valid, corpus-replayed, mutated, length-lying and raw frames;
+ *   stops and writes the last cases to crash-*.bin when the target goes away.
+ *
+ * Targets:
+ *   127.0.0.1:9001   lab service (LAB_MODE=true), replies OK / ERR
+ *   127.0.0.1:9999   lab_targets/tcp_lab_server.cpp (use --raw, replies "OK\n")
+ *
+ * Build: cmake -DBUILD_TCP_LAB_LOADGEN=ON .. && cmake --build . --target tcp_lab_loadgen
+ * Run:   ./tcp_lab_loadgen --port 9001 --connections 256 --duration 10
+ *        ./tcp_lab_loadgen --port 9999 --raw --mode fuzz --corpus ../fuzz_corpus
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Config {
+    std::string host = "127.0.0.1";
+    int port = 9001;
+    int threads = 4;
+    int connections = 64;        // total, split across threads
+    double duration_s = 10;
+    uint64_t max_cases = 0;      // 0 = until duration elapses
+    bool fuzz = false;
+    bool raw = false;            // send DATA without the LEN(2) header
+    size_t payload = 64;
+    std::string corpus_dir;
+    std::string crash_dir = ".";
+    int timeout_ms = 1000;
+    uint64_t seed = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Latency histogram: log2 buckets with 4 linear sub-buckets (<= 19% error).
+// ---------------------------------------------------------------------------
+
+constexpr size_t HIST_BUCKETS = 256;
+
+size_t bucket_of(uint64_t us) {
+    if (us < 8) return static_cast<size_t>(us);
+    int e = 63 - __builtin_clzll(us);
+    uint64_t sub = (us >> (e - 2)) & 3;
+    return std::min<size_t>(8 + static_cast<size_t>(e - 3) * 4 + sub, HIST_BUCKETS - 1);
+}
+
+uint64_t bucket_lower(size_t b) {
+    if (b < 8) return b;
+    size_t e = (b - 8) / 4 + 3;
+    uint64_t sub = (b - 8) % 4;
+    return (4 + sub) << (e - 2);
+}
+
+struct Histogram {
+    std::array<uint64_t, HIST_BUCKETS> counts{};
+    uint64_t total = 0;
+
+    void record(uint64_t us) {
+        counts[bucket_of(us)]++;
+        total++;
+    }
+    void merge(const Histogram& o) {
+        for (size_t i = 0; i < HIST_BUCKETS; i++) counts[i] += o.counts[i];
+        total += o.total;
+    }
+    uint64_t percentile(double p) const {
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(p * static_cast<double>(total - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < HIST_BUCKETS; i++) {
+            seen += counts[i];
+            if (seen >= rank) return bucket_lower(i);
+        }
+        return bucket_lower(HIST_BUCKETS - 1);
+    }
+};
+
+struct Counters {
+    uint64_t cases = 0;
+    uint64_t ok = 0;
+    uint64_t err = 0;
+    uint64_t other_reply = 0;
+    uint64_t reset = 0;
+    uint64_t timeout = 0;
+    uint64_t connect_fail = 0;
+
+    void merge(const Counters& o) {
+        cases += o.cases;
+        ok += o.ok;
+        err += o.err;
+        other_reply += o.other_reply;
+        reset += o.reset;
+        timeout += o.timeout;
+        connect_fail += o.connect_fail;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Case generation
+// ---------------------------------------------------------------------------
+
+std::vector<std::string> load_corpus(const std::string& dir) {
+    std::vector<std::string> out;
+    if (dir.empty()) return out;
+    std::error_code ec;
+    for (auto& entry : std::filesystem::recursive_directory_iterator(dir, ec)) {
+        if (!entry.is_regular_file()) continue;
+        std::ifstream f(entry.path(), std::ios::binary);
+        out.emplace_back(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+        if (out.back().size() > 65535) out.back().resize(65535);
+    }
+    return out;
+}
+
+class CaseGenerator {
+public:
+    CaseGenerator(const Config& cfg, const std::vector<std::string>& corpus, uint64_t seed)
+        : cfg_(cfg), corpus_(corpus), rng_(seed) {}
+
+    std::string next() {
+        if (!cfg_.fuzz) return frame(std::string(cfg_.payload, 'A'));
+        switch (pick(6)) {
+            case 0: return frame(random_bytes(pick(512)));
+            case 1: return corpus_.empty() ? frame(random_bytes(pick(64))) : frame(corpus_[pick(corpus_.size())]);
+            case 2: return frame(mutate(corpus_.empty() ? random_bytes(pick(64) + 1) : corpus_[pick(corpus_.size())]));
+            case 3: return length_lie();
+            case 4: return random_bytes(pick(128));
+            default: return boundary();
+        }
+    }
+
+private:
+    size_t pick(size_t n) { return n == 0 ? 0 : static_cast<size_t>(rng_() % n); }
+
+    std::string random_bytes(size_t n) {
+        std::string s(n, '\0');
+        for (auto& c : s) c = static_cast<char>(rng_());
+        return s;
+    }
+
+    std::string header(size_t len) const {
+        std::string h(2, '\0');
+        h[0] = static_cast<char>((len >> 8) & 0xff);
+        h[1] = static_cast<char>(len & 0xff);
+        return h;
+    }
+
+    std::string frame(const std::string& data) const {
+        if (cfg_.raw) return data;
+        return header(std::min<size_t>(data.size(), 65535)) + data.substr(0, 65535);
+    }
+
+    std::string mutate(std::string s) {
+        size_t rounds = 1 + pick(4);
+        for (size_t r = 0; r < rounds; r++) {
+            switch (pick(4)) {
+                case 0: if (!s.empty()) s[pick(s.size())] ^= static_cast<char>(1u << pick(8)); break;
+                case 1: s.insert(pick(s.size() + 1), random_bytes(1 + pick(16))); break;
+                case 2: if (!s.empty()) s.erase(pick(s.size()), 1 + pick(8)); break;
+                default: s += s.substr(0, pick(s.size() + 1)); break;
+            }
+        }
+        if (s.size() > 65535) s.resize(65535);
+        return s;
+    }
+
+    // Declared LEN disagrees with the bytes actually sent.
+    std::string length_lie() {
+        std::string data = random_bytes(pick(64));
+        size_t declared = pick(2) ? data.size() + 1 + pick(1024) : (data.empty() ? 0 : pick(data.size()));
+        return header(std::min<size_t>(declared, 65535)) + data;
+    }
+
+    std::string boundary() {
+        switch (pick(4)) {
+            case 0: return header(0);
+            case 1: return header(65535);                         // max length, no body
+            case 2: return header(65535) + std::string(65535, 'B'); // max length, full body
+            default: return std::string(1, '\xff');               // half a header
+        }
+    }
+
+    const Config& cfg_;
+    const std::vector<std::string>& corpus_;
+    std::mt19937_64 rng_;
+};
+
+// ---------------------------------------------------------------------------
+// Per-thread connection loop
+// ---------------------------------------------------------------------------
+
+std::atomic<bool> g_stop{false};
+std::atomic<uint64_t> g_cases{0};
+std::atomic<bool> g_target_down{false};
+
+constexpr size_t RECENT_CASES = 32;
+constexpr int DOWN_AFTER_REFUSALS = 8;
+
+struct Conn {
+    int fd = -1;
+    enum class State { Idle, Connecting, Reading } state = State::Idle;
+    std::string out;
+    size_t sent = 0;
+    std::string in;
+    Clock::time_point start;
+    Clock::time_point deadline;
+};
+
+class Worker {
+public:
+    Worker(const Config& cfg, const std::vector<std::string>& corpus, int conns, uint64_t seed)
+        : cfg_(cfg), gen_(cfg, corpus, seed), conns_(static_cast<size_t>(conns)) {}
+
+    void run() {
+        ep_ = epoll_create1(EPOLL_CLOEXEC);
+        if (ep_ < 0) return;
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(cfg_.port));
+        inet_pton(AF_INET, cfg_.host.c_str(), &addr.sin_addr);
+        addr_ = addr;
+
+        for (size_t i = 0; i < conns_.size(); i++) start_case(i);
+        std::vector<epoll_event> events(conns_.size() + 1);
+        while (!g_stop.load(std::memory_order_relaxed)) {
+            int n = epoll_wait(ep_, events.data(), static_cast<int>(events.size()), 10);
+            for (int i = 0; i < n; i++) on_event(events[i].data.u32, events[i].events);
+            expire_timeouts();
+        }
+        for (auto& c : conns_) if (c.fd >= 0) close(c.fd);
+        close(ep_);
+    }
+
+    const Counters& counters() const { return counters_; }
+    const Histogram& histogram() const { return hist_; }
+    const std::deque<std::string>& recent() const { return recent_; }
+
+private:
+    void start_case(size_t i) {
+        if (g_stop.load(std::memory_order_relaxed)) return;
+        uint64_t n = g_cases.fetch_add(1, std::memory_order_relaxed);
+        if (cfg_.max_cases && n >= cfg_.max_cases) {
+            g_stop = true;
+            return;
+        }
+        Conn& c = conns_[i];
+        c.out = gen_.next();
+        c.sent = 0;
+        c.in.clear();
+        recent_.push_back(c.out);
+        if (recent_.size() > RECENT_CASES) recent_.pop_front();
+        counters_.cases++;
+
+        c.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        int one = 1;
+        setsockopt(c.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        c.start = Clock::now();
+        c.deadline = c.start + std::chrono::milliseconds(cfg_.timeout_ms);
+        int r = connect(c.fd, reinterpret_cast<sockaddr*>(&addr_), sizeof(addr_));
+        if (r < 0 && errno != EINPROGRESS) {
+            connect_failed(i);
+            return;
+        }
+        c.state = Conn::State::Connecting;
+        epoll_event ev = {};
+        ev.events = EPOLLOUT | EPOLLIN | EPOLLRDHUP;
+        ev.data.u32 = static_cast<uint32_t>(i);
+        epoll_ctl(ep_, EPOLL_CTL_ADD, c.fd, &ev);
+    }
+
+    void connect_failed(size_t i) {
+        counters_.connect_fail++;
+        if (++refusals_ > DOWN_AFTER_REFUSALS && had_success_ && cfg_.fuzz) {
+            g_target_down = true;
+            g_stop = true;
+        }
+        finish(i);
+    }
+
+    void on_event(uint32_t i, uint32_t events) {
+        Conn& c = conns_[i];
+        if (c.fd < 0) return;
+        if (c.state == Conn::State::Connecting) {
+            int err = 0;
+            socklen_t len = sizeof(err);
+            getsockopt(c.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+            if (err != 0) {
+                connect_failed(i);
+                return;
+            }
+            refusals_ = 0;
+            had_success_ = true;
+            if (!flush(c)) {
+                counters_.reset++;
+                finish(i);
+                return;
+            }
+            if (c.sent < c.out.size()) return;
+            // Half-close so length-lying frames end with EOF instead of a hang.
+            if (cfg_.fuzz) shutdown(c.fd, SHUT_WR);
+            c.state = Conn::State::Reading;
+            epoll_event ev = {};
+            ev.events = EPOLLIN | EPOLLRDHUP;
+            ev.data.u32 = i;
+            epoll_ctl(ep_, EPOLL_CTL_MOD, c.fd, &ev);
+            if (!(events & (EPOLLIN | EPOLLRDHUP))) return;
+        }
+        char buf[256];
+        for (;;) {
+            ssize_t r = recv(c.fd, buf, sizeof(buf), 0);
+            if (r > 0) {
+                c.in.append(buf, static_cast<size_t>(r));
+                continue;
+            }
+            if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+            if (r < 0) counters_.reset++;
+            else classify(c);
+            finish(i);
+            return;
+        }
+    }
+
+    // Returns false on a hard send error.
+    bool flush(Conn& c) {
+        while (c.sent < c.out.size()) {
+            ssize_t w = send(c.fd, c.out.data() + c.sent, c.out.size() - c.sent, MSG_NOSIGNAL);
+            if (w > 0) {
+                c.sent += static_cast<size_t>(w);
+                continue;
+            }
+            return w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+        return true;
+    }
+
+    void classify(Conn& c) {
+        uint64_t us = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - c.start).count());
+        hist_.record(us);
+        if (c.in == "OK" || c.in == "OK\n") counters_.ok++;
+        else if (c.in == "ERR") counters_.err++;
+        else counters_.other_reply++;
+    }
+
+    void expire_timeouts() {
+        auto now = Clock::now();
+        for (size_t i = 0; i < conns_.size(); i++) {
+            Conn& c = conns_[i];
+            if (c.fd >= 0 && now > c.deadline) {
+                counters_.timeout++;
+                finish(i);
+            } else if (c.fd < 0 && !g_stop.load(std::memory_order_relaxed)) {
+                start_case(i);
+            }
+        }
+    }
+
+    void finish(size_t i) {
+        Conn& c = conns_[i];
+        if (c.fd >= 0) close(c.fd);
+        c.fd = -1;
+        c.state = Conn::State::Idle;
+        if (refusals_ == 0) start_case(i);
+        // After a refusal the slot is retried from expire_timeouts() (next tick),
+        // so a dead target does not turn into a connect() busy loop.
+    }
+
+    const Config& cfg_;
+    CaseGenerator gen_;
+    std::vector<Conn> conns_;
+    sockaddr_in addr_ = {};
+    int ep_ = -1;
+    int refusals_ = 0;
+    bool had_success_ = false;
+    Counters counters_;
+    Histogram hist_;
+    std::deque<std::string> recent_;
+};
+
+void usage() {
+    std::cerr << "usage: tcp_lab_loadgen [--host 127.0.0.1] [--port 9001] [--threads 4] [--connections 64]\n"
+                 "                       [--duration 10] [--cases N] [--mode bench|fuzz] [--payload 64]\n"
+                 "                       [--corpus DIR] [--raw] [--timeout-ms 1000] [--seed N] [--crash-dir DIR]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Config cfg;
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto val = [&]() -> std::string {
+            if (i + 1 >= argc) { usage(); std::exit(1); }
+            return argv[++i];
+        };
+        if (a == "--host") cfg.host = val();
+        else if (a == "--port") cfg.port = std::atoi(val().c_str());
+        else if (a == "--threads") cfg.threads = std::max(1, std::atoi(val().c_str()));
+        else if (a == "--connections") cfg.connections = std::max(1, std::atoi(val().c_str()));
+        else if (a == "--duration") cfg.duration_s = std::atof(val().c_str());
+        else if (a == "--cases") cfg.max_cases = std::strtoull(val().c_str(), nullptr, 10);
+        else if (a == "--mode") cfg.fuzz = (val() == "fuzz");
+        else if (a == "--payload") cfg.payload = std::min<size_t>(std::strtoul(val().c_str(), nullptr, 10), 65535);
+        else if (a == "--corpus") cfg.corpus_dir = val();
+        else if (a == "--raw") cfg.raw = true;
+        else if (a == "--timeout-ms") cfg.timeout_ms = std::max(1, std::atoi(val().c_str()));
+        else if (a == "--seed") cfg.seed = std::strtoull(val().c_str(), nullptr, 10);
+        else if (a == "--crash-dir") cfg.crash_dir = val();
+        else { usage(); return 1; }
+    }
+    if (cfg.seed == 0) cfg.seed = static_cast<uint64_t>(Clock::now().time_since_epoch().count());
+    cfg.threads = std::min(cfg.threads, cfg.connections);
+
+    std::vector<std::string> corpus = load_corpus(cfg.corpus_dir);
+    std::cout << "tcp_lab_loadgen: " << cfg.host << ":" << cfg.port
+              << " mode=" << (cfg.fuzz ? "fuzz" : "bench") << (cfg.raw ? " (raw)" : "")
+              << " threads=" << cfg.threads << " connections=" << cfg.connections
+              << " corpus=" << corpus.size() << " files seed=" << cfg.seed << "\n";
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int t = 0; t < cfg.threads; t++) {
+        int conns = cfg.connections / cfg.threads + (t < cfg.connections % cfg.threads ? 1 : 0);
+        workers.push_back(std::make_unique<Worker>(cfg, corpus, conns, cfg.seed + static_cast<uint64_t>(t)));
+    }
+    auto t0 = Clock::now();
+    std::vector<std::thread> threads;
+    for (auto& w : workers) threads.emplace_back([&w] { w->run(); });
+    while (!g_stop.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        if (std::chrono::duration<double>(Clock::now() - t0).count() >= cfg.duration_s) g_stop = true;
+    }
+    for (auto& t : threads) t.join();
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    Counters total;
+    Histogram hist;
+    for (auto& w : workers) {
+        total.merge(w->counters());
+        hist.merge(w->histogram());
+    }
+
+    std::printf("\ncases=%llu in %.2fs -> %.0f cases/s\n", static_cast<unsigned long long>(total.cases),
+                secs, static_cast<double>(total.cases) / secs);
+    std::printf("ok=%llu err=%llu other_reply=%llu reset=%llu timeout=%llu connect_fail=%llu\n",
+                static_cast<unsigned long long>(total.ok), static_cast<unsigned long long>(total.err),
+                static_cast<unsigned long long>(total.other_reply), static_cast<unsigned long long>(total.reset),
+                static_cast<unsigned long long>(total.timeout), static_cast<unsigned long long>(total.connect_fail));
+    std::printf("latency (us): p50=%llu p90=%llu p99=%llu p99.9=%llu\n",
+                static_cast<unsigned long long>(hist.percentile(0.50)),
+                static_cast<unsigned long long>(hist.percentile(0.90)),
+                static_cast<unsigned long long>(hist.percentile(0.99)),
+                static_cast<unsigned long long>(hist.percentile(0.999)));
+    std::printf("histogram (>= us : count):\n");
+    for (size_t b = 0; b < HIST_BUCKETS; b++) {
+        if (hist.counts[b]) {
+            std::printf("  %10llu : %llu\n", static_cast<unsigned long long>(bucket_lower(b)),
+                        static_cast<unsigned long long>(hist.counts[b]));
+        }
+    }
+
+    if (g_target_down) {
+        std::printf("\nTarget stopped accepting connections - likely crashed. Last cases:\n");
+        int n = 0;
+        for (size_t t = 0; t < workers.size(); t++) {
+            for (auto& c : workers[t]->recent()) {
+                std::string path = cfg.crash_dir + "/crash-" + std::to_string(t) + "-" + std::to_string(n++) + ".bin";
+                std::ofstream(path, std::ios::binary).write(c.data(), static_cast<std::streamsize>(c.size()));
+                std::printf("  %s (%zu bytes)\n", path.c_str(), c.size());
+            }
+        }
+        return 2;
+    }
+    return 0;
+}
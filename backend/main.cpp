@@ -1,17 +1,40 @@
 #include "crow.h"
 #include "db/connection.h"
+#include "db/statements.h"
 #include "routes/auth_routes.h"
 #include "routes/product_routes.h"
 #include "routes/cart_routes.h"
 #include "routes/order_routes.h"
+#include "routes/metrics_routes.h"
+#include "routes/health_routes.h"
+#include "routes/static_routes.h"
+#include "server/app.h"
+#include "server/config.h"
+#include "server/db_executor.h"
+#include "server/deadline.h"
+#include "server/lifecycle.h"
+#include "server/product_store.h"
+#include "server/product_stream.h"
+#include "server/stock_committer.h"
+#include "server/order_queue.h"
+#include "server/search_cache.h"
+#include "server/runtime.h"
+#include "server/startup.h"
+#include "server/static_files.h"
 #ifdef ENABLE_LABS
 #include "routes/lab_routes.h"
 #include "lab_services/tcp_lab_server.h"
+#include "lab/telemetry/lab_telemetry.h"
 #endif
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <string>
 #include <thread>
+#include <vector>
 
 namespace {
 
@@ -31,47 +54,260 @@ void print_lab_mode_banner() {
     std::cout << "\n";
 }
 
+void register_all_routes(server::App& app, bool labMode) {
+    auth_routes::register_routes(app);
+    product_routes::register_routes(app);
+    cart_routes::register_routes(app);
+    order_routes::register_routes(app);
+    metrics_routes::register_routes(app);
+    health_routes::register_routes(app);
+#ifdef ENABLE_LABS
+    lab_routes::register_routes(app, labMode);
+#else
+    (void)labMode;
+#endif
+    static_routes::register_routes(app);  // catch-all: keep last
+}
+
+void apply_compression(const server::AppConfig& config) {
+    server::CompressionOptions options;
+    options.enabled = config.compression;
+    options.min_bytes = static_cast<size_t>(config.compression_min_bytes);
+    options.level = config.compression_level;
+    options.cache_bytes = static_cast<size_t>(config.compression_cache_bytes);
+    server::ResponseCompression::set_options(options);
+}
+
+// The admission_* maps were checked by validate() (server/config.cpp).
+void apply_admission(const server::AppConfig& config) {
+    const std::map<std::string, int>* overrides[] = {&config.admission_checkout, &config.admission_catalog,
+                                                     &config.admission_lab};
+    for (size_t i = 0; i < server::PRIORITY_COUNT; i++) {
+        auto p = static_cast<server::Priority>(i);
+        server::AdmissionLimits limits;
+        std::string error;
+        if (server::admission_limits(p, *overrides[i], limits, error)) server::AdmissionControl::set_limits(p, limits);
+    }
+}
+
+void apply_search_cache(const server::AppConfig& config) {
+    server::SearchCache::instance().configure(static_cast<size_t>(config.search_cache_bytes), config.search_cache_ttl_ms);
+}
+
+// An empty static_dir clears the index (API only).
+void load_static_files(const server::AppConfig& config) {
+    size_t files = server::StaticFiles::instance().load(config.static_dir,
+        static_cast<size_t>(config.static_cache_file_max_bytes), static_cast<size_t>(config.static_cache_max_bytes));
+    if (config.static_dir.empty()) return;
+    if (files == 0) {
+        std::cerr << "Static: nothing to serve in " << config.static_dir << " (run npm run build?)" << std::endl;
+        return;
+    }
+    std::cout << "Static: " << files << " files from " << config.static_dir << ", "
+              << server::StaticFiles::instance().metrics().cached_bytes / 1024 << " KiB in memory" << std::endl;
+}
+
 } // namespace
 
 int main(int argc, char* argv[]) {
+    // Before any thread starts: only the lifecycle watcher thread receives these.
+    server::Lifecycle::block_shutdown_signals();
+
     std::string configPath = "config/db_config.json";
-    for (int i = 1; i < argc - 1; i++) {
-        if (std::string(argv[i]) == "--config") {
-            configPath = argv[i + 1];
-            break;
+    int dbThreads = -1;  // -1 = from config
+    int port = -1, workers = -1, instances = -1, pinThreads = -1;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--config" && hasValue) {
+            configPath = argv[++i];
+        } else if (arg == "--db-threads" && hasValue) {
+            dbThreads = std::atoi(argv[++i]);
+        } else if (arg == "--port" && hasValue) {
+            port = std::atoi(argv[++i]);
+        } else if (arg == "--workers" && hasValue) {
+            workers = std::atoi(argv[++i]);
+        } else if (arg == "--instances" && hasValue) {
+            instances = std::atoi(argv[++i]);
+        } else if (arg == "--pin-threads") {
+            pinThreads = 1;
         }
     }
 
     const char* labModeEnv = std::getenv("LAB_MODE");
     bool labMode = (labModeEnv && (std::string(labModeEnv) == "true" || std::string(labModeEnv) == "1"));
 
+    server::ServeOptions serve;
+    server::DrainOptions drain;
+    server::AppConfig config;
+    std::vector<std::string> categories;
+    std::cout << "Starting up (LAB_MODE=" << (labMode ? "true" : "false") << ")" << std::endl;
     try {
-        Database::instance().loadConfig(configPath);
-        Database::instance().setSecurityLabMode(labMode);
-        std::cout << "Database connected. LAB_MODE=" << (labMode ? "true" : "false") << std::endl;
+        Database& db = Database::instance();
+        server::timed_phase("config", [&] {
+            config = server::ConfigStore::instance().load(configPath);
+            db.configure(config.db);
+            // Statements on migrated columns are prepared only for the features that use them.
+            if (config.stock_ledger) db_statements::enable(db_statements::Feature::StockLedger);
+            if (config.order_queue && config.stock_ledger) db_statements::enable(db_statements::Feature::OrderQueue);
+            server::apply_log_level(config.log_level);
+            server::set_route_deadlines(config.deadlines_ms);
+            server::RequestLimits::set_limits(static_cast<size_t>(config.http.max_body_bytes),
+                                              static_cast<size_t>(config.http.max_headers));
+            apply_compression(config);
+            apply_admission(config);
+            apply_search_cache(config);
+        });
+        db.setSecurityLabMode(labMode);
+        server::timed_phase("connect", [&] { db.connect(); });
+        server::timed_phase("prepare", [&] { db.prepareStatements(); });
+        server::timed_phase("warm", [&] { categories = server::warm_catalog(); });
+        if (config.stock_ledger) {
+            // Before the catalog load, so it sees stock with any pending orders applied.
+            server::timed_phase("stock", [&] { server::StockCommitter::instance().load(); });
+            server::StockCommitter::instance().start(config.stock_commit_ms);
+        }
+        if (config.order_queue && !config.stock_ledger) {
+            std::cerr << "order_queue needs stock_ledger; orders stay synchronous" << std::endl;
+        } else if (config.order_queue) {
+            auto& orders = server::OrderQueue::instance();
+            orders.configure(static_cast<size_t>(config.order_queue_max), static_cast<size_t>(config.order_batch_max));
+            size_t requeued = 0;
+            server::timed_phase("orders", [&] { requeued = orders.open(config.order_journal); });
+            if (requeued) std::cout << "Orders: " << requeued << " re-queued from " << config.order_journal << std::endl;
+            orders.start();
+        }
+        if (config.product_store) {
+            server::timed_phase("catalog", [&] { server::ProductStore::instance().refresh(); });
+            server::ProductStore::instance().set_change_log_entries(static_cast<size_t>(config.change_log_entries));
+            server::ProductStore::instance().start(config.product_store_refresh_ms);
+        }
+        server::ProductStream::instance().configure(static_cast<size_t>(config.stream_max_waiting), config.stream_hold_ms);
+        server::ProductStream::instance().start();
+        if (!config.static_dir.empty()) server::timed_phase("static", [&] { load_static_files(config); });
+        serve.port = port > 0 ? port : config.http.port;
+        serve.workers = workers >= 0 ? workers : config.http.workers;
+        serve.instances = std::max(1, instances > 0 ? instances : config.http.instances);
+        serve.pin_threads = pinThreads > 0 || config.http.pin_threads;
+        drain.delay_ms = config.http.drain_delay_ms;
+        drain.timeout_ms = config.http.drain_timeout_ms;
+        if (dbThreads < 0) dbThreads = config.db.db_threads;
+        if (dbThreads <= 0) dbThreads = config.db.pool_size;
+        server::DbExecutor::instance().start(static_cast<size_t>(dbThreads), serve.pin_threads);
+        std::cout << "DB executor: " << dbThreads << " threads, pool: " << config.db.pool_size << " connections" << std::endl;
+    } catch (server::ConfigError& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
     } catch (std::exception& e) {
         std::cerr << "Failed to connect to database: " << e.what() << std::endl;
         return 1;
     }
 
-    crow::SimpleApp app;
+    // SIGHUP: re-read the config file and apply what can change without a restart.
+    server::ConfigStore::instance().on_reload([](const server::AppConfig& config) {
+        Database::instance().resizePool(config.db.pool_size);
+        server::set_route_deadlines(config.deadlines_ms);
+        server::apply_log_level(config.log_level);
+        server::RequestLimits::set_limits(static_cast<size_t>(config.http.max_body_bytes),
+                                          static_cast<size_t>(config.http.max_headers));
+        apply_compression(config);
+        apply_admission(config);
+        apply_search_cache(config);
+        load_static_files(config);  // picks up a new build of the frontend
+        server::ProductStore::instance().set_refresh_ms(config.product_store_refresh_ms);
+        server::ProductStore::instance().set_change_log_entries(static_cast<size_t>(config.change_log_entries));
+        server::ProductStream::instance().configure(static_cast<size_t>(config.stream_max_waiting), config.stream_hold_ms);
+        server::StockCommitter::instance().set_commit_ms(config.stock_commit_ms);
+        server::OrderQueue::instance().configure(static_cast<size_t>(config.order_queue_max),
+                                                 static_cast<size_t>(config.order_batch_max));
+    });
 
-    app.loglevel(crow::LogLevel::Warning);
+    // Crow gives no access to its acceptor socket, so server/runtime.cpp interposes
+    // libc's bind() and listen() to apply these. Only acceptor threads that call
+    // server::arm_listener() before app->run() are affected.
+    server::ListenOptions listen;
+    listen.reuseport = serve.instances > 1;
+    listen.tcp_nodelay = config.http.tcp_nodelay;
+    listen.backlog = config.http.listen_backlog;
+    if (!server::configure_listener(static_cast<uint16_t>(serve.port), listen) && serve.instances > 1) {
+        std::cerr << "SO_REUSEPORT not supported here; running a single instance" << std::endl;
+        serve.instances = 1;
+    }
+    size_t fdLimit = server::raise_fd_limit();
+    size_t totalWorkers = serve.workers > 0 ? static_cast<size_t>(serve.workers) : server::cpu_count();
+    size_t perInstance = std::max<size_t>(1, totalWorkers / static_cast<size_t>(serve.instances));
+    size_t cpusPerInstance = std::max<size_t>(1, server::cpu_count() / static_cast<size_t>(serve.instances));
 
-    auth_routes::register_routes(app);
-    product_routes::register_routes(app);
-    cart_routes::register_routes(app);
-    order_routes::register_routes(app);
+    std::vector<std::unique_ptr<server::App>> apps;
+    for (int i = 0; i < serve.instances; i++) {
+        auto app = std::make_unique<server::App>();
+        register_all_routes(*app, labMode);
+        app->port(static_cast<uint16_t>(serve.port))
+            .concurrency(static_cast<unsigned>(perInstance))
+            .timeout(static_cast<std::uint8_t>(config.http.idle_timeout_s));
+#ifndef _WIN32
+        app->signal_clear();  // SIGTERM/SIGINT go through server::Lifecycle instead
+#endif
+        apps.push_back(std::move(app));
+    }
+    bool healthy = true;
+    server::timed_phase("self_check", [&] { healthy = server::self_check(*apps[0], categories); });
+    if (!healthy) {
+        std::cerr << "Startup self-check failed; not opening port " << serve.port << std::endl;
+        server::DbExecutor::instance().shutdown();
+        server::ProductStream::instance().stop();
+        server::OrderQueue::instance().stop();
+        server::StockCommitter::instance().stop();
+        server::ProductStore::instance().stop();
+        Database::instance().close();
+        return 1;
+    }
+    std::cout << "HTTP: port " << serve.port << ", " << serve.instances << " instance(s) x "
+              << perInstance << " workers" << (serve.pin_threads ? ", pinned" : "") << ", idle timeout "
+              << config.http.idle_timeout_s << " s" << (fdLimit ? ", fd limit " + std::to_string(fdLimit) : "") << std::endl;
 
 #ifdef ENABLE_LABS
-    lab_routes::register_routes(app, labMode);
     if (labMode) {
         print_lab_mode_banner();
-        std::thread tcp_lab(run_tcp_lab_server);
+        std::thread tcp_lab([] { run_tcp_lab_server(); });
         tcp_lab.detach();
     }
 #endif
 
-    app.port(8080).multithreaded().run();
+    auto& lifecycle = server::Lifecycle::instance();
+    lifecycle.set_reload_handler([] { server::ConfigStore::instance().reload(); });
+    lifecycle.start_signal_watcher(drain, [&apps] {
+        // Finish queued DB work and parked streams while the connections can still be answered.
+        server::DbExecutor::instance().shutdown();
+        server::ProductStream::instance().stop();
+        for (auto& app : apps) app->stop();
+    });
+
+    // Instance i runs on its own thread; Crow's worker threads inherit its CPU mask.
+    std::vector<std::thread> acceptors;
+    for (size_t i = 0; i < apps.size(); i++) {
+        acceptors.emplace_back([&, i] {
+            if (serve.pin_threads && apps.size() > 1) server::pin_current_thread(i * cpusPerInstance, cpusPerInstance);
+            server::arm_listener();
+            apps[i]->run();
+        });
+    }
+    server::timed_phase("listen", [&] {
+        for (auto& app : apps) app->wait_for_server_start();
+    });
+    lifecycle.set_ready(true);
+    std::cout << "Ready." << std::endl;
+    for (auto& t : acceptors) t.join();
+
+    server::DbExecutor::instance().shutdown();
+#ifdef ENABLE_LABS
+    lab::telemetry::flush();
+#endif
+    server::ProductStream::instance().stop();
+    server::OrderQueue::instance().stop();      // commits what is queued
+    server::StockCommitter::instance().stop();  // applies the last orders' stock
+    server::ProductStore::instance().stop();
+    Database::instance().close();
+    std::cout << "Shutdown complete" << std::endl;
     return 0;
 }
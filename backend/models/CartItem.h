@@ -1,5 +1,7 @@
 #pragma once
 
+#include "schema.h"
+#include "../utils/money.h"
 #include <string>
 
 struct CartItem {
@@ -8,6 +10,21 @@ struct CartItem {
     int product_id;
     int quantity;
     std::string product_name;
-    double price;
+    Money price;
     std::string image_url;
 };
+
+// Columns of cart_by_user (db/statements.cpp).
+namespace schema {
+template <>
+struct Fields<CartItem> {
+    static constexpr auto list = std::make_tuple(
+        field("id", 0, &CartItem::id),
+        field("user_id", 1, &CartItem::user_id),
+        field("product_id", 2, &CartItem::product_id),
+        field("quantity", 3, &CartItem::quantity),
+        field("product_name", 4, &CartItem::product_name),
+        field("price", 5, &CartItem::price),
+        field("image_url", 6, &CartItem::image_url));
+};
+} // namespace schema
@@ -1,8 +1,19 @@
 #pragma once
 
+#include "schema.h"
 #include <string>
 
 struct Category {
     int id;
     std::string name;
 };
+
+// Columns of categories_all (db/statements.cpp).
+namespace schema {
+template <>
+struct Fields<Category> {
+    static constexpr auto list = std::make_tuple(
+        field("id", 0, &Category::id),
+        field("name", 1, &Category::name));
+};
+} // namespace schema
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "schema.h"
+#include "../utils/money.h"
 #include <string>
 #include <vector>
 
@@ -7,14 +9,37 @@ struct OrderItem {
     int product_id;
     std::string product_name;
     int quantity;
-    double price_at_purchase;
+    Money price_at_purchase;
 };
 
 struct Order {
     int id;
     int user_id;
-    double total;
+    Money total;
     std::string status;
     std::string created_at;
     std::vector<OrderItem> items;
 };
+
+// Columns of order_items_by_order and orders_by_user (db/statements.cpp).
+namespace schema {
+template <>
+struct Fields<OrderItem> {
+    static constexpr auto list = std::make_tuple(
+        field("product_id", 0, &OrderItem::product_id),
+        field("product_name", 1, &OrderItem::product_name),
+        field("quantity", 2, &OrderItem::quantity),
+        field("price_at_purchase", 3, &OrderItem::price_at_purchase));
+};
+
+template <>
+struct Fields<Order> {
+    static constexpr auto list = std::make_tuple(
+        field("id", 0, &Order::id),
+        field("user_id", 1, &Order::user_id),
+        field("total", 2, &Order::total),
+        field("status", 3, &Order::status),
+        field("created_at", 4, &Order::created_at),
+        field("items", NO_COLUMN, &Order::items));  // filled from order_items_by_order
+};
+} // namespace schema
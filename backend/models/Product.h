@@ -1,5 +1,7 @@
 #pragma once
 
+#include "schema.h"
+#include "../utils/money.h"
 #include <string>
 
 struct Product {
@@ -7,9 +9,26 @@ struct Product {
     int category_id;
     std::string name;
     std::string description;
-    double price;
+    Money price;
     std::string image_url;
     int stock;
     std::string category_name;
     std::string created_at;
 };
+
+// Columns of the products_* statements (db/statements.cpp).
+namespace schema {
+template <>
+struct Fields<Product> {
+    static constexpr auto list = std::make_tuple(
+        field("id", 0, &Product::id),
+        field("category_id", 1, &Product::category_id),
+        field("name", 2, &Product::name),
+        field("description", 3, &Product::description),
+        field("price", 4, &Product::price),
+        field("image_url", 5, &Product::image_url),
+        field("stock", 6, &Product::stock),
+        field("category_name", 7, &Product::category_name),
+        field("created_at", 8, &Product::created_at));
+};
+} // namespace schema
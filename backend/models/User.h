@@ -1,5 +1,6 @@
 #pragma once
 
+#include "schema.h"
 #include <string>
 
 struct User {
@@ -8,3 +9,15 @@ struct User {
     std::string name;
     std::string created_at;
 };
+
+// Columns of user_insert ... RETURNING and user_login (db/statements.cpp).
+namespace schema {
+template <>
+struct Fields<User> {
+    static constexpr auto list = std::make_tuple(
+        field("id", 0, &User::id),
+        field("email", 1, &User::email),
+        field("name", 2, &User::name),
+        field("created_at", 3, &User::created_at));
+};
+} // namespace schema
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "../utils/money.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Compile-time field descriptors for the models. Each model header
+ * specializes schema::Fields<T> with one descriptor per member: its key in
+ * the API payload, the result column it is read from, and the member pointer
+ * (which gives the type). Everything else is generated from that list:
+ *
+ *   schema::write(w, obj)          payload object, any serializer writer
+ *   row_mapping::decode<T>(row)    struct from a pqxx row (db/row_mapping.h)
+ *   row_mapping::write_row<T>(w, row)   payload straight from the row
+ *
+ * Key order is the order of the list, which is the JSON the frontend reads.
+ */
+namespace schema {
+
+/// Members that are not read from the same row (e.g. Order::items).
+constexpr int NO_COLUMN = -1;
+
+template <typename T, typename M>
+struct Field {
+    using type = M;
+    std::string_view key;
+    int column;
+    M T::*member;
+};
+
+template <typename T, typename M>
+constexpr Field<T, M> field(std::string_view key, int column, M T::*member) {
+    return {key, column, member};
+}
+
+/// Specialized next to each model: `static constexpr auto list = std::make_tuple(field(...), ...);`
+template <typename T>
+struct Fields;
+
+template <typename T>
+constexpr size_t field_count() {
+    return std::tuple_size_v<std::decay_t<decltype(Fields<T>::list)>>;
+}
+
+template <typename W, typename T>
+void write(W& w, const T& obj);
+
+template <typename W, typename T>
+void write_array(W& w, const std::vector<T>& items);
+
+namespace detail {
+
+template <typename W>
+void write_value(W& w, int v) { w.integer(v); }
+template <typename W>
+void write_value(W& w, int64_t v) { w.integer(v); }
+template <typename W>
+void write_value(W& w, double v) { w.number(v); }
+template <typename W>
+void write_value(W& w, Money v) { w.money(v); }
+template <typename W>
+void write_value(W& w, const std::string& v) { w.string(v); }
+template <typename W, typename T>
+void write_value(W& w, const std::vector<T>& v) { write_array(w, v); }
+
+} // namespace detail
+
+/// `obj` as an object with its descriptor keys, in any serializer (utils/serializer.h).
+template <typename W, typename T>
+void write(W& w, const T& obj) {
+    w.begin_object(field_count<T>());
+    std::apply([&](const auto&... f) { ((w.key(f.key), detail::write_value(w, obj.*(f.member))), ...); },
+               Fields<T>::list);
+    w.end_object();
+}
+
+template <typename W, typename T>
+void write_array(W& w, const std::vector<T>& items) {
+    w.begin_array(items.size());
+    for (const auto& item : items) write(w, item);
+    w.end_array();
+}
+
+} // namespace schema
@@ -1,8 +1,12 @@
 #include "crow.h"
+#include "../server/app.h"
 #include "../db/connection.h"
+#include "../db/row_mapping.h"
 #include "../models/User.h"
 #include "../utils/response_helper.h"
-#include "../utils/json_helper.h"
+#include "../server/db_task.h"
+#include "../server/deadline.h"
+#include "../server/response_format.h"
 #include <pqxx/pqxx>
 #include <regex>
 #include <openssl/sha.h>
@@ -26,93 +30,100 @@ bool is_valid_email(const std::string& email) {
     return std::regex_match(email, e);
 }
 
-void register_routes(crow::SimpleApp& app) {
+// {"success":true,"data":{"user":{...}}}; the user row as returned by user_insert / user_login.
+crow::response user_response(int code, const User& user) {
+    return server::data_response(server::Format::Json, code, [&](auto& w) {
+        w.begin_object(1);
+        w.key("user");
+        schema::write(w, user);
+        w.end_object();
+    });
+}
+
+void register_routes(server::App& app) {
     CROW_ROUTE(app, "/api/auth/register")
         .methods("POST"_method)
-    ([](const crow::request& req) {
+    ([](const crow::request& req, crow::response& res) {
+        std::string email, hash, name;
         try {
             auto body = crow::json::load(req.body);
             if (!body) {
-                return crow::response(400, response_helper::error_json("Invalid JSON"));
+                return server::respond(res, crow::response(400, response_helper::error_json("Invalid JSON")));
             }
             if (!body["email"] || !body["password"] || !body["name"]) {
-                return crow::response(400, response_helper::error_json("Missing email, password, or name"));
+                return server::respond(res, crow::response(400, response_helper::error_json("Missing email, password, or name")));
             }
-            std::string email = body["email"].s();
+            email = body["email"].s();
             std::string password = body["password"].s();
-            std::string name = body["name"].s();
+            name = body["name"].s();
 
             if (email.empty() || password.empty() || name.empty()) {
-                return crow::response(400, response_helper::error_json("All fields required"));
+                return server::respond(res, crow::response(400, response_helper::error_json("All fields required")));
             }
             if (!is_valid_email(email)) {
-                return crow::response(400, response_helper::error_json("Invalid email format"));
+                return server::respond(res, crow::response(400, response_helper::error_json("Invalid email format")));
             }
             if (password.size() < 6) {
-                return crow::response(400, response_helper::error_json("Password must be at least 6 characters"));
+                return server::respond(res, crow::response(400, response_helper::error_json("Password must be at least 6 characters")));
             }
 
-            std::string hash = sha256_hash(password);
-            auto& db = Database::instance().getConnection();
-
-            pqxx::work txn(db);
-            auto r = txn.exec_params(
-                "INSERT INTO users (email, password_hash, name) VALUES ($1, $2, $3) RETURNING id, email, name, created_at",
-                email, hash, name
-            );
-            txn.commit();
-
-            int id = r[0][0].as<int>();
-            std::string created_at = r[0][3].as<std::string>();
-
-            std::string data = "{\"user\":{\"id\":" + std::to_string(id) +
-                ",\"email\":\"" + json_helper::escape(email) +
-                "\",\"name\":\"" + json_helper::escape(name) +
-                "\",\"created_at\":\"" + json_helper::escape(created_at) + "\"}}";
-            return crow::response(201, response_helper::success_json(data));
-        } catch (pqxx::unique_violation&) {
-            return crow::response(409, response_helper::error_json("Email already registered"));
+            hash = sha256_hash(password);
         } catch (std::exception& e) {
-            return crow::response(500, response_helper::error_json(std::string("Error: ") + e.what()));
+            return server::respond(res, crow::response(500, response_helper::error_json(std::string("Error: ") + e.what())));
         }
+
+        auto deadline = server::Deadline::for_request(req, "auth.register");
+        server::run_db(res, server::Priority::Checkout, [email, hash, name, deadline] {
+            try {
+                auto conn = Database::instance().acquire();
+                pqxx::work txn(*conn);
+                server::apply_deadline(txn, deadline);
+                auto r = txn.exec_prepared("user_insert", email, hash, name);
+                txn.commit();
+
+                return user_response(201, row_mapping::decode<User>(r[0]));
+            } catch (pqxx::unique_violation&) {
+                return crow::response(409, response_helper::error_json("Email already registered"));
+            } catch (std::exception& e) {
+                return server::db_error_response(e, deadline);
+            }
+        });
     });
 
     CROW_ROUTE(app, "/api/auth/login")
         .methods("POST"_method)
-    ([](const crow::request& req) {
+    ([](const crow::request& req, crow::response& res) {
+        std::string email, hash;
         try {
             auto body = crow::json::load(req.body);
             if (!body || !body["email"] || !body["password"]) {
-                return crow::response(400, response_helper::error_json("Missing email or password"));
+                return server::respond(res, crow::response(400, response_helper::error_json("Missing email or password")));
             }
-            std::string email = body["email"].s();
+            email = body["email"].s();
             std::string password = body["password"].s();
-            std::string hash = sha256_hash(password);
-
-            auto& db = Database::instance().getConnection();
-            pqxx::work txn(db);
-            auto r = txn.exec_params(
-                "SELECT id, email, name, created_at FROM users WHERE email = $1 AND password_hash = $2",
-                email, hash
-            );
-            txn.commit();
+            hash = sha256_hash(password);
+        } catch (std::exception& e) {
+            return server::respond(res, crow::response(500, response_helper::error_json(std::string("Error: ") + e.what())));
+        }
 
-            if (r.empty()) {
-                return crow::response(401, response_helper::error_json("Invalid email or password"));
-            }
+        auto deadline = server::Deadline::for_request(req, "auth.login");
+        server::run_db(res, server::Priority::Checkout, [email, hash, deadline] {
+            try {
+                auto conn = Database::instance().acquire();
+                pqxx::work txn(*conn);
+                server::apply_deadline(txn, deadline);
+                auto r = txn.exec_prepared("user_login", email, hash);
+                txn.commit();
 
-            int id = r[0][0].as<int>();
-            std::string name = r[0][2].as<std::string>();
-            std::string created_at = r[0][3].as<std::string>();
+                if (r.empty()) {
+                    return crow::response(401, response_helper::error_json("Invalid email or password"));
+                }
 
-            std::string data = "{\"user\":{\"id\":" + std::to_string(id) +
-                ",\"email\":\"" + json_helper::escape(email) +
-                "\",\"name\":\"" + json_helper::escape(name) +
-                "\",\"created_at\":\"" + json_helper::escape(created_at) + "\"}}";
-            return crow::response(200, response_helper::success_json(data));
-        } catch (std::exception& e) {
-            return crow::response(500, response_helper::error_json(std::string("Error: ") + e.what()));
-        }
+                return user_response(200, row_mapping::decode<User>(r[0]));
+            } catch (std::exception& e) {
+                return server::db_error_response(e, deadline);
+            }
+        });
     });
 }
 
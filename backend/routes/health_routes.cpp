@@ -0,0 +1,47 @@
+#include "crow.h"
+#include "../server/app.h"
+#include "../server/lifecycle.h"
+#include "../utils/json_helper.h"
+#include <string>
+
+namespace health_routes {
+
+namespace {
+
+std::string startup_json() {
+    double total = 0;
+    std::string phases = "[";
+    for (const auto& p : server::Lifecycle::instance().phases()) {
+        if (phases.size() > 1) phases += ",";
+        phases += "{\"name\":" + json_helper::quote(p.name) + ",\"ms\":" + json_helper::double_to_str(p.ms) + "}";
+        total += p.ms;
+    }
+    phases += "]";
+    return "{\"total_ms\":" + json_helper::double_to_str(total) + ",\"phases\":" + phases + "}";
+}
+
+} // namespace
+
+void register_routes(server::App& app) {
+    CROW_ROUTE(app, "/healthz")
+        .methods("GET"_method)
+    ([]() {
+        std::string body = "{\"status\":\"ok\",\"uptime_s\":" +
+            json_helper::double_to_str(server::Lifecycle::instance().uptime_s()) + "}";
+        return crow::response(200, body);
+    });
+
+    CROW_ROUTE(app, "/readyz")
+        .methods("GET"_method)
+    ([]() {
+        auto& life = server::Lifecycle::instance();
+        bool ready = life.ready();
+        std::string body = std::string("{\"ready\":") + (ready ? "true" : "false") +
+            ",\"draining\":" + (life.draining() ? "true" : "false") +
+            ",\"inflight\":" + std::to_string(life.inflight()) +
+            ",\"startup\":" + startup_json() + "}";
+        return crow::response(ready ? 200 : 503, body);
+    });
+}
+
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "crow.h"
+#include "../server/app.h"
+
+namespace health_routes {
+    /// GET /healthz - liveness: 200 whenever the process can answer.
+    /// GET /readyz  - readiness: 200 once startup finished, 503 before that and once shutdown began.
+    void register_routes(server::App& app);
+}
@@ -1,8 +1,9 @@
 #pragma once
 
 #include "crow.h"
+#include "../server/app.h"
 
 namespace lab_routes {
     /// Register lab routes. Only responds when lab_mode_enabled is true; guard returns 404/403 otherwise.
-    void register_routes(crow::SimpleApp& app, bool lab_mode_enabled);
+    void register_routes(server::App& app, bool lab_mode_enabled);
 }
@@ -0,0 +1,234 @@
+#include "crow.h"
+#include "../server/app.h"
+#include "../db/connection.h"
+#include "../server/admission.h"
+#include "../server/db_executor.h"
+#include "../server/deadline.h"
+#include "../server/product_store.h"
+#include "../server/product_stream.h"
+#include "../server/stock_committer.h"
+#include "../server/order_queue.h"
+#include "../server/request_limits.h"
+#include "../server/search_cache.h"
+#include "../server/single_flight.h"
+#include "../server/response_compression.h"
+#include "../server/static_files.h"
+#include "../utils/json_helper.h"
+#include "../utils/response_helper.h"
+#include <string>
+
+namespace metrics_routes {
+
+namespace {
+
+std::string executor_json() {
+    auto m = server::DbExecutor::instance().metrics();
+    std::string queues = "{";
+    for (size_t i = 0; i < server::PRIORITY_COUNT; i++) {
+        if (i > 0) queues += ",";
+        queues += "\"" + std::string(server::priority_name(static_cast<server::Priority>(i))) + "\":{" +
+            "\"depth\":" + std::to_string(m.depth[i]) +
+            ",\"max_depth\":" + std::to_string(m.max_depth[i]) +
+            ",\"submitted\":" + std::to_string(m.submitted[i]) +
+            ",\"completed\":" + std::to_string(m.completed[i]) + "}";
+    }
+    queues += "}";
+    return "{\"threads\":" + std::to_string(m.threads) +
+        ",\"busy\":" + std::to_string(m.busy) +
+        ",\"stolen\":" + std::to_string(m.stolen) +
+        ",\"queues\":" + queues + "}";
+}
+
+std::string pool_json() {
+    auto& pool = Database::instance().pool();
+    return "{\"size\":" + std::to_string(pool.size()) + ",\"idle\":" + std::to_string(pool.idle()) + "}";
+}
+
+std::string admission_json(const server::AdmissionControl& admission) {
+    std::string out = "{";
+    for (size_t i = 0; i < server::PRIORITY_COUNT; i++) {
+        auto p = static_cast<server::Priority>(i);
+        auto m = admission.metrics(p);
+        if (i > 0) out += ",";
+        out += "\"" + std::string(server::priority_name(p)) + "\":{" +
+            "\"inflight\":" + std::to_string(m.inflight) +
+            ",\"limit\":" + std::to_string(m.limit) +
+            ",\"admitted\":" + std::to_string(m.admitted) +
+            ",\"rejected\":" + std::to_string(m.rejected) +
+            ",\"last_latency_ms\":" + json_helper::double_to_str(m.last_latency_ms) + "}";
+    }
+    return out + "}";
+}
+
+std::string http_json() {
+    auto m = server::RequestLimits::metrics();
+    return "{\"max_body_bytes\":" + std::to_string(m.max_body_bytes) +
+        ",\"max_headers\":" + std::to_string(m.max_headers) +
+        ",\"rejected_body\":" + std::to_string(m.rejected_body) +
+        ",\"rejected_headers\":" + std::to_string(m.rejected_headers) + "}";
+}
+
+std::string static_json() {
+    auto m = server::StaticFiles::instance().metrics();
+    return "{\"files\":" + std::to_string(m.files) +
+        ",\"cached_bytes\":" + std::to_string(m.cached_bytes) +
+        ",\"served\":" + std::to_string(m.served) +
+        ",\"not_modified\":" + std::to_string(m.not_modified) +
+        ",\"streamed\":" + std::to_string(m.streamed) + "}";
+}
+
+std::string compression_json() {
+    auto m = server::ResponseCompression::metrics();
+    double saved_pct = m.bytes_in ? 100.0 * static_cast<double>(m.bytes_in - m.bytes_out) / static_cast<double>(m.bytes_in) : 0;
+    double mb = static_cast<double>(m.compressed_bytes_in) / (1024.0 * 1024.0);
+    return "{\"responses\":" + std::to_string(m.responses) +
+        ",\"cache_hits\":" + std::to_string(m.cache_hits) +
+        ",\"bytes_in\":" + std::to_string(m.bytes_in) +
+        ",\"bytes_out\":" + std::to_string(m.bytes_out) +
+        ",\"saved_pct\":" + json_helper::double_to_str(saved_pct) +
+        ",\"compress_ms\":" + json_helper::double_to_str(m.compress_ms) +
+        ",\"ms_per_mb\":" + json_helper::double_to_str(mb > 0 ? m.compress_ms / mb : 0) +
+        ",\"cache_bytes\":" + std::to_string(m.cache_bytes) + "}";
+}
+
+std::string product_store_json() {
+    auto m = server::ProductStore::instance().metrics();
+    return "{\"rows\":" + std::to_string(m.rows) +
+        ",\"refreshes\":" + std::to_string(m.refreshes) +
+        ",\"refresh_failures\":" + std::to_string(m.refresh_failures) +
+        ",\"queries\":" + std::to_string(m.queries) +
+        ",\"last_refresh_ms\":" + json_helper::double_to_str(m.last_refresh_ms) +
+        ",\"age_ms\":" + json_helper::double_to_str(m.age_ms) +
+        ",\"patches\":" + std::to_string(m.patches) +
+        ",\"version\":" + std::to_string(m.version) +
+        ",\"kernels\":" + json_helper::quote(server::scan_kernels_name(server::scan_kernels())) +
+        ",\"suggest_nodes\":" + std::to_string(m.suggest_nodes) +
+        ",\"suggest_bytes\":" + std::to_string(m.suggest_bytes) +
+        ",\"suggest_builds\":" + std::to_string(m.suggest_builds) +
+        ",\"last_suggest_build_ms\":" + json_helper::double_to_str(m.last_suggest_build_ms) +
+        ",\"change_log\":{\"entries\":" + std::to_string(m.changes.entries) +
+        ",\"max_entries\":" + std::to_string(m.changes.max_entries) +
+        ",\"floor\":" + std::to_string(m.changes.floor) +
+        ",\"recorded\":" + std::to_string(m.changes.recorded) +
+        ",\"compacted\":" + std::to_string(m.changes.compacted) +
+        ",\"dropped\":" + std::to_string(m.changes.dropped) + "}}";
+}
+
+std::string product_stream_json() {
+    auto m = server::ProductStream::instance().metrics();
+    return "{\"waiting\":" + std::to_string(m.waiting) +
+        ",\"max_waiting\":" + std::to_string(m.max_waiting) +
+        ",\"requests\":" + std::to_string(m.requests) +
+        ",\"rejected\":" + std::to_string(m.rejected) +
+        ",\"batches\":" + std::to_string(m.batches) +
+        ",\"events\":" + std::to_string(m.events) +
+        ",\"heartbeats\":" + std::to_string(m.heartbeats) +
+        ",\"resyncs\":" + std::to_string(m.resyncs) +
+        ",\"coalesced_versions\":" + std::to_string(m.coalesced_versions) +
+        ",\"publishes\":" + std::to_string(m.publishes) + "}";
+}
+
+std::string stock_ledger_json() {
+    auto m = server::StockCommitter::instance().metrics();
+    return "{\"enabled\":" + std::string(m.enabled ? "true" : "false") +
+        ",\"products\":" + std::to_string(m.ledger.products) +
+        ",\"reserved_units\":" + std::to_string(m.ledger.reserved) +
+        ",\"rejected\":" + std::to_string(m.ledger.rejected) +
+        ",\"released_units\":" + std::to_string(m.ledger.released) +
+        ",\"applied_units\":" + std::to_string(m.ledger.applied) +
+        ",\"adjusted\":" + std::to_string(m.ledger.adjusted) +
+        ",\"orders\":" + std::to_string(m.orders) +
+        ",\"flushes\":" + std::to_string(m.flushes) +
+        ",\"flush_failures\":" + std::to_string(m.flush_failures) +
+        ",\"flushed_orders\":" + std::to_string(m.flushed_orders) +
+        ",\"oversold_units\":" + std::to_string(m.oversold) +
+        ",\"last_flush_ms\":" + json_helper::double_to_str(m.last_flush_ms) + "}";
+}
+
+std::string order_queue_json() {
+    auto m = server::OrderQueue::instance().metrics();
+    return "{\"enabled\":" + std::string(m.enabled ? "true" : "false") +
+        ",\"queued\":" + std::to_string(m.queued) +
+        ",\"max_queued\":" + std::to_string(m.max_queued) +
+        ",\"accepted\":" + std::to_string(m.accepted) +
+        ",\"rejected_full\":" + std::to_string(m.rejected_full) +
+        ",\"replayed\":" + std::to_string(m.replayed) +
+        ",\"committed\":" + std::to_string(m.committed) +
+        ",\"failed\":" + std::to_string(m.failed) +
+        ",\"batches\":" + std::to_string(m.batches) +
+        ",\"batch_retries\":" + std::to_string(m.batch_retries) +
+        ",\"largest_batch\":" + std::to_string(m.largest_batch) +
+        ",\"last_batch_ms\":" + json_helper::double_to_str(m.last_batch_ms) +
+        ",\"journal\":{\"appended\":" + std::to_string(m.journal.appended) +
+        ",\"syncs\":" + std::to_string(m.journal.syncs) +
+        ",\"bytes\":" + std::to_string(m.journal.bytes) +
+        ",\"segments\":" + std::to_string(m.journal.segments) +
+        ",\"outstanding\":" + std::to_string(m.journal.outstanding) + "}}";
+}
+
+std::string single_flight_json() {
+    auto m = server::SingleFlight::instance().metrics();
+    std::string keys = "{";
+    for (const auto& [key, count] : m.coalesced_by_key) {
+        if (keys.size() > 1) keys += ",";
+        keys += json_helper::quote(key) + ":" + std::to_string(count);
+    }
+    keys += "}";
+    return "{\"leaders\":" + std::to_string(m.leaders) +
+        ",\"coalesced\":" + std::to_string(m.coalesced) +
+        ",\"inflight\":" + std::to_string(m.inflight) +
+        ",\"coalesced_by_key\":" + keys + "}";
+}
+
+std::string search_cache_json() {
+    auto m = server::SearchCache::instance().metrics();
+    uint64_t lookups = m.hits + m.misses;
+    return "{\"hits\":" + std::to_string(m.hits) +
+        ",\"misses\":" + std::to_string(m.misses) +
+        ",\"hit_pct\":" + json_helper::double_to_str(lookups ? 100.0 * static_cast<double>(m.hits) / static_cast<double>(lookups) : 0) +
+        ",\"stale\":" + std::to_string(m.stale) +
+        ",\"evictions\":" + std::to_string(m.evictions) +
+        ",\"entries\":" + std::to_string(m.entries) +
+        ",\"bytes\":" + std::to_string(m.bytes) +
+        ",\"max_bytes\":" + std::to_string(m.max_bytes) +
+        ",\"ttl_ms\":" + std::to_string(m.ttl_ms) + "}";
+}
+
+std::string deadlines_json() {
+    uint64_t total = 0;
+    std::string routes = "{";
+    for (const auto& [route, count] : server::deadline_exceeded_counts()) {
+        if (routes.size() > 1) routes += ",";
+        routes += json_helper::quote(route) + ":" + std::to_string(count);
+        total += count;
+    }
+    routes += "}";
+    return "{\"exceeded\":" + std::to_string(total) + ",\"by_route\":" + routes + "}";
+}
+
+} // namespace
+
+void register_routes(server::App& app) {
+    auto& admission = app.get_middleware<server::AdmissionControl>();
+    CROW_ROUTE(app, "/api/metrics")
+        .methods("GET"_method)
+    ([&admission]() {
+        try {
+            std::string data = "{\"db_executor\":" + executor_json() + ",\"db_pool\":" + pool_json() +
+                ",\"admission\":" + admission_json(admission) + ",\"deadlines\":" + deadlines_json() +
+                ",\"http\":" + http_json() + ",\"static\":" + static_json() +
+                ",\"compression\":" + compression_json() +
+                ",\"product_store\":" + product_store_json() +
+                ",\"single_flight\":" + single_flight_json() +
+                ",\"search_cache\":" + search_cache_json() +
+                ",\"product_stream\":" + product_stream_json() +
+                ",\"stock_ledger\":" + stock_ledger_json() +
+                ",\"order_queue\":" + order_queue_json() + "}";
+            return crow::response(200, response_helper::success_json(data));
+        } catch (std::exception& e) {
+            return crow::response(500, response_helper::error_json(std::string("Error: ") + e.what()));
+        }
+    });
+}
+
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "crow.h"
+#include "../server/app.h"
+
+namespace metrics_routes {
+    /// GET /api/metrics - runtime counters (DB executor queues, connection pool, admission control, deadlines).
+    void register_routes(server::App& app);
+}
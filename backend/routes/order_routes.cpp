@@ -1,137 +1,421 @@
 #include "crow.h"
+#include "../server/app.h"
 #include "../db/connection.h"
+#include "../db/statements.h"
+#include "../db/row_mapping.h"
 #include "../models/Order.h"
 #include "../utils/response_helper.h"
-#include "../utils/json_helper.h"
+#include "../server/db_read.h"
+#include "../server/db_task.h"
+#include "../server/deadline.h"
+#include "../server/product_store.h"
+#include "../server/stock_committer.h"
+#include "../server/order_queue.h"
+#include "../server/body_parser.h"
+#include "../server/response_format.h"
 #include <pqxx/pqxx>
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace order_routes {
 
-void register_routes(crow::SimpleApp& app) {
-    CROW_ROUTE(app, "/api/orders/create")
-        .methods("POST"_method)
-    ([](const crow::request& req) {
-        try {
-            auto body = crow::json::load(req.body);
-            if (!body || !body["user_id"] || !body["items"]) {
-                return crow::response(400, response_helper::error_json("Missing user_id or items"));
-            }
-            int userId = body["user_id"].i();
-            auto& items = body["items"];
+namespace {
 
-            if (items.size() == 0) {
-                return crow::response(400, response_helper::error_json("No items in order"));
-            }
+using Items = std::vector<std::pair<int, int>>;  // (product_id, quantity)
+
+crow::response created_response(server::Format format, int orderId, Money total) {
+    return server::data_response(format, 201, [&](auto& w) {
+        w.begin_object(2);
+        w.key("order_id");
+        w.integer(orderId);
+        w.key("total");
+        w.money(total);
+        w.end_object();
+    });
+}
+
+crow::response accepted_response(server::Format format, const std::string& token) {
+    auto res = server::data_response(format, 202, [&](auto& w) {
+        w.begin_object(2);
+        w.key("token");
+        w.string(token);
+        w.key("status");
+        w.string("queued");
+        w.end_object();
+    });
+    res.set_header("Location", "/api/orders/status/" + token);
+    res.set_header("Preference-Applied", "respond-async");
+    return res;
+}
+
+const char* state_name(server::OrderState state) {
+    switch (state) {
+        case server::OrderState::Queued: return "queued";
+        case server::OrderState::Committed: return "committed";
+        case server::OrderState::Failed: return "failed";
+    }
+    return "queued";
+}
+
+crow::response status_response(server::Format format, const std::string& token, const server::OrderStatus& s) {
+    return server::data_response(format, 200, [&](auto& w) {
+        w.begin_object(s.state == server::OrderState::Committed ? 4 : s.state == server::OrderState::Failed ? 3 : 2);
+        w.key("token");
+        w.string(token);
+        w.key("status");
+        w.string(state_name(s.state));
+        if (s.state == server::OrderState::Committed) {
+            w.key("order_id");
+            w.integer(s.order_id);
+            w.key("total");
+            w.money(s.total);
+        } else if (s.state == server::OrderState::Failed) {
+            w.key("error");
+            w.string(s.error);
+        }
+        w.end_object();
+    });
+}
+
+// RFC 7240: "Prefer: respond-async", possibly among other preferences.
+bool prefers_async(const crow::request& req) {
+    std::string prefer = req.get_header_value("Prefer");
+    std::transform(prefer.begin(), prefer.end(), prefer.begin(), [](unsigned char c) { return std::tolower(c); });
+    return prefer.find("respond-async") != std::string::npos;
+}
 
-            auto& db = Database::instance().getConnection();
-            pqxx::work txn(db);
+bool valid_token(const std::string& token) {
+    return token.size() == 32 &&
+        std::all_of(token.begin(), token.end(), [](char c) { return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'); });
+}
+
+// Units reserved in the stock ledger, given back unless the order commits.
+class StockReservation {
+public:
+    explicit StockReservation(const Items& items) : items_(items) {}
+    ~StockReservation() {
+        if (held_) server::StockCommitter::instance().ledger().release_all(items_);
+    }
+    StockReservation(const StockReservation&) = delete;
+    StockReservation& operator=(const StockReservation&) = delete;
+
+    /// Reserve every item; returns the problem for a 400, or "".
+    std::string reserve() {
+        int failed = 0;
+        auto r = server::StockCommitter::instance().ledger().reserve_all(items_, failed);
+        if (r == server::StockLedger::Reserve::Unknown) return "Product not found: " + std::to_string(failed);
+        if (r == server::StockLedger::Reserve::Insufficient) return "Insufficient stock for product " + std::to_string(failed);
+        held_ = true;
+        return "";
+    }
+    bool held() const { return held_; }
+    void keep() { held_ = false; }
+
+private:
+    const Items& items_;
+    bool held_ = false;
+};
+
+bool all_tracked(const Items& items) {
+    auto& ledger = server::StockCommitter::instance().ledger();
+    for (const auto& [productId, qty] : items) {
+        if (qty >= 1 && !ledger.contains(productId)) return false;
+    }
+    return true;
+}
+
+// The commit of order `orderId` failed without saying whether it happened.
+// True if the order is in. Otherwise the units are only given back once it
+// is known to be missing: if even that cannot be checked they stay reserved,
+// which under-sells them until a restart reloads the ledger but never sells
+// a unit twice.
+bool settle_in_doubt(StockReservation& stock, int orderId) {
+    try {
+        auto conn = Database::instance().acquire();
+        pqxx::work txn(*conn);
+        bool found = !txn.exec_prepared("order_exists", orderId).empty();
+        txn.commit();
+        return found;  // not found: ~StockReservation releases
+    } catch (std::exception& e) {
+        std::cerr << "Order " << orderId << ": commit in doubt, keeping its stock reserved: " << e.what() << std::endl;
+        stock.keep();
+        return false;
+    }
+}
 
-            double total = 0;
-            for (size_t i = 0; i < items.size(); i++) {
-                auto item = items[i];
-                int productId = item["product_id"].i();
-                int qty = item["quantity"].i();
-                if (qty < 1) continue;
+// Stock ledger on: stock is checked and taken in memory, the items are
+// inserted pending, and the committer applies them to products.stock in
+// batches. The order transaction never touches a products row lock.
+crow::response create_with_ledger(int userId, const Items& items, const server::Deadline& deadline,
+                                  server::Format format) {
+    StockReservation stock(items);
+    // The usual case: every product is tracked and a sold-out one is refused without the database.
+    if (all_tracked(items)) {
+        std::string problem = stock.reserve();
+        if (!problem.empty()) return crow::response(400, response_helper::error_json(problem));
+    }
+    try {
+        auto conn = Database::instance().acquire();
+        pqxx::work txn(*conn);
+        server::apply_deadline(txn, deadline);
 
-                auto pr = txn.exec_params("SELECT price, stock FROM products WHERE id = $1", productId);
-                if (pr.empty()) {
+        if (!stock.held()) {
+            // Products added since startup: track them, then reserve.
+            auto& ledger = server::StockCommitter::instance().ledger();
+            for (const auto& [productId, qty] : items) {
+                if (qty < 1 || ledger.contains(productId)) continue;
+                deadline.check();
+                auto r = txn.exec_prepared("stock_by_product", productId);
+                if (r.empty()) {
                     txn.abort();
                     return crow::response(400, response_helper::error_json("Product not found: " + std::to_string(productId)));
                 }
-                double price = pr[0][0].as<double>();
-                int stock = pr[0][1].as<int>();
-                if (qty > stock) {
-                    txn.abort();
-                    return crow::response(400, response_helper::error_json("Insufficient stock for product " + std::to_string(productId)));
-                }
-                total += price * qty;
+                ledger.add(productId, r[0][0].as<int64_t>(), r[0][1].as<int64_t>());
             }
+            std::string problem = stock.reserve();
+            if (!problem.empty()) {
+                txn.abort();
+                return crow::response(400, response_helper::error_json(problem));
+            }
+        }
 
-            auto orderR = txn.exec_params(
-                "INSERT INTO orders (user_id, total, status) VALUES ($1, $2, 'pending') RETURNING id, created_at",
-                userId, total
-            );
-            int orderId = orderR[0][0].as<int>();
-
-            for (size_t i = 0; i < items.size(); i++) {
-                auto item = items[i];
-                int productId = item["product_id"].i();
-                int qty = item["quantity"].i();
-                if (qty < 1) continue;
-
-                auto pr = txn.exec_params("SELECT price, name FROM products WHERE id = $1", productId);
-                double price = pr[0][0].as<double>();
-
-                txn.exec_params(
-                    "INSERT INTO order_items (order_id, product_id, quantity, price_at_purchase) VALUES ($1, $2, $3, $4)",
-                    orderId, productId, qty, price
-                );
-                txn.exec_params(
-                    "UPDATE products SET stock = stock - $1 WHERE id = $2",
-                    qty, productId
-                );
+        Money total;
+        std::vector<Money> prices(items.size());
+        for (size_t i = 0; i < items.size(); i++) {
+            if (items[i].second < 1) continue;
+            deadline.check();
+            auto pr = txn.exec_prepared("order_product_price", items[i].first);
+            if (pr.empty()) {
+                txn.abort();
+                return crow::response(400, response_helper::error_json("Product not found: " + std::to_string(items[i].first)));
             }
+            prices[i] = row_mapping::money(pr[0][0]);
+            total += prices[i] * items[i].second;
+        }
+
+        deadline.check();
+        auto orderR = txn.exec_prepared("order_insert", userId, total.str());
+        int orderId = orderR[0][0].as<int>();
+        for (size_t i = 0; i < items.size(); i++) {
+            if (items[i].second < 1) continue;
+            deadline.check();
+            txn.exec_prepared("order_item_insert_pending", orderId, items[i].first, items[i].second, prices[i].str());
+        }
 
-            txn.exec_params("DELETE FROM cart_items WHERE user_id = $1", userId);
+        deadline.check();
+        txn.exec_prepared("cart_clear", userId);
+        try {
             txn.commit();
+        } catch (const pqxx::in_doubt_error&) {
+            if (!settle_in_doubt(stock, orderId)) throw;
+        } catch (const pqxx::broken_connection&) {
+            if (!settle_in_doubt(stock, orderId)) throw;
+        }
+        stock.keep();
+        server::StockCommitter::instance().committed();
+
+        return created_response(format, orderId, total);
+    } catch (std::exception& e) {
+        return server::db_error_response(e, deadline);
+    }
+}
 
-            std::string data = "{\"order_id\":" + std::to_string(orderId) + ",\"total\":" + json_helper::double_to_str(total) + "}";
-            return crow::response(201, response_helper::success_json(data));
-        } catch (std::exception& e) {
-            return crow::response(500, response_helper::error_json(std::string("Error: ") + e.what()));
+// Async pipeline (server/order_queue.h): reserve, journal, queue, 202.
+// nullopt sends the order down the synchronous path instead: products the
+// ledger does not track yet, or a journal that cannot be written.
+std::optional<crow::response> queue_order(int userId, const Items& items, server::Format format) {
+    Items ordered;
+    for (const auto& item : items) {
+        if (item.second >= 1) ordered.push_back(item);
+    }
+    if (ordered.empty() || !all_tracked(ordered)) return std::nullopt;
+
+    StockReservation stock(ordered);
+    std::string problem = stock.reserve();
+    if (!problem.empty()) return crow::response(400, response_helper::error_json(problem));
+    try {
+        std::string token;
+        if (server::OrderQueue::instance().submit(userId, ordered, token) == server::OrderQueue::Submit::Full) {
+            crow::response busy(503, response_helper::error_json("Order queue full, retry later"));
+            busy.set_header("Retry-After", "1");
+            return busy;
+        }
+        stock.keep();
+        return accepted_response(format, token);
+    } catch (std::exception& e) {
+        std::cerr << "Order journal: " << e.what() << std::endl;
+        return std::nullopt;
+    }
+}
+
+// Stock ledger off: products rows are locked and decremented in the order
+// transaction. A product listed on several lines is checked and taken once,
+// at its total, and rows are locked in product id order so two orders over
+// the same products cannot deadlock.
+crow::response create_in_db(int userId, const Items& items, const server::Deadline& deadline, server::Format format) {
+    std::map<int, int64_t> perProduct;  // product_id -> total quantity, ascending ids
+    for (const auto& [productId, qty] : items) {
+        if (qty >= 1) perProduct[productId] += qty;
+    }
+    try {
+        auto conn = Database::instance().acquire();
+        pqxx::work txn(*conn);
+        server::apply_deadline(txn, deadline);
+
+        Money total;
+        std::map<int, Money> prices;
+        for (const auto& [productId, qty] : perProduct) {
+            deadline.check();
+            auto pr = txn.exec_prepared("order_product_stock", productId);
+            if (pr.empty()) {
+                txn.abort();
+                return crow::response(400, response_helper::error_json("Product not found: " + std::to_string(productId)));
+            }
+            Money price = row_mapping::money(pr[0][0]);
+            int64_t stock = pr[0][1].as<int64_t>();
+            if (qty > stock) {
+                txn.abort();
+                return crow::response(400, response_helper::error_json("Insufficient stock for product " + std::to_string(productId)));
+            }
+            prices[productId] = price;
+            total += price * qty;
+        }
+
+        deadline.check();
+        auto orderR = txn.exec_prepared("order_insert", userId, total.str());
+        int orderId = orderR[0][0].as<int>();
+
+        for (const auto& [productId, qty] : items) {
+            if (qty < 1) continue;
+            deadline.check();
+            txn.exec_prepared("order_item_insert", orderId, productId, qty, prices[productId].str());
         }
+        std::vector<std::pair<int, int64_t>> stockLeft;
+        for (const auto& [productId, qty] : perProduct) {
+            deadline.check();
+            // Guarded by stock >= qty as well as the row lock; no row back means not enough.
+            auto left = txn.exec_prepared("product_stock_decrement", qty, productId);
+            if (left.empty()) {
+                txn.abort();
+                return crow::response(400, response_helper::error_json("Insufficient stock for product " + std::to_string(productId)));
+            }
+            stockLeft.emplace_back(productId, left[0][0].as<int64_t>());
+        }
+
+        deadline.check();
+        txn.exec_prepared("cart_clear", userId);
+        txn.commit();
+        server::ProductStore::instance().apply_stock(stockLeft);
+
+        return created_response(format, orderId, total);
+    } catch (std::exception& e) {
+        return server::db_error_response(e, deadline);
+    }
+}
+
+} // namespace
+
+void register_routes(server::App& app) {
+    CROW_ROUTE(app, "/api/orders/create")
+        .methods("POST"_method)
+    ([](const crow::request& req, crow::response& res) {
+        server::OrderPayload body;
+        std::string error = server::parse_order_payload(req.body, body);
+        if (!error.empty()) {
+            return server::respond(res, crow::response(400, response_helper::error_json(error)));
+        }
+        if (!body.user_id || !body.has_items) {
+            return server::respond(res, crow::response(400, response_helper::error_json("Missing user_id or items")));
+        }
+        if (body.items.empty()) {
+            return server::respond(res, crow::response(400, response_helper::error_json("No items in order")));
+        }
+        int userId = *body.user_id;
+        Items items = std::move(body.items);
+
+        auto deadline = server::Deadline::for_request(req, "orders.create");
+        auto format = server::request_format(req);
+        bool async = prefers_async(req) && server::OrderQueue::instance().enabled();
+        server::run_db(res, server::Priority::Checkout, [userId, items, deadline, format, async] {
+            if (async) {
+                if (auto queued = queue_order(userId, items, format)) return std::move(*queued);
+            }
+            if (server::StockCommitter::instance().enabled()) return create_with_ledger(userId, items, deadline, format);
+            return create_in_db(userId, items, deadline, format);
+        });
+    });
+
+    // Orders accepted with 202: queued, committed (with order_id and total) or failed (with error).
+    CROW_ROUTE(app, "/api/orders/status/<string>")
+        .methods("GET"_method)
+    ([](const crow::request& req, crow::response& res, const std::string& token) {
+        auto format = server::request_format(req);
+        if (!valid_token(token)) {
+            return server::respond(res, crow::response(404, response_helper::error_json("Unknown order token")));
+        }
+        if (auto status = server::OrderQueue::instance().status(token)) {
+            return server::respond(res, status_response(format, token, *status));
+        }
+        if (!db_statements::enabled(db_statements::Feature::OrderQueue)) {
+            return server::respond(res, crow::response(404, response_helper::error_json("Unknown order token")));
+        }
+        // From an earlier run, or finished too long ago to be kept in memory.
+        auto deadline = server::Deadline::for_request(req, "orders.status");
+        server::run_db(res, server::Priority::Catalog, [token, deadline, format] {
+            try {
+                auto conn = Database::instance().acquire();
+                pqxx::work txn(*conn);
+                server::apply_deadline(txn, deadline);
+                auto r = txn.exec_prepared("order_by_token", token);
+                txn.commit();
+                if (r.empty()) return crow::response(404, response_helper::error_json("Unknown order token"));
+                server::OrderStatus s;
+                s.state = server::OrderState::Committed;
+                s.order_id = r[0][0].as<int>();
+                s.total = row_mapping::money(r[0][1]);
+                return status_response(format, token, s);
+            } catch (std::exception& e) {
+                return server::db_error_response(e, deadline);
+            }
+        });
     });
 
     CROW_ROUTE(app, "/api/orders/<int>")
         .methods("GET"_method)
-    ([](int userId) {
-        try {
-            auto& db = Database::instance().getConnection();
-            pqxx::work txn(db);
-            auto orders = txn.exec_params(
-                "SELECT id, user_id, total, status, created_at FROM orders WHERE user_id = $1 ORDER BY created_at DESC",
-                userId
-            );
-            txn.commit();
+    ([](const crow::request& req, crow::response& res, int userId) {
+        auto deadline = server::Deadline::for_request(req, "orders.list");
+        auto format = server::request_format(req);
+        server::run_db(res, server::Priority::Catalog, [userId, deadline, format] {
+            try {
+                // One transaction for the orders and their items (it used to be one per order).
+                return server::read_txn(deadline, [&](auto& txn) {
+                    auto orders = txn.exec_prepared("orders_by_user", userId);
 
-            std::string arr = "[";
-            for (size_t oi = 0; oi < orders.size(); oi++) {
-                if (oi > 0) arr += ",";
-                int orderId = orders[oi][0].as<int>();
-                double total = orders[oi][2].as<double>();
-                std::string status = orders[oi][3].as<std::string>();
-                std::string created = orders[oi][4].as<std::string>();
-
-                pqxx::work txn2(db);
-                auto items = txn2.exec_params(
-                    "SELECT oi.product_id, p.name, oi.quantity, oi.price_at_purchase "
-                    "FROM order_items oi JOIN products p ON oi.product_id = p.id WHERE oi.order_id = $1",
-                    orderId
-                );
-                txn2.commit();
-
-                std::string itemsArr = "[";
-                for (size_t ii = 0; ii < items.size(); ii++) {
-                    if (ii > 0) itemsArr += ",";
-                    itemsArr += "{\"product_id\":" + std::to_string(items[ii][0].as<int>()) +
-                        ",\"product_name\":" + json_helper::quote(items[ii][1].as<std::string>()) +
-                        ",\"quantity\":" + std::to_string(items[ii][2].as<int>()) +
-                        ",\"price_at_purchase\":" + json_helper::double_to_str(items[ii][3].as<double>()) + "}";
-                }
-                itemsArr += "]";
-
-                arr += "{\"id\":" + std::to_string(orderId) +
-                    ",\"user_id\":" + std::to_string(userId) +
-                    ",\"total\":" + json_helper::double_to_str(total) +
-                    ",\"status\":\"" + json_helper::escape(status) + "\"" +
-                    ",\"created_at\":\"" + json_helper::escape(created) + "\"" +
-                    ",\"items\":" + itemsArr + "}";
+                    std::vector<Order> list;
+                    list.reserve(orders.size());
+                    for (const auto& row : orders) {
+                        Order o = row_mapping::decode<Order>(row);
+
+                        deadline.check();
+                        auto items = txn.exec_prepared("order_items_by_order", o.id);
+
+                        o.items.reserve(items.size());
+                        for (const auto& item : items) o.items.push_back(row_mapping::decode<OrderItem>(item));
+                        list.push_back(std::move(o));
+                    }
+                    txn.commit();
+                    return server::data_response(format, 200, [&](auto& w) { schema::write_array(w, list); });
+                });
+            } catch (std::exception& e) {
+                return server::db_error_response(e, deadline);
             }
-            arr += "]";
-            return crow::response(200, response_helper::success_json(arr));
-        } catch (std::exception& e) {
-            return crow::response(500, response_helper::error_json(std::string("Error: ") + e.what()));
-        }
+        });
     });
 }
 
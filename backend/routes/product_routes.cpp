@@ -1,137 +1,339 @@
 #include "crow.h"
-#include "../db/connection.h"
+#include "../server/app.h"
+#include "../db/row_mapping.h"
 #include "../models/Product.h"
 #include "../utils/response_helper.h"
-#include "../utils/json_helper.h"
+#include "../server/db_read.h"
+#include "../server/db_task.h"
+#include "../server/deadline.h"
+#include "../server/product_store.h"
+#include "../server/product_stream.h"
+#include "../server/search_cache.h"
+#include "../server/search_term.h"
+#include "../server/single_flight.h"
+#include "../server/response_format.h"
 #include <pqxx/pqxx>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
 
 namespace product_routes {
 
-std::string product_to_json(const pqxx::row& row) {
-    int id = row[0].as<int>();
-    int cat_id = row[1].as<int>();
-    std::string name = row[2].as<std::string>();
-    std::string desc = row[3].is_null() ? "" : row[3].as<std::string>();
-    double price = row[4].as<double>();
-    std::string img = row[5].is_null() ? "" : row[5].as<std::string>();
-    int stock = row[6].as<int>();
-    std::string cat_name = row[7].is_null() ? "" : row[7].as<std::string>();
-    std::string created = row[8].is_null() ? "" : row[8].as<std::string>();
-
-    return "{\"id\":" + std::to_string(id) +
-        ",\"category_id\":" + std::to_string(cat_id) +
-        ",\"name\":" + json_helper::quote(name) +
-        ",\"description\":" + json_helper::quote(desc) +
-        ",\"price\":" + json_helper::double_to_str(price) +
-        ",\"image_url\":" + json_helper::quote(img) +
-        ",\"stock\":" + std::to_string(stock) +
-        ",\"category_name\":" + json_helper::quote(cat_name) +
-        ",\"created_at\":" + json_helper::quote(created) + "}";
+// A product list in the request's format (JSON, MessagePack or CBOR), from text or binary results.
+template <typename Result>
+crow::response products_response(server::Format format, const Result& r) {
+    return server::data_response(format, 200, [&](auto& w) { row_mapping::write_rows<Product>(w, r); });
 }
 
-void register_routes(crow::SimpleApp& app) {
+namespace {
+
+constexpr size_t MAX_LIMIT = 10000;
+constexpr size_t MAX_PREFIX = 200;
+
+// Single-flight key: statement, normalized parameter, response format.
+std::string flight_key(const char* statement, const std::string& param, server::Format format) {
+    return std::string(statement) + "|" + param + "|" + std::to_string(static_cast<int>(format));
+}
+
+crow::response cached_response(const server::CachedResponse& cached) {
+    crow::response res(200, cached.body);
+    if (!cached.content_type.empty()) res.set_header("Content-Type", cached.content_type);
+    res.set_header("Vary", "Accept");
+    return res;
+}
+
+std::string lower(std::string s) {
+    for (char& c : s) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return s;
+}
+
+bool has_store_params(const crow::request& req) {
+    for (const char* key : {"min_price", "max_price", "in_stock", "category", "sort", "limit"}) {
+        if (req.url_params.get(key)) return true;
+    }
+    return false;
+}
+
+/**
+ * ?min_price=&max_price=&in_stock=1&category=<name>&sort=price|price_desc|newest&limit=N
+ * into `q`; returns the problem for a 400, or "" if the parameters are valid.
+ */
+std::string parse_store_query(const crow::request& req, const server::ProductColumns& columns,
+                              server::ProductQuery& q) {
+    for (auto [key, bound] : {std::make_pair("min_price", &q.min_cents), std::make_pair("max_price", &q.max_cents)}) {
+        const char* v = req.url_params.get(key);
+        if (!v) continue;
+        Money m;
+        if (!Money::parse(v, m) || m.cents() < 0) return std::string(key) + " must be a price such as 19.99";
+        *bound = m.cents();
+    }
+    if (const char* v = req.url_params.get("in_stock")) {
+        if (std::strcmp(v, "1") == 0 || std::strcmp(v, "true") == 0) q.in_stock = true;
+        else if (std::strcmp(v, "0") != 0 && std::strcmp(v, "false") != 0) return "in_stock must be 1 or 0";
+    }
+    if (const char* v = req.url_params.get("category")) q.category_id = columns.category_id(v);
+    if (const char* v = req.url_params.get("sort")) {
+        if (std::strcmp(v, "price") == 0) q.sort = server::ProductQuery::Sort::Price;
+        else if (std::strcmp(v, "price_desc") == 0) q.sort = server::ProductQuery::Sort::PriceDesc;
+        else if (std::strcmp(v, "newest") == 0) q.sort = server::ProductQuery::Sort::Newest;
+        else if (std::strcmp(v, "id") != 0) return "sort must be id, price, price_desc or newest";
+    }
+    if (const char* v = req.url_params.get("limit")) {
+        char* end = nullptr;
+        long n = std::strtol(v, &end, 10);
+        if (*v == '\0' || *end != '\0' || n < 1 || n > static_cast<long>(MAX_LIMIT)) {
+            return "limit must be between 1 and " + std::to_string(MAX_LIMIT);
+        }
+        q.limit = static_cast<size_t>(n);
+    }
+    return "";
+}
+
+// Filtered/sorted lists from the in-memory catalog (server/product_store.h): no DB round trip.
+crow::response store_response(const crow::request& req) {
+    auto columns = server::ProductStore::instance().snapshot();
+    if (!columns) return crow::response(503, response_helper::error_json("Catalog not loaded"));
+    server::ProductQuery q;
+    std::string problem = parse_store_query(req, *columns, q);
+    if (!problem.empty()) return crow::response(400, response_helper::error_json(problem));
+
+    auto rows = columns->query(q);
+    server::ProductStore::instance().count_query();
+    return server::data_response(server::request_format(req), 200, [&](auto& w) {
+        w.begin_array(rows.size());
+        for (uint32_t row : rows) schema::write(w, columns->product(row));
+        w.end_array();
+    });
+}
+
+// ?prefix=&limit=: ids and names only, straight from the trie.
+crow::response suggest_response(const crow::request& req) {
+    auto index = server::ProductStore::instance().suggestions();
+    if (!index) return crow::response(503, response_helper::error_json("Catalog not loaded"));
+    const char* prefix = req.url_params.get("prefix");
+    std::string_view p = prefix ? prefix : "";
+    if (p.size() > MAX_PREFIX) return crow::response(400, response_helper::error_json("prefix is too long"));
+    size_t limit = server::SuggestIndex::TOP_K;
+    if (const char* v = req.url_params.get("limit")) {
+        char* end = nullptr;
+        long n = std::strtol(v, &end, 10);
+        if (*v == '\0' || *end != '\0' || n < 1 || n > static_cast<long>(server::SuggestIndex::TOP_K)) {
+            return crow::response(400, response_helper::error_json(
+                "limit must be between 1 and " + std::to_string(server::SuggestIndex::TOP_K)));
+        }
+        limit = static_cast<size_t>(n);
+    }
+
+    std::vector<uint32_t> hits;
+    index->suggest(p, limit, hits);
+    return server::data_response(server::request_format(req), 200, [&](auto& w) {
+        w.begin_array(hits.size());
+        for (uint32_t e : hits) {
+            w.begin_object(2);
+            w.key("id");
+            w.integer(index->entry(e).id);
+            w.key("name");
+            w.string(index->entry(e).name);
+            w.end_object();
+        }
+        w.end_array();
+    });
+}
+
+bool parse_version(const char* v, uint64_t& out) {
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long n = std::strtoull(v, &end, 10);
+    if (*v == '\0' || *v == '-' || *end != '\0' || errno == ERANGE) return false;
+    out = n;
+    return true;
+}
+
+// ?ids=1,2,3 into sorted, distinct product ids; returns the problem for a 400, or "".
+std::string parse_ids(const char* v, std::vector<int>& ids) {
+    const std::string problem = "ids must be 1 to " + std::to_string(server::ProductStream::MAX_IDS) +
+        " comma-separated product ids";
+    if (!v || *v == '\0') return problem;
+    while (true) {
+        char* end = nullptr;
+        errno = 0;
+        long n = std::strtol(v, &end, 10);
+        if (end == v || n < 1 || n > INT32_MAX || errno == ERANGE || (*end != ',' && *end != '\0')) return problem;
+        ids.push_back(static_cast<int>(n));
+        if (ids.size() > server::ProductStream::MAX_IDS) return problem;
+        if (*end == '\0') break;
+        v = end + 1;
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return "";
+}
+
+// ?since=<version>: products changed or removed since then, from the change log.
+crow::response changes_response(const crow::request& req) {
+    uint64_t since = 0;  // none: a full resync, which tells a new client the version to start from
+    if (const char* v = req.url_params.get("since")) {
+        if (!parse_version(v, since)) {
+            return crow::response(400, response_helper::error_json("since must be a catalog version"));
+        }
+    }
+    auto changes = server::ProductStore::instance().changes_since(since);
+    if (!changes.columns) return crow::response(503, response_helper::error_json("Catalog not loaded"));
+    server::ProductStore::instance().count_query();
+    return server::data_response(server::request_format(req), 200, [&](auto& w) {
+        w.begin_object(4);
+        w.key("version");
+        w.integer(static_cast<int64_t>(changes.version));
+        w.key("full_resync");
+        w.boolean(changes.full_resync);
+        w.key("changed");
+        w.begin_array(changes.changed.size());
+        for (uint32_t row : changes.changed) schema::write(w, changes.columns->product(row));
+        w.end_array();
+        w.key("removed");
+        w.begin_array(changes.removed.size());
+        for (int id : changes.removed) w.integer(id);
+        w.end_array();
+        w.end_object();
+    });
+}
+
+} // namespace
+
+void register_routes(server::App& app) {
     CROW_ROUTE(app, "/api/products")
         .methods("GET"_method)
-    ([](const crow::request&) {
-        try {
-            auto& db = Database::instance().getConnection();
-            pqxx::work txn(db);
-            auto r = txn.exec(
-                "SELECT p.id, p.category_id, p.name, p.description, p.price, p.image_url, p.stock, "
-                "c.name as cat_name, p.created_at FROM products p "
-                "LEFT JOIN categories c ON p.category_id = c.id ORDER BY p.id"
-            );
-            txn.commit();
-
-            std::string arr = "[";
-            for (size_t i = 0; i < r.size(); i++) {
-                if (i > 0) arr += ",";
-                arr += product_to_json(r[i]);
+    ([](const crow::request& req, crow::response& res) {
+        if (has_store_params(req)) return server::respond(res, store_response(req));
+        auto deadline = server::Deadline::for_request(req, "products.list");
+        auto format = server::request_format(req);
+        auto key = flight_key("products_all", "", format);
+        server::SingleFlight::instance().run(key, res, server::Priority::Catalog, [deadline, format] {
+            try {
+                return server::read_txn(deadline, [&](auto& txn) {
+                    auto r = txn.exec_prepared("products_all");
+                    txn.commit();
+
+                    return products_response(format, r);
+                });
+            } catch (std::exception& e) {
+                return server::db_error_response(e, deadline);
             }
-            arr += "]";
-            return crow::response(200, response_helper::success_json(arr));
-        } catch (std::exception& e) {
-            return crow::response(500, response_helper::error_json(std::string("Error: ") + e.what()));
+        });
+    });
+
+    // Autocomplete: answered on the HTTP thread from memory, no DB work.
+    CROW_ROUTE(app, "/api/products/suggest")
+        .methods("GET"_method)
+    ([](const crow::request& req) {
+        return suggest_response(req);
+    });
+
+    // Incremental sync: answered on the HTTP thread from the in-memory catalog.
+    CROW_ROUTE(app, "/api/products/changes")
+        .methods("GET"_method)
+    ([](const crow::request& req) {
+        return changes_response(req);
+    });
+
+    // Live stock and price: Server-Sent Events, resumed from Last-Event-ID (server/product_stream.h).
+    CROW_ROUTE(app, "/api/stream/products")
+        .methods("GET"_method)
+    ([](const crow::request& req, crow::response& res) {
+        std::vector<int> ids;
+        std::string problem = parse_ids(req.url_params.get("ids"), ids);
+        if (!problem.empty()) return server::respond(res, crow::response(400, response_helper::error_json(problem)));
+        uint64_t since = 0;
+        const std::string& last_event = req.get_header_value("Last-Event-ID");
+        const char* v = !last_event.empty() ? last_event.c_str() : req.url_params.get("since");
+        if (v && !parse_version(v, since)) {
+            return server::respond(res, crow::response(400, response_helper::error_json("Last-Event-ID must be a catalog version")));
         }
+        server::ProductStream::instance().subscribe(res, std::move(ids), since);
     });
 
     CROW_ROUTE(app, "/api/products/<int>")
         .methods("GET"_method)
-    ([](int id) {
-        try {
-            auto& db = Database::instance().getConnection();
-            pqxx::work txn(db);
-            auto r = txn.exec_params(
-                "SELECT p.id, p.category_id, p.name, p.description, p.price, p.image_url, p.stock, "
-                "c.name as cat_name, p.created_at FROM products p "
-                "LEFT JOIN categories c ON p.category_id = c.id WHERE p.id = $1",
-                id
-            );
-            txn.commit();
-
-            if (r.empty()) {
-                return crow::response(404, response_helper::error_json("Product not found"));
+    ([](const crow::request& req, crow::response& res, int id) {
+        auto deadline = server::Deadline::for_request(req, "products.get");
+        auto format = server::request_format(req);
+        auto key = flight_key("product_by_id", std::to_string(id), format);
+        server::SingleFlight::instance().run(key, res, server::Priority::Catalog, [id, deadline, format] {
+            try {
+                return server::read_txn(deadline, [&](auto& txn) {
+                    auto r = txn.exec_prepared("product_by_id", id);
+                    txn.commit();
+
+                    if (r.empty()) {
+                        return crow::response(404, response_helper::error_json("Product not found"));
+                    }
+                    return server::data_response(format, 200, [&](auto& w) { row_mapping::write_row<Product>(w, r[0]); });
+                });
+            } catch (std::exception& e) {
+                return server::db_error_response(e, deadline);
             }
-            return crow::response(200, response_helper::success_json(product_to_json(r[0])));
-        } catch (std::exception& e) {
-            return crow::response(500, response_helper::error_json(std::string("Error: ") + e.what()));
-        }
+        });
     });
 
     CROW_ROUTE(app, "/api/products/category/<string>")
         .methods("GET"_method)
-    ([](const std::string& categoryName) {
-        try {
-            auto& db = Database::instance().getConnection();
-            pqxx::work txn(db);
-            auto r = txn.exec_params(
-                "SELECT p.id, p.category_id, p.name, p.description, p.price, p.image_url, p.stock, "
-                "c.name as cat_name, p.created_at FROM products p "
-                "LEFT JOIN categories c ON p.category_id = c.id "
-                "WHERE LOWER(c.name) = LOWER($1) ORDER BY p.id",
-                categoryName
-            );
-            txn.commit();
-
-            std::string arr = "[";
-            for (size_t i = 0; i < r.size(); i++) {
-                if (i > 0) arr += ",";
-                arr += product_to_json(r[i]);
+    ([](const crow::request& req, crow::response& res, const std::string& categoryName) {
+        auto deadline = server::Deadline::for_request(req, "products.category");
+        auto format = server::request_format(req);
+        // products_by_category compares LOWER(name), so the key is case-folded too.
+        auto key = flight_key("products_by_category", lower(categoryName), format);
+        server::SingleFlight::instance().run(key, res, server::Priority::Catalog, [categoryName, deadline, format] {
+            try {
+                return server::read_txn(deadline, [&](auto& txn) {
+                    auto r = txn.exec_prepared("products_by_category", categoryName);
+                    txn.commit();
+
+                    return products_response(format, r);
+                });
+            } catch (std::exception& e) {
+                return server::db_error_response(e, deadline);
             }
-            arr += "]";
-            return crow::response(200, response_helper::success_json(arr));
-        } catch (std::exception& e) {
-            return crow::response(500, response_helper::error_json(std::string("Error: ") + e.what()));
-        }
+        });
     });
 
     CROW_ROUTE(app, "/api/products/search")
         .methods("GET"_method)
-    ([](const crow::request& req) {
-        try {
-            std::string q = req.url_params.get("q") ? req.url_params.get("q") : "";
-            auto& db = Database::instance().getConnection();
-            pqxx::work txn(db);
-            std::string search = "%" + q + "%";
-            auto r = txn.exec_params(
-                "SELECT p.id, p.category_id, p.name, p.description, p.price, p.image_url, p.stock, "
-                "c.name as cat_name, p.created_at FROM products p "
-                "LEFT JOIN categories c ON p.category_id = c.id "
-                "WHERE p.name ILIKE $1 OR p.description ILIKE $1 ORDER BY p.id",
-                search
-            );
-            txn.commit();
-
-            std::string arr = "[";
-            for (size_t i = 0; i < r.size(); i++) {
-                if (i > 0) arr += ",";
-                arr += product_to_json(r[i]);
+    ([](const crow::request& req, crow::response& res) {
+        std::string q = server::normalize_search_term(req.url_params.get("q") ? req.url_params.get("q") : "");
+        auto format = server::request_format(req);
+        auto key = flight_key("products_search", q, format);
+        // Taken before the query, so a response is never cached under a newer catalog than it saw.
+        uint64_t version = server::ProductStore::instance().version();
+        auto& cache = server::SearchCache::instance();
+        if (auto hit = cache.get(key, version)) return server::respond(res, cached_response(*hit));
+
+        auto deadline = server::Deadline::for_request(req, "products.search");
+        server::SingleFlight::instance().run(key, res, server::Priority::Catalog, [q, key, version, deadline, format] {
+            try {
+                auto response = server::read_txn(deadline, [&](auto& txn) {
+                    std::string search = "%" + q + "%";
+                    auto r = txn.exec_prepared("products_search", search);
+                    txn.commit();
+
+                    return products_response(format, r);
+                });
+                auto& cache = server::SearchCache::instance();
+                if (response.code == 200 && cache.enabled()) {
+                    cache.put(key, version, std::make_shared<const server::CachedResponse>(
+                        server::CachedResponse{response.body, response.get_header_value("Content-Type")}));
+                }
+                return response;
+            } catch (std::exception& e) {
+                return server::db_error_response(e, deadline);
             }
-            arr += "]";
-            return crow::response(200, response_helper::success_json(arr));
-        } catch (std::exception& e) {
-            return crow::response(500, response_helper::error_json(std::string("Error: ") + e.what()));
-        }
+        });
     });
 }
 
@@ -1,7 +1,8 @@
 #pragma once
 
 #include "crow.h"
+#include "../server/app.h"
 
 namespace product_routes {
-    void register_routes(crow::SimpleApp& app);
+    void register_routes(server::App& app);
 }
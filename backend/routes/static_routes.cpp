@@ -0,0 +1,37 @@
+#include "crow.h"
+#include "../server/app.h"
+#include "../server/db_task.h"
+#include "../server/static_files.h"
+#include "../utils/response_helper.h"
+#include <string>
+
+namespace static_routes {
+
+namespace {
+
+void serve(const crow::request& req, crow::response& res, const std::string& path) {
+    // Unknown API paths stay JSON 404s instead of falling back to index.html.
+    bool api = path.rfind("/api/", 0) == 0 || path.rfind("/lab/", 0) == 0;
+    if (api || !server::StaticFiles::instance().serve(req, path, res)) {
+        return server::respond(res, crow::response(404, response_helper::error_json("Not found")));
+    }
+    res.end();
+}
+
+} // namespace
+
+void register_routes(server::App& app) {
+    CROW_ROUTE(app, "/")
+        .methods("GET"_method)
+    ([](const crow::request& req, crow::response& res) {
+        serve(req, res, "/");
+    });
+
+    CROW_ROUTE(app, "/<path>")
+        .methods("GET"_method)
+    ([](const crow::request& req, crow::response& res, std::string path) {
+        serve(req, res, "/" + path);
+    });
+}
+
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "crow.h"
+#include "../server/app.h"
+
+namespace static_routes {
+    /// GET / and GET /<path> - the built frontend (server::StaticFiles) when static_dir is set.
+    /// Register after every other module: Crow picks the first registered route that matches.
+    void register_routes(server::App& app);
+}
@@ -0,0 +1,201 @@
+#include "server/admission.h"
+#include "server/lifecycle.h"
+#include "utils/response_helper.h"
+#include <algorithm>
+#include <cmath>
+
+namespace server {
+
+namespace {
+
+bool starts_with(const std::string& s, const char* prefix) {
+    return s.rfind(prefix, 0) == 0;
+}
+
+// Defaults: checkout gets the highest floor and the most patient latency
+// target; lab traffic (incl. the deliberate time_based sleeps) gets a tiny share.
+constexpr AdmissionLimits DEFAULT_LIMITS[PRIORITY_COUNT] = {
+    /* checkout */ {16, 512, 64, 500.0, 256},
+    /* catalog  */ {4, 512, 64, 150.0, 128},
+    /* lab      */ {1, 32, 8, 3000.0, 16},
+};
+
+constexpr double DECREASE_FACTOR = 0.8;
+
+} // namespace
+
+bool admission_class_for(const std::string& url, Priority& out) {
+    if (starts_with(url, "/api/metrics")) return false;
+    // Streams park for up to stream_hold_ms without DB work (server/product_stream.h).
+    if (starts_with(url, "/api/stream/")) return false;
+    if (url == "/api/orders/create" || url == "/api/cart/add" || url == "/api/cart/remove" ||
+        url == "/api/cart/update_quantity" || starts_with(url, "/api/auth/")) {
+        out = Priority::Checkout;
+        return true;
+    }
+    if (starts_with(url, "/lab/") || starts_with(url, "/api/lab/")) {
+        out = Priority::Lab;
+        return true;
+    }
+    if (starts_with(url, "/api/")) {
+        out = Priority::Catalog;
+        return true;
+    }
+    return false;
+}
+
+bool admission_limits(Priority p, const std::map<std::string, int>& overrides, AdmissionLimits& out, std::string& error) {
+    AdmissionLimits l = DEFAULT_LIMITS[static_cast<size_t>(p)];
+    for (const auto& [key, value] : overrides) {
+        if (key == "min_limit") l.min_limit = value;
+        else if (key == "max_limit") l.max_limit = value;
+        else if (key == "initial_limit") l.initial_limit = value;
+        else if (key == "target_ms") l.target_ms = value;
+        else if (key == "max_queue") l.max_queue = static_cast<uint64_t>(value);
+        else {
+            error = "unknown key \"" + key + "\" (expected min_limit, max_limit, initial_limit, target_ms or max_queue)";
+            return false;
+        }
+    }
+    if (l.min_limit < 1 || l.min_limit > l.max_limit) {
+        error = "min_limit must be at least 1 and at most max_limit";
+        return false;
+    }
+    if (l.target_ms < 1) {
+        error = "target_ms must be at least 1";
+        return false;
+    }
+    out = l;
+    return true;
+}
+
+AdmissionControl::Classes& AdmissionControl::shared_classes() {
+    static Classes classes;
+    static std::once_flag defaults;
+    // Not in the constructor: main() may have configured the limits before any App exists.
+    std::call_once(defaults, [] {
+        for (size_t i = 0; i < PRIORITY_COUNT; i++) {
+            ClassState& c = classes[i];
+            const AdmissionLimits& l = DEFAULT_LIMITS[i];
+            c.limits = l;
+            c.min_limit = l.min_limit;
+            c.max_queue = l.max_queue;
+            c.target_ms = l.target_ms;
+            c.limit_f = std::clamp(static_cast<double>(l.initial_limit), static_cast<double>(l.min_limit),
+                                   static_cast<double>(l.max_limit));
+            c.limit = static_cast<int>(c.limit_f);
+        }
+    });
+    return classes;
+}
+
+AdmissionControl::AdmissionControl() : classes_(shared_classes()) {}
+
+void AdmissionControl::set_limits(Priority p, const AdmissionLimits& limits) {
+    ClassState& c = shared_classes()[static_cast<size_t>(p)];
+    std::lock_guard<std::mutex> lock(c.mu);
+    bool restart = c.limits.initial_limit != limits.initial_limit;
+    c.limits = limits;
+    c.min_limit = limits.min_limit;
+    c.max_queue = limits.max_queue;
+    c.target_ms = limits.target_ms;
+    // A new initial_limit restarts from it; otherwise keep what the class has learned.
+    double from = restart ? static_cast<double>(limits.initial_limit) : c.limit_f;
+    c.limit_f = std::clamp(from, static_cast<double>(limits.min_limit), static_cast<double>(limits.max_limit));
+    c.limit = static_cast<int>(c.limit_f);
+}
+
+bool AdmissionControl::try_acquire(Priority p) {
+    ClassState& c = classes_[static_cast<size_t>(p)];
+    DbExecutor& executor = DbExecutor::instance();
+    if (executor.depth(p) > c.max_queue.load(std::memory_order_relaxed)) return false;
+
+    int limit = c.limit.load(std::memory_order_relaxed);
+    if (p != Priority::Checkout && executor.depth(Priority::Checkout) > 0) {
+        limit = std::min(limit, c.min_limit.load(std::memory_order_relaxed));
+    }
+    int cur = c.inflight.load(std::memory_order_relaxed);
+    while (cur < limit) {
+        if (c.inflight.compare_exchange_weak(cur, cur + 1)) return true;
+    }
+    return false;
+}
+
+void AdmissionControl::on_complete(Priority p, double latency_ms, int status) {
+    ClassState& c = classes_[static_cast<size_t>(p)];
+    int inflight = c.inflight.fetch_sub(1);
+    c.last_latency_us = static_cast<uint64_t>(latency_ms * 1000.0);
+
+    auto now = std::chrono::steady_clock::now();
+    bool congested = latency_ms > c.target_ms.load(std::memory_order_relaxed) || status == 503 || status == 504;
+    std::lock_guard<std::mutex> lock(c.mu);
+    if (congested) {
+        auto since = std::chrono::duration<double, std::milli>(now - c.last_decrease).count();
+        if (since < c.limits.target_ms) return;  // one decrease per congestion episode
+        c.limit_f = std::max(static_cast<double>(c.limits.min_limit), c.limit_f * DECREASE_FACTOR);
+        c.last_decrease = now;
+    } else if (inflight * 2 >= static_cast<int>(c.limit_f)) {
+        // Only grow while the limit is actually being used.
+        c.limit_f = std::min(static_cast<double>(c.limits.max_limit), c.limit_f + 1.0 / c.limit_f);
+    }
+    c.limit = static_cast<int>(c.limit_f);
+}
+
+void AdmissionControl::before_handle(crow::request& req, crow::response& res, context& ctx) {
+    Lifecycle& life = Lifecycle::instance();
+    bool probe = req.url == "/healthz" || req.url == "/readyz" || starts_with(req.url, "/api/metrics");
+    if (life.draining() && !probe) {
+        res.code = 503;
+        res.body = response_helper::error_json("Server shutting down");
+        res.add_header("Retry-After", "1");
+        res.add_header("Connection", "close");
+        res.end();
+        return;
+    }
+    life.request_started();
+    ctx.counted = true;
+
+    Priority p;
+    if (!admission_class_for(req.url, p)) return;
+    if (!try_acquire(p)) {
+        ClassState& c = classes_[static_cast<size_t>(p)];
+        c.rejected++;
+        life.request_finished();
+        ctx.counted = false;
+        int retry_s = std::max(1, static_cast<int>(std::ceil(c.target_ms.load(std::memory_order_relaxed) / 1000.0)));
+        res.code = 503;
+        res.body = response_helper::error_json("Server busy, retry later");
+        res.add_header("Retry-After", std::to_string(retry_s));
+        res.end();
+        return;
+    }
+    classes_[static_cast<size_t>(p)].admitted++;
+    ctx.cls = static_cast<int>(p);
+    ctx.start = std::chrono::steady_clock::now();
+}
+
+void AdmissionControl::after_handle(crow::request&, crow::response& res, context& ctx) {
+    if (ctx.counted) {
+        Lifecycle& life = Lifecycle::instance();
+        if (life.draining()) res.add_header("Connection", "close");
+        life.request_finished();
+        ctx.counted = false;
+    }
+    if (ctx.cls < 0) return;
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - ctx.start).count();
+    on_complete(static_cast<Priority>(ctx.cls), ms, res.code);
+    ctx.cls = -1;
+}
+
+AdmissionClassMetrics AdmissionControl::metrics(Priority p) const {
+    const ClassState& c = classes_[static_cast<size_t>(p)];
+    AdmissionClassMetrics m;
+    m.inflight = c.inflight.load();
+    m.limit = c.limit.load();
+    m.admitted = c.admitted.load();
+    m.rejected = c.rejected.load();
+    m.last_latency_ms = static_cast<double>(c.last_latency_us.load()) / 1000.0;
+    return m;
+}
+
+} // namespace server
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "crow.h"
+#include "server/db_executor.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace server {
+
+/// Limits for one admission class. The concurrency limit adapts between
+/// min_limit and max_limit; latency above target_ms counts as congestion.
+struct AdmissionLimits {
+    int min_limit;
+    int max_limit;
+    int initial_limit;
+    double target_ms;
+    /// Reject when more than this many tasks of the class wait in the DB executor.
+    uint64_t max_queue;
+};
+
+/**
+ * The built-in limits for class `p` with `overrides` (admission_checkout,
+ * admission_catalog, admission_lab in db_config.json) applied on top. Keys:
+ * min_limit, max_limit, initial_limit, target_ms, max_queue. False, with the
+ * reason in `error`, for an unknown key or min_limit > max_limit.
+ */
+bool admission_limits(Priority p, const std::map<std::string, int>& overrides, AdmissionLimits& out, std::string& error);
+
+struct AdmissionClassMetrics {
+    int inflight = 0;
+    int limit = 0;
+    uint64_t admitted = 0;
+    uint64_t rejected = 0;
+    double last_latency_ms = 0;
+};
+
+/// Map a request path to its admission class. Returns false for paths that are
+/// never shed (/api/metrics, unknown routes that 404 without touching the DB).
+bool admission_class_for(const std::string& url, Priority& out);
+
+/**
+ * Crow middleware: per-class adaptive concurrency limits in front of the
+ * route handlers. Classes mirror the DB executor priorities (checkout,
+ * catalog, lab). Each class keeps an in-flight count and an AIMD limit:
+ * a completion under the latency target grows the limit by 1/limit, one over
+ * target (or a 503/504) shrinks it by 20%, at most once per target interval.
+ * Requests over the limit, or whose class already has max_queue tasks waiting
+ * in the executor, are answered immediately with 503 + Retry-After instead of
+ * queueing behind a slow database.
+ *
+ * Checkout is protected over catalog: it starts with a higher floor and,
+ * while checkout work is queued in the executor, catalog and lab are held to
+ * their min_limit so the shared connections drain towards orders first.
+ *
+ * It also enforces shutdown draining (server/lifecycle.h): while draining,
+ * everything except the health probes and /api/metrics gets 503 with
+ * Connection: close, and every handled request is counted as in flight.
+ *
+ * Limits and counters are process-wide: every App instance (see
+ * ServeOptions::instances) shares one set, so N acceptors do not multiply them.
+ *
+ * after_handle runs when the response completes, which for async routes is
+ * on the executor thread after the DB work; latency therefore covers the
+ * queueing and the query, not just the HTTP thread's share.
+ */
+class AdmissionControl {
+public:
+    struct context {
+        bool counted = false;  // included in Lifecycle::inflight()
+        int cls = -1;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    AdmissionControl();
+
+    /// Process-wide (all App instances). At a reload, the adapted limit is kept, clamped to the new range.
+    static void set_limits(Priority p, const AdmissionLimits& limits);
+
+    void before_handle(crow::request& req, crow::response& res, context& ctx);
+    void after_handle(crow::request& req, crow::response& res, context& ctx);
+
+    AdmissionClassMetrics metrics(Priority p) const;
+
+private:
+    struct ClassState {
+        AdmissionLimits limits{};  // guarded by mu; the hot path reads the copies below
+        std::atomic<int> min_limit{0};
+        std::atomic<uint64_t> max_queue{0};
+        std::atomic<double> target_ms{0};
+        std::atomic<int> inflight{0};
+        std::atomic<int> limit{0};
+        std::atomic<uint64_t> admitted{0};
+        std::atomic<uint64_t> rejected{0};
+        std::atomic<uint64_t> last_latency_us{0};
+
+        std::mutex mu;  // guards the fractional limit and decrease timestamp
+        double limit_f = 0;
+        std::chrono::steady_clock::time_point last_decrease;
+    };
+
+    using Classes = std::array<ClassState, PRIORITY_COUNT>;
+    static Classes& shared_classes();
+
+    bool try_acquire(Priority p);
+    void on_complete(Priority p, double latency_ms, int status);
+
+    Classes& classes_;
+};
+
+} // namespace server
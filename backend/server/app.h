@@ -0,0 +1,15 @@
+#pragma once
+
+#include "crow.h"
+#include "server/admission.h"
+#include "server/request_limits.h"
+#include "server/response_compression.h"
+
+namespace server {
+
+/// Crow application type used by main.cpp and every routes module. Middleware
+/// runs in this order: size limits, admission control, then (on the way out)
+/// response compression.
+using App = crow::App<RequestLimits, AdmissionControl, ResponseCompression>;
+
+} // namespace server
@@ -0,0 +1,231 @@
+#include "server/body_parser.h"
+#include <climits>
+#include <cstdint>
+
+namespace server {
+
+namespace {
+
+constexpr int MAX_DEPTH = 32;
+const char* const INVALID = "Invalid JSON body";
+
+bool digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+bool hex_digit(char c) {
+    return digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+// Cursor over the body. Every method skips leading whitespace and, on
+// failure, leaves the position wherever parsing stopped.
+class Reader {
+public:
+    explicit Reader(std::string_view s) : p_(s.data()), end_(s.data() + s.size()) {}
+
+    bool done() {
+        ws();
+        return p_ == end_;
+    }
+    bool peek(char c) {
+        ws();
+        return p_ < end_ && *p_ == c;
+    }
+    bool eat(char c) {
+        if (!peek(c)) return false;
+        p_++;
+        return true;
+    }
+
+    /// A string token; `out` is the raw text between the quotes (escapes validated, not decoded).
+    bool string(std::string_view& out) {
+        if (!eat('"')) return false;
+        const char* start = p_;
+        for (; p_ < end_; p_++) {
+            char c = *p_;
+            if (c == '"') {
+                out = std::string_view(start, static_cast<size_t>(p_ - start));
+                p_++;
+                return true;
+            }
+            if (static_cast<unsigned char>(c) < 0x20) return false;
+            if (c != '\\') continue;
+            if (++p_ == end_) return false;
+            switch (*p_) {
+            case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+                break;
+            case 'u':
+                for (int i = 0; i < 4; i++) {
+                    if (++p_ == end_ || !hex_digit(*p_)) return false;
+                }
+                break;
+            default:
+                return false;
+            }
+        }
+        return false;
+    }
+
+    enum class Num { Integer, Fraction, NotNumber, Invalid };
+
+    /// A JSON number. Integers beyond int64 saturate, which callers treat as out of range.
+    Num number(int64_t& value) {
+        ws();
+        const char* p = p_;
+        bool neg = p < end_ && *p == '-';
+        if (neg) p++;
+        if (p == end_ || !digit(*p)) return neg ? Num::Invalid : Num::NotNumber;
+        int64_t v = 0;
+        if (*p == '0') {
+            p++;
+        } else {
+            for (; p < end_ && digit(*p); p++) v = v > (INT64_MAX - 9) / 10 ? INT64_MAX : v * 10 + (*p - '0');
+        }
+        bool fraction = false;
+        if (p < end_ && *p == '.') {
+            if (++p == end_ || !digit(*p)) return Num::Invalid;
+            while (p < end_ && digit(*p)) p++;
+            fraction = true;
+        }
+        if (p < end_ && (*p == 'e' || *p == 'E')) {
+            if (++p < end_ && (*p == '+' || *p == '-')) p++;
+            if (p == end_ || !digit(*p)) return Num::Invalid;
+            while (p < end_ && digit(*p)) p++;
+            fraction = true;
+        }
+        p_ = p;
+        value = neg ? -v : v;
+        return fraction ? Num::Fraction : Num::Integer;
+    }
+
+    /// Any JSON value, validated and discarded.
+    bool skip_value(int depth) {
+        if (depth > MAX_DEPTH || !peek_any()) return false;
+        switch (*p_) {
+        case '"': {
+            std::string_view s;
+            return string(s);
+        }
+        case '{':
+            p_++;
+            if (eat('}')) return true;
+            do {
+                std::string_view key;
+                if (!string(key) || !eat(':') || !skip_value(depth + 1)) return false;
+            } while (eat(','));
+            return eat('}');
+        case '[':
+            p_++;
+            if (eat(']')) return true;
+            do {
+                if (!skip_value(depth + 1)) return false;
+            } while (eat(','));
+            return eat(']');
+        case 't': return literal("true");
+        case 'f': return literal("false");
+        case 'n': return literal("null");
+        default: {
+            int64_t v = 0;
+            Num n = number(v);
+            return n == Num::Integer || n == Num::Fraction;
+        }
+        }
+    }
+
+private:
+    void ws() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r')) p_++;
+    }
+    bool peek_any() {
+        ws();
+        return p_ < end_;
+    }
+    bool literal(std::string_view word) {
+        if (static_cast<size_t>(end_ - p_) < word.size() || std::string_view(p_, word.size()) != word) return false;
+        p_ += word.size();
+        return true;
+    }
+
+    const char* p_;
+    const char* end_;
+};
+
+// Walk an object's members; `member(key)` consumes the value and returns "" or an error.
+template <typename Member>
+std::string object(Reader& r, Member&& member) {
+    if (!r.eat('{')) return INVALID;
+    if (r.eat('}')) return "";
+    do {
+        std::string_view key;
+        if (!r.string(key) || !r.eat(':')) return INVALID;
+        std::string error = member(key);
+        if (!error.empty()) return error;
+    } while (r.eat(','));
+    return r.eat('}') ? "" : INVALID;
+}
+
+std::string int_field(Reader& r, const char* name, std::optional<int>& out) {
+    if (out) return std::string("Duplicate key: ") + name;
+    int64_t v = 0;
+    switch (r.number(v)) {
+    case Reader::Num::Integer:
+        if (v < INT_MIN || v > INT_MAX) return std::string(name) + " is out of range";
+        out = static_cast<int>(v);
+        return "";
+    case Reader::Num::Invalid:
+        return INVALID;
+    default:
+        return std::string(name) + " must be an integer";
+    }
+}
+
+std::string skip(Reader& r) {
+    return r.skip_value(1) ? "" : INVALID;
+}
+
+std::string parse_items(Reader& r, OrderPayload& out) {
+    if (out.has_items) return "Duplicate key: items";
+    out.has_items = true;
+    if (!r.eat('[')) return "items must be an array";
+    if (r.eat(']')) return "";
+    do {
+        if (!r.peek('{')) return "Each item must be an object";
+        std::optional<int> product_id, quantity;
+        std::string error = object(r, [&](std::string_view key) {
+            if (key == "product_id") return int_field(r, "product_id", product_id);
+            if (key == "quantity") return int_field(r, "quantity", quantity);
+            return skip(r);
+        });
+        if (!error.empty()) return error;
+        if (!product_id || !quantity) return "Each item needs product_id and quantity";
+        out.items.emplace_back(*product_id, *quantity);
+    } while (r.eat(','));
+    return r.eat(']') ? "" : INVALID;
+}
+
+} // namespace
+
+std::string parse_cart_payload(std::string_view body, CartPayload& out) {
+    Reader r(body);
+    std::string error = object(r, [&](std::string_view key) {
+        if (key == "user_id") return int_field(r, "user_id", out.user_id);
+        if (key == "product_id") return int_field(r, "product_id", out.product_id);
+        if (key == "quantity") return int_field(r, "quantity", out.quantity);
+        return skip(r);
+    });
+    if (error.empty() && !r.done()) error = INVALID;
+    return error;
+}
+
+std::string parse_order_payload(std::string_view body, OrderPayload& out) {
+    Reader r(body);
+    std::string error = object(r, [&](std::string_view key) {
+        if (key == "user_id") return int_field(r, "user_id", out.user_id);
+        if (key == "items") return parse_items(r, out);
+        return skip(r);
+    });
+    if (error.empty() && !r.done()) error = INVALID;
+    return error;
+}
+
+} // namespace server
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace server {
+
+/// Body of POST /api/cart/add, /api/cart/remove and /api/cart/update_quantity.
+struct CartPayload {
+    std::optional<int> user_id;
+    std::optional<int> product_id;
+    std::optional<int> quantity;
+};
+
+/// Body of POST /api/orders/create.
+struct OrderPayload {
+    std::optional<int> user_id;
+    bool has_items = false;
+    std::vector<std::pair<int, int>> items;  // (product_id, quantity)
+};
+
+/**
+ * Schema-specific parsers for the cart and order bodies: one pass over the
+ * bytes, no DOM, no allocation beyond the items vector. The body must be a
+ * single JSON object. Known keys must hold JSON integers in int range —
+ * strings ("1"), fractions (2.5), exponents (1e3) and out-of-range numbers are
+ * rejected, as are duplicate known keys. Other keys are skipped (their values
+ * must still be valid JSON, nested at most 32 deep). Keys are matched as
+ * written, so an escaped spelling of a known key counts as unknown.
+ *
+ * Return "" on success, else a message for the 400 response. Missing keys are
+ * not an error here: the fields stay empty and the route decides.
+ */
+std::string parse_cart_payload(std::string_view body, CartPayload& out);
+
+/// Same rules; `items` must be an array of objects with product_id and quantity.
+std::string parse_order_payload(std::string_view body, OrderPayload& out);
+
+} // namespace server
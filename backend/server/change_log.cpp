@@ -0,0 +1,62 @@
+#include "server/change_log.h"
+#include <limits>
+
+namespace server {
+
+void ChangeLog::reset(uint64_t version) {
+    by_version_.clear();
+    latest_.clear();
+    floor_ = version;
+}
+
+void ChangeLog::set_max_entries(size_t max_entries) {
+    max_entries_ = max_entries;
+    trim();
+}
+
+void ChangeLog::record(uint64_t version, int product_id, bool removed) {
+    auto it = latest_.find(product_id);
+    if (it != latest_.end()) {
+        by_version_.erase({it->second, product_id});
+        it->second = version;
+        compacted_++;
+    } else {
+        latest_.emplace(product_id, version);
+    }
+    by_version_[{version, product_id}] = removed;
+    recorded_++;
+    trim();
+}
+
+void ChangeLog::trim() {
+    while (by_version_.size() > max_entries_) {
+        auto oldest = by_version_.begin();
+        // A reader at oldest's version or later has already seen this change.
+        if (oldest->first.first > floor_) floor_ = oldest->first.first;
+        latest_.erase(oldest->first.second);
+        by_version_.erase(oldest);
+        dropped_++;
+    }
+}
+
+bool ChangeLog::since(uint64_t since, std::vector<ProductChange>& out) const {
+    out.clear();
+    if (since < floor_) return false;
+    for (auto it = by_version_.upper_bound({since, std::numeric_limits<int>::max()}); it != by_version_.end(); ++it) {
+        out.push_back({it->first.first, it->first.second, it->second});
+    }
+    return true;
+}
+
+ChangeLogMetrics ChangeLog::metrics() const {
+    ChangeLogMetrics m;
+    m.entries = by_version_.size();
+    m.max_entries = max_entries_;
+    m.floor = floor_;
+    m.recorded = recorded_;
+    m.compacted = compacted_;
+    m.dropped = dropped_;
+    return m;
+}
+
+} // namespace server
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace server {
+
+/// One product's latest change: its new state is in the snapshot of that version, or it was removed.
+struct ProductChange {
+    uint64_t version;
+    int product_id;
+    bool removed;
+};
+
+struct ChangeLogMetrics {
+    size_t entries = 0;
+    size_t max_entries = 0;
+    uint64_t floor = 0;       // oldest `since` that can still be answered
+    uint64_t recorded = 0;
+    uint64_t compacted = 0;   // entries replaced by a newer change to the same product
+    uint64_t dropped = 0;     // oldest entries dropped to stay under max_entries
+};
+
+/**
+ * The catalog change log behind /api/products/changes. Each catalog version
+ * (ProductStore::version()) records the products that changed or disappeared
+ * in it. A reader asks for everything after the version it last saw and
+ * fetches the current state of those products, so only a product's latest
+ * change matters: recording a product again drops its older entry, and the
+ * log holds at most one entry per product.
+ *
+ * Past max_entries the oldest entries are dropped and the floor moves up to
+ * their version. A reader behind the floor (or from before reset()) may have
+ * missed a change and has to reload the whole catalog.
+ *
+ * Not thread-safe; ProductStore guards it with its own mutex.
+ */
+class ChangeLog {
+public:
+    explicit ChangeLog(size_t max_entries) : max_entries_(max_entries) {}
+
+    /// Forget everything: readers from before `version` must reload.
+    void reset(uint64_t version);
+    void set_max_entries(size_t max_entries);
+    /// `product_id` changed (or was removed) in `version`; versions never decrease.
+    void record(uint64_t version, int product_id, bool removed);
+
+    /// The changes after `since`, oldest first, into `out`. False if `since` is behind the floor.
+    bool since(uint64_t since, std::vector<ProductChange>& out) const;
+    uint64_t floor() const { return floor_; }
+    ChangeLogMetrics metrics() const;
+
+private:
+    void trim();
+
+    size_t max_entries_;
+    uint64_t floor_ = 0;
+    std::map<std::pair<uint64_t, int>, bool> by_version_;  // (version, product id) -> removed
+    std::unordered_map<int, uint64_t> latest_;              // product id -> its entry's version
+    uint64_t recorded_ = 0;
+    uint64_t compacted_ = 0;
+    uint64_t dropped_ = 0;
+};
+
+} // namespace server
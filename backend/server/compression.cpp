@@ -0,0 +1,161 @@
+#include "server/compression.h"
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+
+namespace server {
+
+namespace {
+
+constexpr size_t SLICE = 64 * 1024;
+
+size_t entry_bytes(const std::string& source, const std::string& compressed) {
+    return source.size() + compressed.size();
+}
+
+} // namespace
+
+const char* encoding_name(Encoding e) {
+    switch (e) {
+    case Encoding::Gzip: return "gzip";
+    case Encoding::Deflate: return "deflate";
+    default: return "";
+    }
+}
+
+bool accepts_encoding(const std::string& accept_encoding, const std::string& name) {
+    std::stringstream ss(accept_encoding);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        size_t b = item.find_first_not_of(" \t");
+        if (b == std::string::npos) continue;
+        size_t semi = item.find(';', b);
+        std::string token = item.substr(b, semi == std::string::npos ? std::string::npos : semi - b);
+        while (!token.empty() && (token.back() == ' ' || token.back() == '\t')) token.pop_back();
+        if (token != name && token != "*") continue;
+        size_t q = item.find("q=", b);
+        return q == std::string::npos || std::strtod(item.c_str() + q + 2, nullptr) > 0;
+    }
+    return false;
+}
+
+Encoding negotiate_encoding(const std::string& accept_encoding) {
+    if (accept_encoding.empty()) return Encoding::Identity;
+    if (accepts_encoding(accept_encoding, "gzip")) return Encoding::Gzip;
+    if (accepts_encoding(accept_encoding, "deflate")) return Encoding::Deflate;
+    return Encoding::Identity;
+}
+
+Deflater::Deflater(Encoding e, int level) {
+    // windowBits 15 = zlib container ("deflate" in HTTP); +16 = gzip container.
+    int window_bits = e == Encoding::Gzip ? 15 + 16 : 15;
+    if (deflateInit2(&zs_, std::clamp(level, 1, 9), Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        throw std::runtime_error("deflateInit2 failed");
+}
+
+Deflater::~Deflater() {
+    deflateEnd(&zs_);
+}
+
+void Deflater::run(const char* data, size_t n, int mode, std::string& out) {
+    zs_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    zs_.avail_in = static_cast<uInt>(n);
+    char buf[SLICE];
+    do {
+        zs_.next_out = reinterpret_cast<Bytef*>(buf);
+        zs_.avail_out = sizeof(buf);
+        deflate(&zs_, mode);
+        out.append(buf, sizeof(buf) - zs_.avail_out);
+    } while (zs_.avail_out == 0);
+}
+
+void Deflater::write(const char* data, size_t n, std::string& out) {
+    while (n > 0) {
+        size_t chunk = std::min(n, SLICE);
+        run(data, chunk, Z_NO_FLUSH, out);
+        data += chunk;
+        n -= chunk;
+    }
+}
+
+void Deflater::flush(std::string& out) {
+    run(nullptr, 0, Z_SYNC_FLUSH, out);
+}
+
+void Deflater::finish(std::string& out) {
+    run(nullptr, 0, Z_FINISH, out);
+}
+
+std::string compress(const std::string& body, Encoding e, int level) {
+    std::string out;
+    out.reserve(body.size() / 4 + 64);
+    Deflater d(e, level);
+    d.write(body.data(), body.size(), out);
+    d.finish(out);
+    return out;
+}
+
+std::shared_ptr<const std::string> CompressedCache::get(const std::string& body, Encoding e, int level, bool* hit) {
+    size_t hash = std::hash<std::string_view>{}(body) ^ (static_cast<size_t>(e) * 0x9e3779b97f4a7c15ULL);
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        auto range = index_.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            Entry& entry = *it->second;
+            if (entry.encoding == e && *entry.source == body) {
+                lru_.splice(lru_.begin(), lru_, it->second);
+                hits_++;
+                if (hit) *hit = true;
+                return entry.compressed;
+            }
+        }
+        misses_++;
+    }
+    if (hit) *hit = false;
+
+    // Compress outside the lock; a concurrent miss on the same body just does it twice.
+    auto compressed = std::make_shared<const std::string>(compress(body, e, level));
+    std::lock_guard<std::mutex> lock(mu_);
+    size_t size = entry_bytes(body, *compressed);
+    if (size > max_bytes_) return compressed;
+    lru_.push_front({hash, e, std::make_shared<const std::string>(body), compressed});
+    index_.emplace(hash, lru_.begin());
+    bytes_ += size;
+    evict_locked();
+    return compressed;
+}
+
+void CompressedCache::set_max_bytes(size_t max_bytes) {
+    std::lock_guard<std::mutex> lock(mu_);
+    max_bytes_ = max_bytes;
+    evict_locked();
+}
+
+void CompressedCache::evict_locked() {
+    while (bytes_ > max_bytes_ && !lru_.empty()) {
+        auto last = std::prev(lru_.end());
+        auto range = index_.equal_range(last->hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == last) {
+                index_.erase(it);
+                break;
+            }
+        }
+        bytes_ -= entry_bytes(*last->source, *last->compressed);
+        lru_.erase(last);
+    }
+}
+
+CompressedCache::Stats CompressedCache::stats() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    Stats s;
+    s.hits = hits_;
+    s.misses = misses_;
+    s.bytes = bytes_;
+    s.entries = lru_.size();
+    return s;
+}
+
+} // namespace server
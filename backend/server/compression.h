@@ -0,0 +1,94 @@
+#pragma once
+
+#include <zlib.h>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace server {
+
+enum class Encoding { Identity, Gzip, Deflate };
+
+/// Content-Encoding token: "", "gzip" or "deflate".
+const char* encoding_name(Encoding e);
+
+/// True if an Accept-Encoding header lists `name` (or *) without q=0.
+bool accepts_encoding(const std::string& accept_encoding, const std::string& name);
+
+/// gzip if accepted, else deflate, else identity.
+Encoding negotiate_encoding(const std::string& accept_encoding);
+
+/**
+ * Incremental zlib compressor. "gzip" is the gzip container and "deflate"
+ * is the zlib container, as HTTP defines them. write() compresses a chunk and
+ * appends whatever output is ready. flush() forces everything written so far
+ * out as a decodable block, for streamed responses. finish() ends the stream.
+ */
+class Deflater {
+public:
+    Deflater(Encoding e, int level);
+    ~Deflater();
+    Deflater(const Deflater&) = delete;
+    Deflater& operator=(const Deflater&) = delete;
+
+    void write(const char* data, size_t n, std::string& out);
+    void flush(std::string& out);
+    void finish(std::string& out);
+
+private:
+    void run(const char* data, size_t n, int mode, std::string& out);
+
+    z_stream zs_{};
+};
+
+/// One-shot compression of `body` (fed to a Deflater in 64 KiB slices).
+std::string compress(const std::string& body, Encoding e, int level);
+
+/**
+ * Compressed variants keyed by the uncompressed bytes, so a hot response
+ * (the same catalog JSON served again and again) is compressed once. A hit
+ * costs a hash and a compare of the body, far less than deflating it.
+ * Bounded by total bytes held (sources + variants), least recently used
+ * first out. Thread-safe.
+ */
+class CompressedCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        size_t bytes = 0;
+        size_t entries = 0;
+    };
+
+    explicit CompressedCache(size_t max_bytes) : max_bytes_(max_bytes) {}
+
+    /// Compressed `body`, from the cache or by compressing it now (`*hit` says which).
+    std::shared_ptr<const std::string> get(const std::string& body, Encoding e, int level, bool* hit = nullptr);
+    void set_max_bytes(size_t max_bytes);
+    Stats stats() const;
+
+private:
+    struct Entry {
+        size_t hash;
+        Encoding encoding;
+        std::shared_ptr<const std::string> source;
+        std::shared_ptr<const std::string> compressed;
+    };
+    using Lru = std::list<Entry>;
+
+    void evict_locked();
+
+    mutable std::mutex mu_;
+    size_t max_bytes_;
+    size_t bytes_ = 0;
+    Lru lru_;  // front = most recently used
+    std::unordered_multimap<size_t, Lru::iterator> index_;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+};
+
+} // namespace server
@@ -0,0 +1,399 @@
+#include "server/config.h"
+#include "server/admission.h"
+#include "server/deadline.h"
+#include "crow.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace server {
+
+namespace {
+
+enum class Kind { Int, Bool, String, IntMap };
+
+/**
+ * One config key. `ref` returns the member it sets; `min`/`max` bound Int
+ * values and IntMap entries, and for String `min` is the minimum length.
+ */
+struct Field {
+    const char* key;
+    Kind kind;
+    bool reloadable;
+    long min;
+    long max;
+    int& (*int_ref)(AppConfig&);
+    bool& (*bool_ref)(AppConfig&);
+    std::string& (*string_ref)(AppConfig&);
+    std::map<std::string, int>& (*map_ref)(AppConfig&);
+};
+
+Field int_field(const char* key, int& (*ref)(AppConfig&), long min, long max, bool reloadable = false) {
+    return {key, Kind::Int, reloadable, min, max, ref, nullptr, nullptr, nullptr};
+}
+Field bool_field(const char* key, bool& (*ref)(AppConfig&), bool reloadable = false) {
+    return {key, Kind::Bool, reloadable, 0, 0, nullptr, ref, nullptr, nullptr};
+}
+Field string_field(const char* key, std::string& (*ref)(AppConfig&), long min_len, bool reloadable = false) {
+    return {key, Kind::String, reloadable, min_len, 0, nullptr, nullptr, ref, nullptr};
+}
+Field map_field(const char* key, std::map<std::string, int>& (*ref)(AppConfig&), long min, long max, bool reloadable) {
+    return {key, Kind::IntMap, reloadable, min, max, nullptr, nullptr, nullptr, ref};
+}
+
+#define CONFIG_REF(type, member) [](AppConfig& c) -> type& { return c.member; }
+
+// The schema. Keys are flat to keep existing db_config.json files valid.
+const std::vector<Field>& schema() {
+    static const std::vector<Field> fields = {
+        string_field("host", CONFIG_REF(std::string, db.host), 1),
+        int_field("port", CONFIG_REF(int, db.port), 1, 65535),
+        string_field("dbname", CONFIG_REF(std::string, db.dbname), 1),
+        string_field("user", CONFIG_REF(std::string, db.user), 1),
+        string_field("password", CONFIG_REF(std::string, db.password), 0),
+        string_field("lab_user", CONFIG_REF(std::string, db.lab_user), 0),
+        string_field("lab_password", CONFIG_REF(std::string, db.lab_password), 0),
+        int_field("pool_size", CONFIG_REF(int, db.pool_size), 1, 1024, true),
+        int_field("db_threads", CONFIG_REF(int, db.db_threads), 0, 1024),
+        int_field("binary_pool_size", CONFIG_REF(int, db.binary_pool_size), 0, 1024),
+        int_field("http_port", CONFIG_REF(int, http.port), 1, 65535),
+        int_field("http_workers", CONFIG_REF(int, http.workers), 0, 4096),
+        int_field("http_instances", CONFIG_REF(int, http.instances), 1, 256),
+        bool_field("pin_threads", CONFIG_REF(bool, http.pin_threads)),
+        int_field("drain_delay_ms", CONFIG_REF(int, http.drain_delay_ms), 0, 600000),
+        int_field("drain_timeout_ms", CONFIG_REF(int, http.drain_timeout_ms), 0, 600000),
+        int_field("http_idle_timeout_s", CONFIG_REF(int, http.idle_timeout_s), 1, 255),
+        int_field("http_max_body_bytes", CONFIG_REF(int, http.max_body_bytes), 1024, 1 << 30, true),
+        int_field("http_max_headers", CONFIG_REF(int, http.max_headers), 8, 1024, true),
+        bool_field("http_tcp_nodelay", CONFIG_REF(bool, http.tcp_nodelay)),
+        int_field("http_listen_backlog", CONFIG_REF(int, http.listen_backlog), 1, 65535),
+        map_field("deadlines_ms", CONFIG_REF(decltype(AppConfig::deadlines_ms), deadlines_ms), 1, MAX_DEADLINE_MS, true),
+        map_field("admission_checkout", CONFIG_REF(decltype(AppConfig::admission_checkout), admission_checkout), 0, 1000000, true),
+        map_field("admission_catalog", CONFIG_REF(decltype(AppConfig::admission_catalog), admission_catalog), 0, 1000000, true),
+        map_field("admission_lab", CONFIG_REF(decltype(AppConfig::admission_lab), admission_lab), 0, 1000000, true),
+        string_field("log_level", CONFIG_REF(std::string, log_level), 1, true),
+        string_field("static_dir", CONFIG_REF(std::string, static_dir), 0, true),
+        int_field("static_cache_max_bytes", CONFIG_REF(int, static_cache_max_bytes), 0, 1 << 30, true),
+        int_field("static_cache_file_max_bytes", CONFIG_REF(int, static_cache_file_max_bytes), 0, 1 << 30, true),
+        bool_field("compression", CONFIG_REF(bool, compression), true),
+        int_field("compression_min_bytes", CONFIG_REF(int, compression_min_bytes), 0, 1 << 30, true),
+        int_field("compression_level", CONFIG_REF(int, compression_level), 1, 9, true),
+        int_field("compression_cache_bytes", CONFIG_REF(int, compression_cache_bytes), 0, 1 << 30, true),
+        bool_field("product_store", CONFIG_REF(bool, product_store)),
+        int_field("product_store_refresh_ms", CONFIG_REF(int, product_store_refresh_ms), 100, 3600000, true),
+        int_field("change_log_entries", CONFIG_REF(int, change_log_entries), 1, 10000000, true),
+        bool_field("stock_ledger", CONFIG_REF(bool, stock_ledger)),
+        int_field("stock_commit_ms", CONFIG_REF(int, stock_commit_ms), 1, 10000, true),
+        bool_field("order_queue", CONFIG_REF(bool, order_queue)),
+        string_field("order_journal", CONFIG_REF(std::string, order_journal), 1),
+        int_field("order_queue_max", CONFIG_REF(int, order_queue_max), 1, 10000000, true),
+        int_field("order_batch_max", CONFIG_REF(int, order_batch_max), 1, 100000, true),
+        int_field("stream_max_waiting", CONFIG_REF(int, stream_max_waiting), 0, 10000000, true),
+        int_field("stream_hold_ms", CONFIG_REF(int, stream_hold_ms), 1000, 600000, true),
+        int_field("search_cache_bytes", CONFIG_REF(int, search_cache_bytes), 0, 1 << 30, true),
+        int_field("search_cache_ttl_ms", CONFIG_REF(int, search_cache_ttl_ms), 1, 86400000, true),
+    };
+    return fields;
+}
+
+#undef CONFIG_REF
+
+const Field* find_field(const std::string& key) {
+    for (const auto& f : schema()) {
+        if (key == f.key) return &f;
+    }
+    return nullptr;
+}
+
+const char* const LOG_LEVELS[] = {"debug", "info", "warning", "error", "critical"};
+
+bool parse_long(const std::string& text, long& out) {
+    if (text.empty()) return false;
+    char* end = nullptr;
+    errno = 0;
+    out = std::strtol(text.c_str(), &end, 10);
+    return errno == 0 && *end == '\0';
+}
+
+std::string range(const Field& f) {
+    return "an integer from " + std::to_string(f.min) + " to " + std::to_string(f.max);
+}
+
+void set_int(const Field& f, AppConfig& c, long v, const std::string& where, std::vector<std::string>& errors) {
+    if (v < f.min || v > f.max) {
+        errors.push_back(where + ": expected " + range(f) + ", got " + std::to_string(v));
+        return;
+    }
+    f.int_ref(c) = static_cast<int>(v);
+}
+
+void set_string(const Field& f, AppConfig& c, const std::string& v, const std::string& where,
+                std::vector<std::string>& errors) {
+    if (static_cast<long>(v.size()) < f.min) {
+        errors.push_back(where + ": must not be empty");
+        return;
+    }
+    f.string_ref(c) = v;
+}
+
+bool set_map_entry(const Field& f, AppConfig& c, const std::string& name, long v, const std::string& where,
+                   std::vector<std::string>& errors) {
+    if (name.empty() || v < f.min || v > f.max) {
+        errors.push_back(where + ": \"" + name + "\" must map to " + range(f));
+        return false;
+    }
+    f.map_ref(c)[name] = static_cast<int>(v);
+    return true;
+}
+
+// Environment values are plain text: "42", "true", "warning", "route=ms,route=ms".
+void set_from_text(const Field& f, AppConfig& c, const std::string& text, const std::string& where,
+                   std::vector<std::string>& errors) {
+    long v = 0;
+    switch (f.kind) {
+    case Kind::Int:
+        if (parse_long(text, v)) set_int(f, c, v, where, errors);
+        else errors.push_back(where + ": expected " + range(f) + ", got \"" + text + "\"");
+        break;
+    case Kind::Bool:
+        if (text == "true" || text == "1") f.bool_ref(c) = true;
+        else if (text == "false" || text == "0") f.bool_ref(c) = false;
+        else errors.push_back(where + ": expected true or false, got \"" + text + "\"");
+        break;
+    case Kind::String:
+        set_string(f, c, text, where, errors);
+        break;
+    case Kind::IntMap: {
+        std::stringstream ss(text);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            size_t eq = item.find('=');
+            std::string name = item.substr(0, eq);
+            if (eq == std::string::npos || !parse_long(item.substr(eq + 1), v)) {
+                errors.push_back(where + ": expected name=value pairs separated by commas, got \"" + item + "\"");
+                continue;
+            }
+            set_map_entry(f, c, name, v, where, errors);
+        }
+        break;
+    }
+    }
+}
+
+const char* type_name(crow::json::type t) {
+    switch (t) {
+    case crow::json::type::Null: return "null";
+    case crow::json::type::False:
+    case crow::json::type::True: return "a boolean";
+    case crow::json::type::Number: return "a number";
+    case crow::json::type::String: return "a string";
+    case crow::json::type::List: return "a list";
+    case crow::json::type::Object: return "an object";
+    default: return "an unsupported value";
+    }
+}
+
+// JSON integer, accepting a whole number or (as older config files do) a quoted one.
+bool json_long(const crow::json::rvalue& v, long& out) {
+    if (v.t() == crow::json::type::String) return parse_long(v.s(), out);
+    if (v.t() != crow::json::type::Number) return false;
+    double d = v.d();
+    if (d != std::floor(d) || std::fabs(d) > 1e15) return false;
+    out = static_cast<long>(d);
+    return true;
+}
+
+void set_from_json(const Field& f, AppConfig& c, const crow::json::rvalue& v, std::vector<std::string>& errors) {
+    const std::string where = f.key;
+    long n = 0;
+    switch (f.kind) {
+    case Kind::Int:
+        if (json_long(v, n)) set_int(f, c, n, where, errors);
+        else errors.push_back(where + ": expected " + range(f) + ", got " + type_name(v.t()));
+        break;
+    case Kind::Bool:
+        if (v.t() == crow::json::type::True || v.t() == crow::json::type::False)
+            f.bool_ref(c) = v.t() == crow::json::type::True;
+        else errors.push_back(where + ": expected true or false, got " + type_name(v.t()));
+        break;
+    case Kind::String:
+        if (v.t() == crow::json::type::String) set_string(f, c, v.s(), where, errors);
+        else errors.push_back(where + ": expected a string, got " + type_name(v.t()));
+        break;
+    case Kind::IntMap:
+        if (v.t() != crow::json::type::Object) {
+            errors.push_back(where + ": expected an object, got " + type_name(v.t()));
+            break;
+        }
+        f.map_ref(c).clear();
+        for (const auto& entry : v) {
+            if (!json_long(entry, n)) {
+                errors.push_back(where + ": \"" + entry.key() + "\" must map to " + range(f));
+                continue;
+            }
+            set_map_entry(f, c, entry.key(), n, where, errors);
+        }
+        break;
+    }
+}
+
+// Rules that span keys or restrict a string to a set of values.
+void validate(const AppConfig& c, std::vector<std::string>& errors) {
+    if (std::find(std::begin(LOG_LEVELS), std::end(LOG_LEVELS), c.log_level) == std::end(LOG_LEVELS))
+        errors.push_back("log_level: expected debug, info, warning, error or critical, got \"" + c.log_level + "\"");
+    if (c.db.lab_user.empty() != c.db.lab_password.empty())
+        errors.push_back("lab_user and lab_password must be set together");
+    const std::pair<const char*, const std::map<std::string, int>*> admission[] = {
+        {"admission_checkout", &c.admission_checkout},
+        {"admission_catalog", &c.admission_catalog},
+        {"admission_lab", &c.admission_lab},
+    };
+    for (size_t i = 0; i < std::size(admission); i++) {
+        AdmissionLimits limits;
+        std::string error;
+        if (!admission_limits(static_cast<Priority>(i), *admission[i].second, limits, error))
+            errors.push_back(std::string(admission[i].first) + ": " + error);
+    }
+}
+
+bool same_value(const Field& f, AppConfig& a, AppConfig& b) {
+    switch (f.kind) {
+    case Kind::Int: return f.int_ref(a) == f.int_ref(b);
+    case Kind::Bool: return f.bool_ref(a) == f.bool_ref(b);
+    case Kind::String: return f.string_ref(a) == f.string_ref(b);
+    case Kind::IntMap: return f.map_ref(a) == f.map_ref(b);
+    }
+    return true;
+}
+
+void copy_value(const Field& f, AppConfig& from, AppConfig& to) {
+    switch (f.kind) {
+    case Kind::Int: f.int_ref(to) = f.int_ref(from); break;
+    case Kind::Bool: f.bool_ref(to) = f.bool_ref(from); break;
+    case Kind::String: f.string_ref(to) = f.string_ref(from); break;
+    case Kind::IntMap: f.map_ref(to) = f.map_ref(from); break;
+    }
+}
+
+std::string join(const std::vector<std::string>& items, const char* sep) {
+    std::string out;
+    for (const auto& s : items) out += (out.empty() ? "" : sep) + s;
+    return out;
+}
+
+} // namespace
+
+ConfigError::ConfigError(const std::string& path, std::vector<std::string> problems_)
+    : std::runtime_error("Invalid config " + path + ":\n  " + join(problems_, "\n  ")),
+      problems(std::move(problems_)) {}
+
+std::string config_env_name(const std::string& key) {
+    std::string name = "LALA_" + key;
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char ch) { return std::toupper(ch); });
+    return name;
+}
+
+bool config_reloadable(const std::string& key) {
+    const Field* f = find_field(key);
+    return f && f->reloadable;
+}
+
+AppConfig load_config(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) throw ConfigError(path, {"cannot open file"});
+    std::stringstream buf;
+    buf << file.rdbuf();
+
+    auto root = crow::json::load(buf.str());
+    if (!root) throw ConfigError(path, {"not valid JSON"});
+    if (root.t() != crow::json::type::Object) throw ConfigError(path, {"expected a JSON object at the top level"});
+
+    AppConfig config;
+    std::vector<std::string> errors;
+    for (const auto& item : root) {
+        const Field* f = find_field(item.key());
+        if (!f) {
+            errors.push_back("unknown key \"" + item.key() + "\"");
+            continue;
+        }
+        set_from_json(*f, config, item, errors);
+    }
+    for (const auto& f : schema()) {
+        std::string env = config_env_name(f.key);
+        if (const char* value = std::getenv(env.c_str())) set_from_text(f, config, value, env, errors);
+    }
+    validate(config, errors);
+    if (!errors.empty()) throw ConfigError(path, std::move(errors));
+    return config;
+}
+
+void apply_log_level(const std::string& level) {
+    crow::LogLevel l = crow::LogLevel::Warning;
+    if (level == "debug") l = crow::LogLevel::Debug;
+    else if (level == "info") l = crow::LogLevel::Info;
+    else if (level == "error") l = crow::LogLevel::Error;
+    else if (level == "critical") l = crow::LogLevel::Critical;
+    crow::logger::setLogLevel(l);
+}
+
+ConfigStore& ConfigStore::instance() {
+    static ConfigStore store;
+    return store;
+}
+
+const AppConfig& ConfigStore::load(const std::string& path) {
+    AppConfig config = load_config(path);
+    std::lock_guard<std::mutex> lock(mu_);
+    path_ = path;
+    current_ = std::move(config);
+    return current_;
+}
+
+AppConfig ConfigStore::current() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return current_;
+}
+
+bool ConfigStore::reload() {
+    std::unique_lock<std::mutex> lock(mu_);
+    AppConfig next;
+    try {
+        next = load_config(path_);
+    } catch (const ConfigError& e) {
+        std::cerr << "Config: reload failed, keeping the running config. " << e.what() << std::endl;
+        return false;
+    }
+
+    std::vector<std::string> applied, ignored;
+    for (const auto& f : schema()) {
+        if (same_value(f, current_, next)) continue;
+        if (f.reloadable) {
+            applied.push_back(f.key);
+        } else {
+            ignored.push_back(f.key);
+            copy_value(f, current_, next);
+        }
+    }
+    current_ = next;
+    auto listeners = listeners_;
+    lock.unlock();
+
+    std::cout << "Config: reloaded " << path_ << " (" << (applied.empty() ? "no changes" : "changed: " + join(applied, ", "))
+              << ")" << std::endl;
+    if (!ignored.empty())
+        std::cerr << "Config: restart required to change " << join(ignored, ", ") << std::endl;
+    for (const auto& listener : listeners) listener(next);
+    return true;
+}
+
+void ConfigStore::on_reload(std::function<void(const AppConfig&)> listener) {
+    std::lock_guard<std::mutex> lock(mu_);
+    listeners_.push_back(std::move(listener));
+}
+
+} // namespace server
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "db/connection.h"
+#include <functional>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace server {
+
+/// HTTP side of db_config.json (see ServeOptions / DrainOptions).
+struct HttpConfig {
+    int port = 8080;
+    int workers = 0;        // 0 = one per CPU
+    int instances = 1;      // >1 = SO_REUSEPORT acceptors
+    bool pin_threads = false;
+    // Shutdown: keep serving this long after /readyz flips, then drain for at most drain_timeout_ms
+    int drain_delay_ms = 2000;
+    int drain_timeout_ms = 15000;
+    // Connection handling (Crow + listener socket)
+    int idle_timeout_s = 5;           // close keep-alive connections idle this long (Crow's timer, 1-255)
+    int max_body_bytes = 1048576;     // larger request bodies get 413
+    int max_headers = 64;             // more request headers get 431
+    bool tcp_nodelay = true;
+    int listen_backlog = 4096;        // capped by net.core.somaxconn
+};
+
+/// Everything the backend reads from db_config.json. Member initializers are the defaults.
+struct AppConfig {
+    DbConfig db;
+    HttpConfig http;
+    std::map<std::string, int> deadlines_ms;  // route -> request deadline ("default" = fallback)
+    // Admission control overrides per class (server/admission.h); missing keys keep the built-in limits
+    std::map<std::string, int> admission_checkout;
+    std::map<std::string, int> admission_catalog;
+    std::map<std::string, int> admission_lab;
+    std::string log_level = "warning";        // debug | info | warning | error | critical
+    // Built frontend served by the backend (server/static_files.h); empty = API only
+    std::string static_dir;
+    int static_cache_max_bytes = 64 * 1024 * 1024;  // total bodies kept in memory
+    int static_cache_file_max_bytes = 1024 * 1024;  // larger files are streamed from disk
+    // Response compression (server/response_compression.h)
+    bool compression = true;
+    int compression_min_bytes = 1024;
+    int compression_level = 6;
+    int compression_cache_bytes = 32 * 1024 * 1024;
+    // In-memory catalog for filtered product lists (server/product_store.h)
+    bool product_store = true;          // off: those lists, suggest, changes and streams answer 503
+    int product_store_refresh_ms = 5000;
+    int change_log_entries = 10000;      // /api/products/changes history, in products
+    // In-memory stock reservations with group commit (server/stock_committer.h)
+    bool stock_ledger = false;          // one backend process per database when on
+    int stock_commit_ms = 10;
+    // Async orders with Prefer: respond-async (server/order_queue.h); needs stock_ledger
+    bool order_queue = false;
+    std::string order_journal = "order_journal";  // directory of journal segments
+    int order_queue_max = 10000;         // queued orders; more get 503
+    int order_batch_max = 500;           // orders per transaction
+    // /api/stream/products (server/product_stream.h)
+    int stream_max_waiting = 50000;      // parked readers; more get 503
+    int stream_hold_ms = 25000;          // an idle reader is answered with a keepalive and reconnects
+    // /api/products/search response cache (server/search_cache.h); 0 bytes = off
+    int search_cache_bytes = 8 * 1024 * 1024;
+    int search_cache_ttl_ms = 30000;
+};
+
+/// Every problem found in a config file, one per line in what().
+struct ConfigError : std::runtime_error {
+    ConfigError(const std::string& path, std::vector<std::string> problems);
+    std::vector<std::string> problems;
+};
+
+/**
+ * Read `path` against the config schema (config.cpp): keys the file leaves out
+ * keep their defaults, then LALA_<KEY> environment variables override the file
+ * (e.g. LALA_PASSWORD, LALA_POOL_SIZE, LALA_DEADLINES_MS="orders.create=3000").
+ * Unknown keys, wrong types and out-of-range values are collected and thrown
+ * together as a ConfigError.
+ */
+AppConfig load_config(const std::string& path);
+
+/// Environment variable that overrides `key`.
+std::string config_env_name(const std::string& key);
+
+/// Keys applied by a SIGHUP reload; every other key needs a restart.
+bool config_reloadable(const std::string& key);
+
+/// Set Crow's log level from a validated log_level value.
+void apply_log_level(const std::string& level);
+
+/**
+ * The running configuration. load() once at startup; reload() (SIGHUP)
+ * re-reads the same file and environment. A file that no longer validates is
+ * reported and ignored. Otherwise reloadable keys take the new values, changes
+ * to the others are reported and kept at their running values, and every
+ * on_reload listener is called with the result.
+ */
+class ConfigStore {
+public:
+    static ConfigStore& instance();
+
+    /// Throws ConfigError.
+    const AppConfig& load(const std::string& path);
+    AppConfig current() const;
+    /// Returns false if the file failed validation (nothing was applied).
+    bool reload();
+    void on_reload(std::function<void(const AppConfig&)> listener);
+
+private:
+    ConfigStore() = default;
+
+    mutable std::mutex mu_;
+    std::string path_;
+    AppConfig current_;
+    std::vector<std::function<void(const AppConfig&)>> listeners_;
+};
+
+} // namespace server
@@ -0,0 +1,163 @@
+#include "server/db_executor.h"
+#include "server/runtime.h"
+#include <iostream>
+
+namespace server {
+
+namespace {
+
+// Index of the executor worker running on this thread, or -1 for HTTP threads.
+thread_local long t_worker_index = -1;
+
+} // namespace
+
+const char* priority_name(Priority p) {
+    switch (p) {
+        case Priority::Checkout: return "checkout";
+        case Priority::Catalog: return "catalog";
+        default: return "lab";
+    }
+}
+
+DbExecutor& DbExecutor::instance() {
+    static DbExecutor executor;
+    return executor;
+}
+
+void DbExecutor::start(size_t threads, bool pin_threads) {
+    std::unique_lock<std::shared_mutex> guard(workers_mu_);
+    if (running_.exchange(true)) return;
+    if (threads == 0) threads = 1;
+    stopping_ = false;
+    pin_threads_ = pin_threads;
+    for (size_t i = 0; i < threads; i++) workers_.push_back(std::make_unique<Worker>());
+    for (size_t i = 0; i < threads; i++) threads_.emplace_back(&DbExecutor::worker_loop, this, i);
+    thread_count_ = threads;
+}
+
+void DbExecutor::shutdown() {
+    {
+        // Once this is held no submit() is half-way through; later ones see !running_.
+        std::unique_lock<std::shared_mutex> guard(workers_mu_);
+        if (!running_.exchange(false)) return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(idle_mu_);
+        stopping_ = true;
+    }
+    idle_cv_.notify_all();
+    for (auto& t : threads_) t.join();  // workers run everything queued before they exit
+    std::unique_lock<std::shared_mutex> guard(workers_mu_);
+    threads_.clear();
+    workers_.clear();
+    thread_count_ = 0;
+}
+
+bool DbExecutor::wait_idle(std::chrono::milliseconds timeout) const {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    for (;;) {
+        uint64_t submitted = 0, completed = 0;
+        for (size_t i = 0; i < PRIORITY_COUNT; i++) submitted += submitted_[i].load();
+        for (size_t i = 0; i < PRIORITY_COUNT; i++) completed += completed_[i].load();
+        if (completed >= submitted) return true;
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+bool DbExecutor::submit(Priority p, Task task) {
+    std::shared_lock<std::shared_mutex> guard(workers_mu_);
+    if (!running_.load() || workers_.empty()) return false;
+    size_t idx = t_worker_index >= 0 ? static_cast<size_t>(t_worker_index)
+                                     : next_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    size_t prio = static_cast<size_t>(p);
+    {
+        std::lock_guard<std::mutex> lock(workers_[idx]->mu);
+        workers_[idx]->queues[prio].push_back(std::move(task));
+    }
+    submitted_[prio]++;
+    uint64_t d = ++depth_[prio];
+    uint64_t seen = max_depth_[prio].load(std::memory_order_relaxed);
+    while (d > seen && !max_depth_[prio].compare_exchange_weak(seen, d)) {}
+
+    pending_++;
+    guard.unlock();
+    { std::lock_guard<std::mutex> lock(idle_mu_); }
+    idle_cv_.notify_one();
+    return true;
+}
+
+bool DbExecutor::take(size_t index, Task& out, size_t& prio_out) {
+    const size_t n = workers_.size();
+    for (size_t prio = 0; prio < PRIORITY_COUNT; prio++) {
+        {
+            Worker& self = *workers_[index];
+            std::lock_guard<std::mutex> lock(self.mu);
+            auto& q = self.queues[prio];
+            if (!q.empty()) {
+                out = std::move(q.front());
+                q.pop_front();
+                depth_[prio]--;
+                pending_--;
+                prio_out = prio;
+                return true;
+            }
+        }
+        for (size_t k = 1; k < n; k++) {
+            Worker& victim = *workers_[(index + k) % n];
+            std::lock_guard<std::mutex> lock(victim.mu);
+            auto& q = victim.queues[prio];
+            if (!q.empty()) {
+                out = std::move(q.back());
+                q.pop_back();
+                depth_[prio]--;
+                pending_--;
+                stolen_++;
+                prio_out = prio;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void DbExecutor::worker_loop(size_t index) {
+    t_worker_index = static_cast<long>(index);
+    if (pin_threads_) pin_current_thread(index, 1);
+    for (;;) {
+        Task task;
+        size_t prio = 0;
+        if (take(index, task, prio)) {
+            busy_++;
+            try {
+                task();
+            } catch (std::exception& e) {
+                std::cerr << "DB executor: task threw: " << e.what() << "\n";
+            } catch (...) {
+                std::cerr << "DB executor: task threw a non-std exception\n";
+            }
+            busy_--;
+            completed_[prio]++;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(idle_mu_);
+        idle_cv_.wait(lock, [this] { return pending_.load() > 0 || stopping_.load(); });
+        if (stopping_.load() && pending_.load() == 0) break;
+    }
+}
+
+ExecutorMetrics DbExecutor::metrics() const {
+    ExecutorMetrics m;
+    m.threads = thread_count_.load();
+    m.busy = busy_.load();
+    m.stolen = stolen_.load();
+    for (size_t i = 0; i < PRIORITY_COUNT; i++) {
+        m.depth[i] = depth_[i].load();
+        m.max_depth[i] = max_depth_[i].load();
+        m.submitted[i] = submitted_[i].load();
+        m.completed[i] = completed_[i].load();
+    }
+    return m;
+}
+
+} // namespace server
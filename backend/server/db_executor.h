@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+namespace server {
+
+/// Priority classes for DB work, highest first. Checkout covers the transactional
+/// write paths (order create, cart mutations, auth); Catalog covers read-only
+/// listing (products, cart view, order history); Lab is /lab training traffic.
+enum class Priority : int { Checkout = 0, Catalog = 1, Lab = 2 };
+constexpr size_t PRIORITY_COUNT = 3;
+const char* priority_name(Priority p);
+
+struct ExecutorMetrics {
+    size_t threads = 0;
+    size_t busy = 0;
+    uint64_t stolen = 0;
+    std::array<uint64_t, PRIORITY_COUNT> depth{};
+    std::array<uint64_t, PRIORITY_COUNT> max_depth{};
+    std::array<uint64_t, PRIORITY_COUNT> submitted{};
+    std::array<uint64_t, PRIORITY_COUNT> completed{};
+};
+
+/**
+ * Work-stealing executor for DB + serialization work, sized independently of
+ * Crow's HTTP worker pool. Each worker owns one deque per priority class and
+ * pops from the front of its own deques; idle workers steal from the back of
+ * other workers' deques. Higher classes are always drained first, locally and
+ * when stealing, so a backlog of catalog/lab work cannot starve checkout.
+ */
+class DbExecutor {
+public:
+    using Task = std::function<void()>;
+
+    static DbExecutor& instance();
+
+    /// Start `threads` workers; with pin_threads, worker i is pinned to CPU i (mod CPU count).
+    void start(size_t threads, bool pin_threads = false);
+    /// Stop accepting tasks, run everything already queued, join workers.
+    void shutdown();
+    bool running() const { return running_.load(); }
+    /// Wait until every task submitted so far has completed. False on timeout.
+    bool wait_idle(std::chrono::milliseconds timeout) const;
+
+    /// Queue a task. Returns false (task not queued) when the executor is not running.
+    bool submit(Priority p, Task task);
+
+    ExecutorMetrics metrics() const;
+    /// Tasks queued (not yet running) in one class; cheap enough for per-request checks.
+    uint64_t depth(Priority p) const { return depth_[static_cast<size_t>(p)].load(std::memory_order_relaxed); }
+
+private:
+    struct Worker {
+        std::mutex mu;
+        std::array<std::deque<Task>, PRIORITY_COUNT> queues;
+    };
+
+    DbExecutor() = default;
+    void worker_loop(size_t index);
+    bool take(size_t index, Task& out, size_t& prio_out);
+
+    // submit() holds it shared while it checks running_ and queues; start() and
+    // shutdown() hold it exclusively to change either, so no task is queued
+    // after shutdown() began and workers_ is never cleared under a submit.
+    std::shared_mutex workers_mu_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+    std::atomic<size_t> next_{0};
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stopping_{false};
+    bool pin_threads_ = false;
+
+    std::mutex idle_mu_;
+    std::condition_variable idle_cv_;
+    std::atomic<size_t> pending_{0};
+
+    std::atomic<size_t> thread_count_{0};
+    std::atomic<size_t> busy_{0};
+    std::atomic<uint64_t> stolen_{0};
+    std::array<std::atomic<uint64_t>, PRIORITY_COUNT> depth_{};
+    std::array<std::atomic<uint64_t>, PRIORITY_COUNT> max_depth_{};
+    std::array<std::atomic<uint64_t>, PRIORITY_COUNT> submitted_{};
+    std::array<std::atomic<uint64_t>, PRIORITY_COUNT> completed_{};
+};
+
+} // namespace server
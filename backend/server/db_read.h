@@ -0,0 +1,39 @@
+#pragma once
+
+#include "crow.h"
+#include "db/connection.h"
+#include "db/pg_binary.h"
+#include "server/deadline.h"
+#include <pqxx/pqxx>
+
+namespace server {
+
+/**
+ * Run the read-only `read(txn)` in a transaction bounded by `deadline`, and
+ * return its response. With binary_pool_size set, `txn` is a
+ * pg_binary::Transaction on the binary pool, so ints, numerics and
+ * timestamps arrive in binary; otherwise it is a pqxx::work on the app pool.
+ * Both have exec_prepared(name, args...) and commit(), and row_mapping
+ * reads both result types, so `read` is one generic lambda:
+ *
+ *   return server::read_txn(deadline, [&](auto& txn) {
+ *       auto r = txn.exec_prepared("products_all");
+ *       txn.commit();
+ *       return server::data_response(format, 200, [&](auto& w) { row_mapping::write_rows<Product>(w, r); });
+ *   });
+ */
+template <typename Read>
+crow::response read_txn(const Deadline& deadline, Read&& read) {
+    if (Database::instance().binaryResults()) {
+        auto conn = Database::instance().acquireBinary();
+        pg_binary::Transaction txn(*conn);
+        apply_deadline(txn, deadline);
+        return read(txn);
+    }
+    auto conn = Database::instance().acquire();
+    pqxx::work txn(*conn);
+    apply_deadline(txn, deadline);
+    return read(txn);
+}
+
+} // namespace server
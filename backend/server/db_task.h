@@ -0,0 +1,39 @@
+#pragma once
+
+#include "crow.h"
+#include "server/db_executor.h"
+#include "utils/response_helper.h"
+#include <string>
+#include <utility>
+
+namespace server {
+
+/**
+ * Run `work` (a callable returning crow::response) on the DB executor and
+ * complete the async response `res` with its result. HTTP threads return
+ * immediately; the connection is answered when res.end() runs on the worker.
+ * Falls back to running inline when the executor is not started.
+ * Capture request data by value: `work` may outlive the handler's frame.
+ */
+template <typename Work>
+void run_db(crow::response& res, Priority priority, Work&& work) {
+    auto task = [&res, work = std::forward<Work>(work)]() mutable {
+        try {
+            res = work();
+        } catch (std::exception& e) {
+            res = crow::response(500, response_helper::error_json(std::string("Error: ") + e.what()));
+        } catch (...) {
+            res = crow::response(500, response_helper::error_json("Error: unknown exception"));
+        }
+        res.end();  // always: otherwise the connection hangs until the idle timeout
+    };
+    if (!DbExecutor::instance().submit(priority, task)) task();
+}
+
+/// Complete an async response immediately (validation errors, guard rejections).
+inline void respond(crow::response& res, crow::response&& r) {
+    res = std::move(r);
+    res.end();
+}
+
+} // namespace server
@@ -0,0 +1,112 @@
+#include "server/deadline.h"
+#include "db/pg_binary.h"
+#include "utils/response_helper.h"
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+#include <unordered_map>
+
+namespace server {
+
+namespace {
+
+std::mutex g_mu;
+// Order creation runs several statements under row locks; give it the most room.
+const std::unordered_map<std::string, int> BUILTIN_ROUTE_MS = {
+    {"default", 2000},
+    {"orders.create", 5000},
+};
+std::unordered_map<std::string, int> g_route_ms = BUILTIN_ROUTE_MS;
+std::map<std::string, uint64_t> g_exceeded;
+
+void count_exceeded(const std::string& route) {
+    std::lock_guard<std::mutex> lock(g_mu);
+    g_exceeded[route]++;
+}
+
+bool is_timeout(const std::exception& e) {
+    if (dynamic_cast<const DeadlineExceeded*>(&e)) return true;
+    // 57014 statement_timeout (query_canceled), 55P03 lock_timeout (lock_not_available)
+    if (dynamic_cast<const pqxx::query_canceled*>(&e)) return true;
+    if (auto* sql = dynamic_cast<const pqxx::sql_error*>(&e)) return sql->sqlstate() == "55P03";
+    return false;
+}
+
+} // namespace
+
+Deadline Deadline::for_request(const crow::request& req, const std::string& route) {
+    int ms = route_deadline_ms(route);
+    const std::string& header = req.get_header_value(DEADLINE_HEADER);
+    if (!header.empty()) {
+        long v = std::strtol(header.c_str(), nullptr, 10);
+        if (v > 0) ms = static_cast<int>(std::min<long>(ms, v));  // a client can only ask for less
+    }
+    Deadline d;
+    d.route_ = route;
+    d.at_ = Clock::now() + std::chrono::milliseconds(ms);
+    return d;
+}
+
+long Deadline::remaining_ms() const {
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(at_ - Clock::now()).count();
+    return std::max<long>(0, static_cast<long>(left));
+}
+
+void Deadline::check() const {
+    if (expired()) throw DeadlineExceeded(route_);
+}
+
+void set_route_deadline(const std::string& route, int ms) {
+    if (ms <= 0) return;
+    std::lock_guard<std::mutex> lock(g_mu);
+    g_route_ms[route] = std::min(ms, MAX_DEADLINE_MS);
+}
+
+void set_route_deadlines(const std::map<std::string, int>& routes) {
+    auto next = BUILTIN_ROUTE_MS;
+    for (const auto& [route, ms] : routes) {
+        if (ms > 0) next[route] = std::min(ms, MAX_DEADLINE_MS);
+    }
+    std::lock_guard<std::mutex> lock(g_mu);
+    g_route_ms = std::move(next);
+}
+
+int route_deadline_ms(const std::string& route) {
+    std::lock_guard<std::mutex> lock(g_mu);
+    auto it = g_route_ms.find(route);
+    if (it == g_route_ms.end()) it = g_route_ms.find("default");
+    return it->second;
+}
+
+namespace {
+
+// Never 0: that would disable the timeout.
+std::string timeout_ms(const Deadline& deadline) {
+    deadline.check();
+    return std::to_string(std::max<long>(1, deadline.remaining_ms()));
+}
+
+} // namespace
+
+void apply_deadline(pqxx::work& txn, const Deadline& deadline) {
+    txn.exec_prepared("set_deadline", timeout_ms(deadline));
+}
+
+void apply_deadline(pg_binary::Transaction& txn, const Deadline& deadline) {
+    txn.exec_prepared("set_deadline", timeout_ms(deadline));
+}
+
+crow::response db_error_response(const std::exception& e, const Deadline& deadline) {
+    if (is_timeout(e)) {
+        count_exceeded(deadline.route());
+        return crow::response(504, response_helper::error_json("Request deadline exceeded"));
+    }
+    return crow::response(500, response_helper::error_json(std::string("Error: ") + e.what()));
+}
+
+std::map<std::string, uint64_t> deadline_exceeded_counts() {
+    std::lock_guard<std::mutex> lock(g_mu);
+    return g_exceeded;
+}
+
+} // namespace server
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "crow.h"
+#include <pqxx/pqxx>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+namespace pg_binary {
+class Transaction;
+}
+
+namespace server {
+
+/// Header our proxy sets to shorten the per-route deadline (milliseconds, relative).
+constexpr const char* DEADLINE_HEADER = "X-Request-Timeout-Ms";
+constexpr int MAX_DEADLINE_MS = 60000;
+
+struct DeadlineExceeded : std::runtime_error {
+    explicit DeadlineExceeded(const std::string& route)
+        : std::runtime_error("Deadline exceeded: " + route) {}
+};
+
+/**
+ * Absolute time by which a request must be answered. Created on the HTTP
+ * thread when the handler starts, captured by value into the DB task, and
+ * checked again there: time spent queued in the executor counts against it.
+ */
+class Deadline {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// Route budget from route_deadline_ms(route), or the DEADLINE_HEADER value if that is smaller.
+    static Deadline for_request(const crow::request& req, const std::string& route);
+
+    const std::string& route() const { return route_; }
+    long remaining_ms() const;
+    bool expired() const { return Clock::now() >= at_; }
+    /// Throw DeadlineExceeded if the budget is spent. Call before each statement.
+    void check() const;
+
+private:
+    std::string route_;
+    Clock::time_point at_;
+};
+
+/// Per-route budget in ms; "default" sets the fallback for routes without an entry.
+void set_route_deadline(const std::string& route, int ms);
+/// Replace all budgets: the built-in defaults overlaid with `routes` (config load and reload).
+void set_route_deadlines(const std::map<std::string, int>& routes);
+int route_deadline_ms(const std::string& route);
+
+/// Check the deadline, then bound the rest of the transaction in Postgres:
+/// SET LOCAL statement_timeout and lock_timeout to the remaining budget.
+void apply_deadline(pqxx::work& txn, const Deadline& deadline);
+/// Same for a binary-results transaction (db/pg_binary.h).
+void apply_deadline(pg_binary::Transaction& txn, const Deadline& deadline);
+
+/// Map a DB task failure to a response: 504 for a spent deadline or a
+/// statement/lock timeout (counted per route), 500 for anything else.
+crow::response db_error_response(const std::exception& e, const Deadline& deadline);
+
+/// Number of 504s per route since startup.
+std::map<std::string, uint64_t> deadline_exceeded_counts();
+
+} // namespace server
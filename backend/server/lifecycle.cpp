@@ -0,0 +1,118 @@
+#include "server/lifecycle.h"
+#include <iostream>
+#include <thread>
+
+#ifndef _WIN32
+#include <csignal>
+#include <ctime>
+#include <pthread.h>
+#endif
+
+namespace server {
+
+namespace {
+
+#ifndef _WIN32
+sigset_t shutdown_signals() {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGTERM);
+    sigaddset(&set, SIGINT);
+    return set;
+}
+
+sigset_t watched_signals() {
+    sigset_t set = shutdown_signals();
+    sigaddset(&set, SIGHUP);
+    return set;
+}
+
+// Wait up to `ms` for another shutdown signal. Returns true if one arrived.
+bool signal_within(int ms) {
+    sigset_t set = shutdown_signals();
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = static_cast<long>(ms % 1000) * 1000000L;
+    return sigtimedwait(&set, nullptr, &ts) > 0;
+}
+#else
+bool signal_within(int ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    return false;
+}
+#endif
+
+} // namespace
+
+Lifecycle& Lifecycle::instance() {
+    static Lifecycle lifecycle;
+    return lifecycle;
+}
+
+void Lifecycle::record_phase(const std::string& name, double ms) {
+    std::lock_guard<std::mutex> lock(phases_mu_);
+    phases_.push_back({name, ms});
+}
+
+std::vector<StartupPhase> Lifecycle::phases() const {
+    std::lock_guard<std::mutex> lock(phases_mu_);
+    return phases_;
+}
+
+double Lifecycle::uptime_s() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - started_).count();
+}
+
+void Lifecycle::block_shutdown_signals() {
+#ifndef _WIN32
+    sigset_t set = watched_signals();
+    pthread_sigmask(SIG_BLOCK, &set, nullptr);
+#endif
+}
+
+void Lifecycle::drain(const DrainOptions& options) {
+    using Clock = std::chrono::steady_clock;
+    constexpr int POLL_MS = 50;
+
+    ready_ = false;
+    std::cout << "Shutdown: not ready, draining in " << options.delay_ms << " ms" << std::endl;
+    for (int waited = 0; waited < options.delay_ms; waited += POLL_MS) {
+        if (signal_within(POLL_MS)) return;
+    }
+
+    draining_ = true;
+    auto start = Clock::now();
+    auto deadline = start + std::chrono::milliseconds(options.timeout_ms);
+    while (inflight_.load() > 0 && Clock::now() < deadline) {
+        if (signal_within(POLL_MS)) return;
+    }
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+    if (inflight_.load() > 0) {
+        std::cerr << "Shutdown: drain timed out after " << ms << " ms with " << inflight_.load()
+                  << " requests in flight" << std::endl;
+    } else {
+        std::cout << "Shutdown: drained in " << ms << " ms" << std::endl;
+    }
+}
+
+void Lifecycle::start_signal_watcher(DrainOptions options, std::function<void()> stop) {
+#ifndef _WIN32
+    std::thread([this, options, stop = std::move(stop)] {
+        sigset_t set = watched_signals();
+        int sig = 0;
+        for (;;) {
+            if (sigwait(&set, &sig) != 0) return;
+            if (sig != SIGHUP) break;
+            if (reload_) reload_();
+        }
+        std::cout << "Shutdown: received " << (sig == SIGTERM ? "SIGTERM" : "SIGINT") << std::endl;
+        drain(options);
+        stop();
+    }).detach();
+#else
+    (void)options;
+    (void)stop;
+#endif
+}
+
+} // namespace server
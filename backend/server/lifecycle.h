@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace server {
+
+struct StartupPhase {
+    std::string name;
+    double ms;
+};
+
+struct DrainOptions {
+    int delay_ms = 2000;     // keep serving after readiness flips, so the LB can react
+    int timeout_ms = 15000;  // max wait for in-flight requests before stopping anyway
+};
+
+/**
+ * Process lifecycle shared by all App instances: startup phase timings,
+ * readiness (what /readyz reports), the draining flag the admission
+ * middleware checks, and a count of requests currently being handled.
+ *
+ * Shutdown sequence on SIGTERM/SIGINT (see start_signal_watcher):
+ *   1. not ready  - /readyz answers 503, everything else still served
+ *   2. draining   - after delay_ms, new requests get 503 + Connection: close
+ *   3. idle       - wait up to timeout_ms for in-flight requests to finish
+ *   4. stop       - the caller's stop callback (executor drain, apps stop)
+ * A second signal skips straight to stop. SIGHUP runs the reload handler
+ * (config reload) and keeps serving.
+ */
+class Lifecycle {
+public:
+    static Lifecycle& instance();
+
+    bool ready() const { return ready_.load(); }
+    void set_ready(bool ready) { ready_ = ready; }
+    bool draining() const { return draining_.load(); }
+
+    void record_phase(const std::string& name, double ms);
+    std::vector<StartupPhase> phases() const;
+    double uptime_s() const;
+
+    void request_started() { inflight_++; }
+    void request_finished() { inflight_--; }
+    size_t inflight() const { return inflight_.load(); }
+
+    /// Block SIGTERM/SIGINT/SIGHUP in the calling thread. Call first thing in main so
+    /// every thread started later inherits the mask and only the watcher sees them.
+    static void block_shutdown_signals();
+
+    /// Called on the watcher thread for each SIGHUP. Set before start_signal_watcher.
+    void set_reload_handler(std::function<void()> reload) { reload_ = std::move(reload); }
+
+    /// Start the (detached) thread that waits for SIGTERM/SIGINT and runs the
+    /// shutdown sequence, finishing with `stop`.
+    void start_signal_watcher(DrainOptions options, std::function<void()> stop);
+
+private:
+    Lifecycle() : started_(std::chrono::steady_clock::now()) {}
+    void drain(const DrainOptions& options);
+
+    const std::chrono::steady_clock::time_point started_;
+    mutable std::mutex phases_mu_;
+    std::vector<StartupPhase> phases_;
+
+    std::atomic<bool> ready_{false};
+    std::atomic<bool> draining_{false};
+    std::atomic<size_t> inflight_{0};
+    std::function<void()> reload_;
+};
+
+} // namespace server
@@ -0,0 +1,264 @@
+#include "server/order_journal.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace server {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+uint32_t fnv1a(const char* p, size_t n) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; i++) {
+        h ^= static_cast<unsigned char>(p[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+[[noreturn]] void throw_errno(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+bool parse_int(const char*& p, const char* end, int& out) {
+    auto [next, ec] = std::from_chars(p, end, out);
+    if (ec != std::errc() || next == p) return false;
+    p = next;
+    return true;
+}
+
+// "00000042.log" -> 42
+bool segment_number(const std::string& name, uint64_t& out) {
+    if (name.size() != 12 || name.compare(8, 4, ".log") != 0) return false;
+    auto [next, ec] = std::from_chars(name.data(), name.data() + 8, out);
+    return ec == std::errc() && next == name.data() + 8;
+}
+
+void fsync_dir(const std::string& dir) {
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) throw_errno("open " + dir);
+    int rc = ::fsync(fd);
+    ::close(fd);
+    if (rc != 0) throw_errno("fsync " + dir);
+}
+
+} // namespace
+
+OrderJournal::OrderJournal(std::string dir) : dir_(std::move(dir)) {}
+
+OrderJournal::~OrderJournal() {
+    if (fd_ >= 0) ::close(fd_);
+}
+
+std::string OrderJournal::encode(const JournalRecord& record) {
+    std::string line = record.token + ' ' + std::to_string(record.user_id) + ' ';
+    for (size_t i = 0; i < record.items.size(); i++) {
+        if (i) line += ',';
+        line += std::to_string(record.items[i].first) + ':' + std::to_string(record.items[i].second);
+    }
+    char sum[10];
+    std::snprintf(sum, sizeof sum, " %08x", fnv1a(line.data(), line.size()));
+    line += sum;
+    line += '\n';
+    return line;
+}
+
+bool OrderJournal::decode(const std::string& line, JournalRecord& out) {
+    size_t last = line.rfind(' ');
+    if (last == std::string::npos || line.size() - last != 9) return false;
+    uint32_t sum = 0;
+    auto [sumEnd, ec] = std::from_chars(line.data() + last + 1, line.data() + line.size(), sum, 16);
+    if (ec != std::errc() || sumEnd != line.data() + line.size() || sum != fnv1a(line.data(), last)) return false;
+
+    size_t space = line.find(' ');
+    if (space == 0 || space >= last) return false;
+    JournalRecord r;
+    r.token = line.substr(0, space);
+    const char* p = line.data() + space + 1;
+    const char* end = line.data() + last;
+    if (!parse_int(p, end, r.user_id) || p == end || *p++ != ' ') return false;
+    while (p < end) {
+        int id = 0, qty = 0;
+        if (!parse_int(p, end, id) || p == end || *p++ != ':' || !parse_int(p, end, qty) || qty < 1) return false;
+        r.items.emplace_back(id, qty);
+        if (p < end && *p++ != ',') return false;
+    }
+    if (r.items.empty()) return false;
+    out = std::move(r);
+    return true;
+}
+
+std::string OrderJournal::path_of(uint64_t segment) const {
+    char name[32];
+    std::snprintf(name, sizeof name, "%08llu.log", static_cast<unsigned long long>(segment));
+    return (fs::path(dir_) / name).string();
+}
+
+std::vector<JournalRecord> OrderJournal::open() {
+    std::lock_guard<std::mutex> lock(mu_);
+    std::error_code ec;
+    fs::create_directories(dir_, ec);
+    if (ec) throw std::system_error(ec, "create " + dir_);
+
+    std::vector<uint64_t> segments;
+    for (const auto& entry : fs::directory_iterator(dir_)) {
+        uint64_t n = 0;
+        if (entry.is_regular_file() && segment_number(entry.path().filename().string(), n)) segments.push_back(n);
+    }
+    std::sort(segments.begin(), segments.end());
+
+    std::vector<JournalRecord> records;
+    for (uint64_t n : segments) {
+        std::ifstream in(path_of(n));
+        uint64_t count = 0;
+        uint64_t offset = 0;
+        std::string line;
+        JournalRecord r;
+        for (; std::getline(in, line); offset += line.size() + 1) {
+            if (!line.empty() && line[0] == FAILED_MARK) continue;  // reported failed
+            if (!decode(line, r)) continue;                         // torn write: never acknowledged
+            r.segment = n;
+            r.offset = offset;
+            records.push_back(std::move(r));
+            count++;
+        }
+        if (count == 0) ::unlink(path_of(n).c_str());
+        else outstanding_[n] = count;
+    }
+    open_segment(segments.empty() ? 1 : segments.back() + 1);
+    return records;
+}
+
+void OrderJournal::open_segment(uint64_t segment) {
+    std::string path = path_of(segment);
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) throw_errno("open " + path);
+    fsync_dir(dir_);  // the new file's name must be durable before its records are
+    fd_ = fd;
+    segment_ = segment;
+    segment_bytes_ = 0;
+    outstanding_.emplace(segment, 0);
+}
+
+void OrderJournal::remove_segment(uint64_t segment) {
+    outstanding_.erase(segment);
+    ::unlink(path_of(segment).c_str());
+}
+
+void OrderJournal::roll() {
+    if (::fdatasync(fd_) != 0) throw_errno("fdatasync " + path_of(segment_));
+    synced_ = written_;
+    ::close(fd_);
+    fd_ = -1;
+    uint64_t old = segment_;
+    if (outstanding_[old] == 0) remove_segment(old);
+    open_segment(old + 1);
+}
+
+uint64_t OrderJournal::append(JournalRecord& record) {
+    std::string line = encode(record);
+    std::unique_lock<std::mutex> lock(mu_);
+    if (fd_ < 0) throw std::system_error(EBADF, std::generic_category(), "order journal is closed");
+    if (segment_bytes_ >= SEGMENT_BYTES) {
+        cv_.wait(lock, [&] { return !syncing_; });  // the syncing thread still uses fd_
+        roll();
+    }
+    const char* p = line.data();
+    size_t left = line.size();
+    while (left > 0) {
+        ssize_t n = ::write(fd_, p, left);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw_errno("write " + path_of(segment_));
+        }
+        p += n;
+        left -= static_cast<size_t>(n);
+    }
+    record.segment = segment_;
+    record.offset = segment_bytes_;
+    segment_bytes_ += line.size();
+    written_ += line.size();
+    outstanding_[segment_]++;
+    appended_++;
+    return written_;
+}
+
+void OrderJournal::sync(uint64_t position) {
+    std::unique_lock<std::mutex> lock(mu_);
+    while (synced_ < position) {
+        if (syncing_) {
+            cv_.wait(lock);
+            continue;
+        }
+        // Lead: one fdatasync covers every record written so far.
+        syncing_ = true;
+        uint64_t target = written_;
+        int fd = fd_;
+        lock.unlock();
+        int rc = ::fdatasync(fd);
+        int err = errno;
+        lock.lock();
+        syncing_ = false;
+        cv_.notify_all();
+        if (rc != 0) throw std::system_error(err, std::generic_category(), "fdatasync " + path_of(segment_));
+        synced_ = std::max(synced_, target);
+        syncs_++;
+    }
+}
+
+void OrderJournal::done(uint64_t segment) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = outstanding_.find(segment);
+    if (it == outstanding_.end() || it->second == 0) return;
+    if (--it->second > 0) return;
+    if (segment != segment_) {
+        remove_segment(segment);
+    } else if (fd_ >= 0 && ::ftruncate(fd_, 0) == 0) {
+        segment_bytes_ = 0;  // O_APPEND: the next record starts the file again
+    }
+}
+
+void OrderJournal::fail(const JournalRecord& record) {
+    // Outstanding, so its segment is neither deleted nor truncated meanwhile.
+    // A separate descriptor: pwrite() on an O_APPEND one appends on Linux.
+    std::string path = path_of(record.segment);
+    int fd = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0) throw_errno("open " + path);
+    ssize_t n = ::pwrite(fd, &FAILED_MARK, 1, static_cast<off_t>(record.offset));
+    int rc = n == 1 ? ::fdatasync(fd) : -1;
+    int err = n == 0 ? EIO : errno;
+    ::close(fd);
+    if (rc != 0) throw std::system_error(err, std::generic_category(), "mark failed order in " + path);
+    done(record.segment);
+}
+
+void OrderJournal::close() {
+    std::unique_lock<std::mutex> lock(mu_);
+    cv_.wait(lock, [&] { return !syncing_; });
+    if (fd_ < 0) return;
+    ::fdatasync(fd_);
+    ::close(fd_);
+    fd_ = -1;
+    if (outstanding_[segment_] == 0) remove_segment(segment_);
+}
+
+OrderJournalMetrics OrderJournal::metrics() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    OrderJournalMetrics m;
+    m.appended = appended_;
+    m.syncs = syncs_;
+    m.bytes = written_;
+    m.segments = outstanding_.size();
+    for (const auto& [segment, n] : outstanding_) m.outstanding += n;
+    return m;
+}
+
+} // namespace server
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace server {
+
+/// One accepted order as written to the journal.
+struct JournalRecord {
+    std::string token;
+    int user_id = 0;
+    std::vector<std::pair<int, int>> items;  // (product_id, quantity), quantity >= 1
+    uint64_t segment = 0;                    // set by append() and open()
+    uint64_t offset = 0;                     // of the line in its segment, likewise
+};
+
+struct OrderJournalMetrics {
+    uint64_t appended = 0;
+    uint64_t syncs = 0;          // fdatasync calls; appended / syncs is the group size
+    uint64_t bytes = 0;
+    size_t segments = 0;         // files on disk
+    uint64_t outstanding = 0;    // records not yet done()
+};
+
+/**
+ * Append-only file of accepted orders for the async order pipeline
+ * (server/order_queue.h), so an order answered with 202 survives a crash
+ * before the background writer has committed it.
+ *
+ * Records are single text lines ending in an FNV-1a checksum; a torn last
+ * line is skipped on replay. sync() is a group fsync: the first caller
+ * runs fdatasync for everything written so far while later callers wait for
+ * it, and one of them covers whatever arrived meanwhile, so N concurrent
+ * orders cost about two fsyncs rather than N.
+ *
+ * The journal is a directory of numbered segment files; writing moves to a
+ * new one after SEGMENT_BYTES. A segment is deleted once every record in it
+ * is done() (committed or failed for good), and the current one is
+ * truncated whenever it has nothing outstanding, so a quiet journal is
+ * empty. The truncation is not synced: after a crash, records done just
+ * before it can come back from open(). A committed one is told apart by
+ * its token in the database (OrderQueue). A failed one must never be
+ * replayed, so fail() overwrites the first byte of its line with
+ * FAILED_MARK and syncs that before the failure is reported; open() skips
+ * marked lines.
+ */
+class OrderJournal {
+public:
+    static constexpr uint64_t SEGMENT_BYTES = 4 * 1024 * 1024;
+    static constexpr char FAILED_MARK = '-';
+
+    explicit OrderJournal(std::string dir);
+    ~OrderJournal();
+    OrderJournal(const OrderJournal&) = delete;
+    OrderJournal& operator=(const OrderJournal&) = delete;
+
+    /// Create the directory if needed, read every record left in it (oldest first) and open a new segment. Throws std::system_error.
+    std::vector<JournalRecord> open();
+    /// Write `record` (its segment is set) and return the position to sync(). Throws std::system_error.
+    uint64_t append(JournalRecord& record);
+    /// Return once everything up to `position` is on disk. Throws std::system_error.
+    void sync(uint64_t position);
+    /// The record from `segment` no longer needs replaying.
+    void done(uint64_t segment);
+    /// Mark `record` failed on disk, synced, then done(). Throws std::system_error; the record stays outstanding.
+    void fail(const JournalRecord& record);
+    /// Close the file; an empty current segment is deleted.
+    void close();
+
+    OrderJournalMetrics metrics() const;
+
+    static std::string encode(const JournalRecord& record);
+    /// False for a torn or corrupt line.
+    static bool decode(const std::string& line, JournalRecord& out);
+
+private:
+    std::string path_of(uint64_t segment) const;
+    void open_segment(uint64_t segment);  // mu_ held
+    void roll();                          // mu_ held
+    void remove_segment(uint64_t segment);  // mu_ held
+
+    std::string dir_;
+    mutable std::mutex mu_;
+    std::condition_variable cv_;
+    int fd_ = -1;
+    uint64_t segment_ = 0;
+    uint64_t segment_bytes_ = 0;
+    std::map<uint64_t, uint64_t> outstanding_;  // segment -> records not done
+    uint64_t written_ = 0;  // bytes appended since open(), over all segments
+    uint64_t synced_ = 0;   // of which on disk
+    bool syncing_ = false;
+
+    uint64_t appended_ = 0;
+    uint64_t syncs_ = 0;
+};
+
+} // namespace server
@@ -0,0 +1,403 @@
+#include "server/order_queue.h"
+#include "db/connection.h"
+#include "db/row_mapping.h"
+#include "server/stock_committer.h"
+#include <pqxx/pqxx>
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <unordered_set>
+
+namespace server {
+
+namespace {
+
+// 128 random bits as hex: the order's name until it has an id.
+std::string new_token() {
+    thread_local std::mt19937_64 rng{std::random_device{}()};
+    static const char HEX[] = "0123456789abcdef";
+    std::string token(32, '0');
+    for (int half = 0; half < 2; half++) {
+        uint64_t bits = rng();
+        for (int i = 0; i < 16; i++, bits >>= 4) token[static_cast<size_t>(half * 16 + i)] = HEX[bits & 0xf];
+    }
+    return token;
+}
+
+// Postgres array literal for an array-typed parameter ("{1,2,3}"); the values need no quoting.
+template <typename T, typename ToText>
+std::string array_literal(const std::vector<T>& values, ToText&& to_text) {
+    std::string s = "{";
+    for (size_t i = 0; i < values.size(); i++) {
+        if (i) s += ',';
+        s += to_text(values[i]);
+    }
+    s += '}';
+    return s;
+}
+
+std::string int_array(const std::vector<int>& values) {
+    return array_literal(values, [](int v) { return std::to_string(v); });
+}
+
+OrderStatus failed_status(std::string error) {
+    OrderStatus s;
+    s.state = OrderState::Failed;
+    s.error = std::move(error);
+    return s;
+}
+
+OrderStatus committed_status(int order_id, Money total) {
+    OrderStatus s;
+    s.state = OrderState::Committed;
+    s.order_id = order_id;
+    s.total = total;
+    return s;
+}
+
+std::string reserve_error(StockLedger::Reserve r, int product_id) {
+    if (r == StockLedger::Reserve::Unknown) return "Product not found: " + std::to_string(product_id);
+    return "Insufficient stock for product " + std::to_string(product_id);
+}
+
+/**
+ * Write `orders` in one transaction: four statements whatever their number.
+ * An order naming a product that no longer exists gets a Failed status and
+ * is left out. Statuses are only filled in once the transaction committed.
+ * Throws whatever pqxx throws, with nothing written.
+ */
+void write_orders(const std::vector<const JournalRecord*>& orders, std::vector<std::optional<OrderStatus>>& out) {
+    auto conn = Database::instance().acquire();
+    pqxx::work txn(*conn);
+
+    std::vector<int> productIds;
+    std::unordered_set<int> seen;
+    for (const auto* o : orders) {
+        for (const auto& [productId, qty] : o->items) {
+            if (seen.insert(productId).second) productIds.push_back(productId);
+        }
+    }
+    std::unordered_map<int, Money> prices;
+    for (const auto& row : txn.exec_prepared("order_prices_batch", int_array(productIds))) {
+        prices[row[0].as<int>()] = row_mapping::money(row[1]);
+    }
+
+    std::vector<std::optional<OrderStatus>> results(orders.size());
+    std::vector<size_t> placed;
+    std::vector<int> users;
+    std::vector<Money> totals;
+    std::vector<std::string> tokens;
+    for (size_t i = 0; i < orders.size(); i++) {
+        Money total;
+        int missing = 0;
+        for (const auto& [productId, qty] : orders[i]->items) {
+            auto it = prices.find(productId);
+            if (it == prices.end()) {
+                missing = productId;
+                break;
+            }
+            total += it->second * qty;
+        }
+        if (missing) {
+            results[i] = failed_status("Product not found: " + std::to_string(missing));
+            continue;
+        }
+        placed.push_back(i);
+        users.push_back(orders[i]->user_id);
+        totals.push_back(total);
+        tokens.push_back(orders[i]->token);
+    }
+
+    if (!placed.empty()) {
+        auto inserted = txn.exec_prepared("orders_insert_batch", int_array(users),
+            array_literal(totals, [](Money m) { return m.str(); }),
+            array_literal(tokens, [](const std::string& t) { return t; }));
+        std::unordered_map<std::string, int> ids;
+        for (const auto& row : inserted) ids[row[1].as<std::string>()] = row[0].as<int>();
+
+        std::vector<int> itemOrders, itemProducts, itemQtys;
+        std::vector<Money> itemPrices;
+        for (size_t i : placed) {
+            int orderId = ids.at(orders[i]->token);
+            for (const auto& [productId, qty] : orders[i]->items) {
+                itemOrders.push_back(orderId);
+                itemProducts.push_back(productId);
+                itemQtys.push_back(qty);
+                itemPrices.push_back(prices[productId]);
+            }
+        }
+        txn.exec_prepared("order_items_insert_batch", int_array(itemOrders), int_array(itemProducts),
+            int_array(itemQtys), array_literal(itemPrices, [](Money m) { return m.str(); }));
+        txn.exec_prepared("carts_clear_batch", int_array(users));
+        for (size_t k = 0; k < placed.size(); k++) {
+            results[placed[k]] = committed_status(ids.at(tokens[k]), totals[k]);
+        }
+    }
+    txn.commit();
+    for (size_t i = 0; i < results.size(); i++) out[i] = std::move(results[i]);
+}
+
+// After an error that may have followed a commit (in doubt): is the order there?
+std::optional<OrderStatus> find_committed(const std::string& token) {
+    auto conn = Database::instance().acquire();
+    pqxx::work txn(*conn);
+    auto r = txn.exec_prepared("order_by_token", token);
+    txn.commit();
+    if (r.empty()) return std::nullopt;
+    return committed_status(r[0][0].as<int>(), row_mapping::money(r[0][1]));
+}
+
+} // namespace
+
+OrderQueue& OrderQueue::instance() {
+    static OrderQueue queue;
+    return queue;
+}
+
+OrderQueue::~OrderQueue() {
+    // main() calls stop() while the database is still open; nothing is committed from here.
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        stopping_ = true;
+        cv_.notify_all();
+    }
+    if (thread_.joinable()) thread_.join();
+}
+
+void OrderQueue::configure(size_t max_queued, size_t batch_max) {
+    std::lock_guard<std::mutex> lock(mu_);
+    max_queued_ = max_queued;
+    batch_max_ = std::max<size_t>(1, batch_max);
+}
+
+size_t OrderQueue::open(const std::string& dir) {
+    journal_ = std::make_unique<OrderJournal>(dir);
+    auto records = journal_->open();
+    if (records.empty()) return 0;
+
+    auto& ledger = StockCommitter::instance().ledger();
+    auto conn = Database::instance().acquire();
+    pqxx::work txn(*conn);
+    size_t requeued = 0;
+    for (auto& r : records) {
+        std::optional<OrderStatus> status;
+        auto found = txn.exec_prepared("order_by_token", r.token);
+        if (!found.empty()) {
+            status = committed_status(found[0][0].as<int>(), row_mapping::money(found[0][1]));
+        } else {
+            // Its stock was reserved in the crashed process only: take it again.
+            int failed = 0;
+            auto reserved = ledger.reserve_all(r.items, failed);
+            if (reserved != StockLedger::Reserve::Ok) status = failed_status(reserve_error(reserved, failed));
+        }
+        if (status && status->state == OrderState::Failed) journal_->fail(r);  // before anyone can see it
+        std::lock_guard<std::mutex> lock(mu_);
+        if (status) {
+            statuses_[r.token] = *status;
+            finished_.push_back(r.token);
+            if (status->state == OrderState::Committed) journal_->done(r.segment);
+            continue;
+        }
+        statuses_[r.token] = OrderStatus{};
+        queue_.push_back(std::move(r));
+        replayed_++;
+        requeued++;
+    }
+    txn.commit();
+    return requeued;
+}
+
+void OrderQueue::start() {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (thread_.joinable() || !journal_) return;
+    stopping_ = false;
+    thread_ = std::thread([this] { run(); });
+    enabled_.store(true, std::memory_order_release);
+}
+
+void OrderQueue::stop() {
+    enabled_.store(false, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        stopping_ = true;
+        cv_.notify_all();
+    }
+    if (thread_.joinable()) thread_.join();
+    if (journal_) journal_->close();
+}
+
+OrderQueue::Submit OrderQueue::submit(int user_id, const std::vector<std::pair<int, int>>& items, std::string& token) {
+    JournalRecord record;
+    record.token = new_token();
+    record.user_id = user_id;
+    record.items = items;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (stopping_ || queue_.size() + journaling_ >= max_queued_) {
+            rejected_full_++;
+            return Submit::Full;
+        }
+        journaling_++;
+    }
+    try {
+        journal_->sync(journal_->append(record));
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mu_);
+        journaling_--;
+        if (record.segment) {
+            // The caller places the order synchronously instead: this copy must not be replayed.
+            try {
+                journal_->fail(record);
+            } catch (std::exception&) {
+                journal_->done(record.segment);
+            }
+        }
+        throw;
+    }
+    std::lock_guard<std::mutex> lock(mu_);
+    journaling_--;
+    token = record.token;
+    statuses_[token] = OrderStatus{};
+    queue_.push_back(std::move(record));
+    accepted_++;
+    if (queue_.size() == 1) cv_.notify_all();
+    return Submit::Queued;
+}
+
+std::optional<OrderStatus> OrderQueue::status(const std::string& token) const {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = statuses_.find(token);
+    if (it == statuses_.end()) return std::nullopt;
+    return it->second;
+}
+
+void OrderQueue::finish(const JournalRecord& order, OrderStatus status) {
+    if (status.state == OrderState::Failed) {
+        journal_->fail(order);  // a replay must not commit an order reported failed
+        StockCommitter::instance().ledger().release_all(order.items);
+    }
+    std::lock_guard<std::mutex> lock(mu_);
+    if (status.state == OrderState::Failed) failed_++;
+    else committed_++;
+    bool committed = status.state == OrderState::Committed;
+    statuses_[order.token] = std::move(status);
+    finished_.push_back(order.token);
+    while (finished_.size() > STATUS_KEEP) {
+        statuses_.erase(finished_.front());
+        finished_.pop_front();
+    }
+    if (committed) journal_->done(order.segment);  // fail() did it for a failed one
+}
+
+bool OrderQueue::commit_batch(std::vector<JournalRecord>& batch) {
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<const JournalRecord*> all;
+    all.reserve(batch.size());
+    for (const auto& o : batch) all.push_back(&o);
+    std::vector<std::optional<OrderStatus>> results(batch.size());
+    uint64_t placed = 0;
+    bool retried = false;
+    try {
+        write_orders(all, results);
+    } catch (pqxx::sql_error&) {
+        // One order is at fault (a deleted user, say): find it by writing them one at a time.
+        retried = true;
+        for (size_t i = 0; i < batch.size(); i++) {
+            std::vector<std::optional<OrderStatus>> one(1);
+            try {
+                write_orders({all[i]}, one);
+                results[i] = std::move(one[0]);
+            } catch (pqxx::sql_error& e) {
+                results[i] = failed_status(e.what());
+            } catch (std::exception& e) {
+                std::cerr << "Order batch failed: " << e.what() << std::endl;
+                break;  // connection trouble: the rest is retried later
+            }
+        }
+    } catch (std::exception& e) {
+        std::cerr << "Order batch failed: " << e.what() << std::endl;
+    }
+
+    std::vector<JournalRecord> left;
+    for (size_t i = 0; i < batch.size(); i++) {
+        if (!results[i]) {
+            left.push_back(std::move(batch[i]));
+            continue;
+        }
+        if (results[i]->state == OrderState::Failed && retried) {
+            // A commit whose acknowledgement was lost fails again on the token: it is in.
+            try {
+                if (auto found = find_committed(batch[i].token)) results[i] = std::move(found);
+            } catch (std::exception&) {
+                left.push_back(std::move(batch[i]));
+                continue;
+            }
+        }
+        bool committed = results[i]->state == OrderState::Committed;
+        try {
+            finish(batch[i], std::move(*results[i]));
+        } catch (std::exception& e) {
+            // The failure could not be made durable: keep it queued rather than report it.
+            std::cerr << "Order journal: " << e.what() << std::endl;
+            left.push_back(std::move(batch[i]));
+            continue;
+        }
+        if (committed) placed++;
+    }
+    if (placed > 0) StockCommitter::instance().committed(placed);
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (retried) batch_retries_++;
+        if (placed > 0) {
+            batches_++;
+            largest_batch_ = std::max(largest_batch_, batch.size());
+            last_batch_ms_ = ms;
+        }
+    }
+    batch = std::move(left);
+    return batch.empty();
+}
+
+void OrderQueue::run() {
+    std::unique_lock<std::mutex> lock(mu_);
+    while (true) {
+        cv_.wait(lock, [&] { return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) break;  // stopping, and everything is committed
+        // Everything that queued while the last batch committed, up to batch_max.
+        size_t n = std::min(queue_.size(), batch_max_);
+        std::vector<JournalRecord> batch(std::make_move_iterator(queue_.begin()),
+                                         std::make_move_iterator(queue_.begin() + static_cast<std::ptrdiff_t>(n)));
+        queue_.erase(queue_.begin(), queue_.begin() + static_cast<std::ptrdiff_t>(n));
+        lock.unlock();
+        bool done = commit_batch(batch);
+        lock.lock();
+        if (done) continue;
+        if (stopping_) break;  // still journaled: the next start re-queues it
+        queue_.insert(queue_.begin(), std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+        cv_.wait_for(lock, RETRY_DELAY, [&] { return stopping_; });
+    }
+}
+
+OrderQueueMetrics OrderQueue::metrics() const {
+    OrderQueueMetrics m;
+    m.enabled = enabled();
+    if (journal_) m.journal = journal_->metrics();
+    std::lock_guard<std::mutex> lock(mu_);
+    m.queued = queue_.size();
+    m.max_queued = max_queued_;
+    m.accepted = accepted_;
+    m.rejected_full = rejected_full_;
+    m.replayed = replayed_;
+    m.committed = committed_;
+    m.failed = failed_;
+    m.batches = batches_;
+    m.batch_retries = batch_retries_;
+    m.largest_batch = largest_batch_;
+    m.last_batch_ms = last_batch_ms_;
+    return m;
+}
+
+} // namespace server
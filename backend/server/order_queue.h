@@ -0,0 +1,141 @@
+#pragma once
+
+#include "server/order_journal.h"
+#include "utils/money.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace server {
+
+enum class OrderState { Queued, Committed, Failed };
+
+struct OrderStatus {
+    OrderState state = OrderState::Queued;
+    int order_id = 0;     // Committed
+    Money total;          // Committed
+    std::string error;    // Failed
+};
+
+struct OrderQueueMetrics {
+    bool enabled = false;
+    size_t queued = 0;
+    size_t max_queued = 0;
+    uint64_t accepted = 0;        // 202s
+    uint64_t rejected_full = 0;   // 503: queue at max_queued
+    uint64_t replayed = 0;        // re-queued from the journal at startup
+    uint64_t committed = 0;
+    uint64_t failed = 0;
+    uint64_t batches = 0;         // transactions that committed orders
+    uint64_t batch_retries = 0;   // batches that failed and were retried one order per transaction
+    size_t largest_batch = 0;
+    double last_batch_ms = 0;
+    OrderJournalMetrics journal;
+};
+
+/**
+ * Asynchronous order pipeline for POST /api/orders/create with
+ * `Prefer: respond-async` (order_queue on).
+ *
+ * The request thread validates the order and reserves its stock in the
+ * stock ledger (server/stock_ledger.h), as the synchronous path does; the
+ * order is then written to the journal (server/order_journal.h), queued,
+ * and answered with 202 and a token once the journal is on disk. A single
+ * writer thread takes up to batch_max queued orders at a time and commits
+ * them in one transaction with a handful of array statements (prices,
+ * orders, items, carts) however many orders the batch holds. Orders that
+ * arrive while a batch commits form the next one, so batches grow with load.
+ *
+ * If a batch fails on an SQL error it is retried one order per transaction,
+ * so only the order at fault fails; it is marked failed in the journal
+ * (synced, so a replay skips it), then gets its stock back and the error in
+ * its status. Connection errors keep the batch and retry it later. Orders
+ * left in the journal by a crash are re-queued at startup; tokens are
+ * stored with the order (orders.token), so an order the crash interrupted
+ * after its commit is not written twice.
+ *
+ * GET /api/orders/status/<token> reads status(): the last STATUS_KEEP
+ * finished orders are kept in memory, older ones are looked up by token.
+ */
+class OrderQueue {
+public:
+    static constexpr size_t STATUS_KEEP = 100000;
+    static constexpr auto RETRY_DELAY = std::chrono::seconds(1);
+
+    enum class Submit { Queued, Full };
+
+    static OrderQueue& instance();
+
+    /// Queue bound and largest batch (reloadable).
+    void configure(size_t max_queued, size_t batch_max);
+    /**
+     * Open the journal in `dir` and re-queue what a previous run accepted
+     * but did not commit. Needs the stock ledger loaded (StockCommitter::load).
+     * Returns the number of orders re-queued. Throws on journal or DB errors.
+     */
+    size_t open(const std::string& dir);
+    /// Start the writer thread: orders are accepted from now on.
+    void start();
+    /// Stop accepting, commit what is queued, close the journal. What cannot be committed stays journaled.
+    void stop();
+    bool enabled() const { return enabled_.load(std::memory_order_acquire); }
+
+    /**
+     * Queue an order whose stock is already reserved; on Queued it is on
+     * disk and `token` names it. Items must have quantity >= 1.
+     * Throws std::system_error if the journal cannot be written.
+     */
+    Submit submit(int user_id, const std::vector<std::pair<int, int>>& items, std::string& token);
+    /// Queued, committed or failed; nullopt if not known in memory.
+    std::optional<OrderStatus> status(const std::string& token) const;
+
+    OrderQueueMetrics metrics() const;
+
+private:
+    OrderQueue() = default;
+    ~OrderQueue();
+
+    void run();
+    /// Commit `batch`, finishing each order; false on a connection error, with the unfinished orders left in it.
+    bool commit_batch(std::vector<JournalRecord>& batch);
+    /// Throws std::system_error if a failure cannot be marked in the journal; nothing is reported then.
+    void finish(const JournalRecord& order, OrderStatus status);
+
+    std::unique_ptr<OrderJournal> journal_;
+    std::atomic<bool> enabled_{false};
+
+    mutable std::mutex mu_;
+    std::condition_variable cv_;
+    std::deque<JournalRecord> queue_;
+    size_t max_queued_ = 10000;
+    size_t batch_max_ = 500;
+    size_t journaling_ = 0;  // submits between the bound check and the queue
+    bool stopping_ = false;
+    std::thread thread_;
+
+    std::unordered_map<std::string, OrderStatus> statuses_;
+    std::deque<std::string> finished_;  // oldest first, for eviction
+
+    uint64_t accepted_ = 0;
+    uint64_t rejected_full_ = 0;
+    uint64_t replayed_ = 0;
+    uint64_t committed_ = 0;
+    uint64_t failed_ = 0;
+    uint64_t batches_ = 0;
+    uint64_t batch_retries_ = 0;
+    size_t largest_batch_ = 0;
+    double last_batch_ms_ = 0;
+};
+
+} // namespace server
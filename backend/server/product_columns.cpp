@@ -0,0 +1,277 @@
+#include "server/product_columns.h"
+#include "db/pg_binary.h"
+#include <algorithm>
+#include <atomic>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PRODUCT_STORE_AVX2 1
+#endif
+
+namespace server {
+
+namespace {
+
+constexpr size_t ROWS_PER_WORD = 64;
+
+// Portable kernels: branchless, one bit per row, one 64-row word at a time.
+// words = padded rows / 64; `out` has `words` entries.
+
+void range_i64_portable(const int64_t* v, size_t words, int64_t lo, int64_t hi, uint64_t* out) {
+    // lo <= x <= hi as one unsigned compare: x - lo wraps above hi - lo when x < lo.
+    auto span = static_cast<uint64_t>(hi) - static_cast<uint64_t>(lo);
+    for (size_t w = 0; w < words; w++, v += ROWS_PER_WORD) {
+        uint64_t bits = 0;
+        for (size_t j = 0; j < ROWS_PER_WORD; j++) {
+            bits |= static_cast<uint64_t>(static_cast<uint64_t>(v[j]) - static_cast<uint64_t>(lo) <= span) << j;
+        }
+        out[w] = bits;
+    }
+}
+
+void and_gt_i32_portable(const int32_t* v, size_t words, int32_t k, uint64_t* out) {
+    for (size_t w = 0; w < words; w++, v += ROWS_PER_WORD) {
+        uint64_t bits = 0;
+        for (size_t j = 0; j < ROWS_PER_WORD; j++) bits |= static_cast<uint64_t>(v[j] > k) << j;
+        out[w] &= bits;
+    }
+}
+
+void and_eq_i32_portable(const int32_t* v, size_t words, int32_t k, uint64_t* out) {
+    for (size_t w = 0; w < words; w++, v += ROWS_PER_WORD) {
+        uint64_t bits = 0;
+        for (size_t j = 0; j < ROWS_PER_WORD; j++) bits |= static_cast<uint64_t>(v[j] == k) << j;
+        out[w] &= bits;
+    }
+}
+
+#ifdef PRODUCT_STORE_AVX2
+
+// AVX2 kernels: 4 int64 or 8 int32 rows per compare, the lane masks gathered
+// with movemask. Compiled for AVX2 with a target attribute, so the rest of the
+// binary keeps the baseline ISA; they only run if the CPU reports AVX2.
+
+__attribute__((target("avx2"))) void range_i64_avx2(const int64_t* v, size_t words, int64_t lo, int64_t hi,
+                                                     uint64_t* out) {
+    const __m256i vlo = _mm256_set1_epi64x(lo);
+    const __m256i vhi = _mm256_set1_epi64x(hi);
+    for (size_t w = 0; w < words; w++, v += ROWS_PER_WORD) {
+        uint64_t bits = 0;
+        for (size_t j = 0; j < ROWS_PER_WORD; j += 4) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + j));
+            __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi64(vlo, x), _mm256_cmpgt_epi64(x, vhi));
+            auto miss = static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(outside)));
+            bits |= static_cast<uint64_t>(~miss & 0xFu) << j;
+        }
+        out[w] = bits;
+    }
+}
+
+__attribute__((target("avx2"))) void and_gt_i32_avx2(const int32_t* v, size_t words, int32_t k, uint64_t* out) {
+    const __m256i vk = _mm256_set1_epi32(k);
+    for (size_t w = 0; w < words; w++, v += ROWS_PER_WORD) {
+        uint64_t bits = 0;
+        for (size_t j = 0; j < ROWS_PER_WORD; j += 8) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + j));
+            auto hit = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(x, vk))));
+            bits |= static_cast<uint64_t>(hit) << j;
+        }
+        out[w] &= bits;
+    }
+}
+
+__attribute__((target("avx2"))) void and_eq_i32_avx2(const int32_t* v, size_t words, int32_t k, uint64_t* out) {
+    const __m256i vk = _mm256_set1_epi32(k);
+    for (size_t w = 0; w < words; w++, v += ROWS_PER_WORD) {
+        uint64_t bits = 0;
+        for (size_t j = 0; j < ROWS_PER_WORD; j += 8) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + j));
+            auto hit = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(x, vk))));
+            bits |= static_cast<uint64_t>(hit) << j;
+        }
+        out[w] &= bits;
+    }
+}
+
+bool cpu_has_avx2() {
+    return __builtin_cpu_supports("avx2");
+}
+
+#else
+
+bool cpu_has_avx2() {
+    return false;
+}
+
+#endif
+
+std::atomic<ScanKernels>& kernels_setting() {
+    static std::atomic<ScanKernels> kernels{cpu_has_avx2() ? ScanKernels::Avx2 : ScanKernels::Portable};
+    return kernels;
+}
+
+template <typename T>
+std::vector<T> padded(size_t rows) {
+    return std::vector<T>((rows + ROWS_PER_WORD - 1) / ROWS_PER_WORD * ROWS_PER_WORD);
+}
+
+} // namespace
+
+ScanKernels scan_kernels() {
+    return kernels_setting().load(std::memory_order_relaxed);
+}
+
+void set_scan_kernels(ScanKernels kernels) {
+    if (kernels == ScanKernels::Avx2 && !cpu_has_avx2()) kernels = ScanKernels::Portable;
+    kernels_setting().store(kernels, std::memory_order_relaxed);
+}
+
+const char* scan_kernels_name(ScanKernels kernels) {
+    return kernels == ScanKernels::Avx2 ? "avx2" : "portable";
+}
+
+ProductColumns::ProductColumns(std::vector<Product> products) : size_(products.size()) {
+    auto ids = padded<int32_t>(size_);
+    auto category_ids = padded<int32_t>(size_);
+    auto price_cents = padded<int64_t>(size_);
+    auto created_us = padded<int64_t>(size_);
+    auto categories = std::make_shared<std::unordered_map<std::string, int>>();
+    for (size_t i = 0; i < size_; i++) {
+        const Product& p = products[i];
+        ids[i] = p.id;
+        category_ids[i] = p.category_id;
+        price_cents[i] = p.price.cents();
+        int64_t created = 0;
+        if (!p.created_at.empty() && !pg_binary::parse_timestamp(p.created_at, created)) created = 0;
+        created_us[i] = created;
+        if (!p.category_name.empty()) categories->emplace(p.category_name, p.category_id);
+    }
+    for (size_t first = 0; first < size_; first += ROWS_PER_CHUNK) {
+        size_t n = std::min(ROWS_PER_CHUNK, size_ - first);
+        auto stock = std::make_shared<std::vector<int32_t>>(ROWS_PER_CHUNK);
+        for (size_t j = 0; j < n; j++) (*stock)[j] = products[first + j].stock;
+        stock_.push_back(std::move(stock));
+        auto begin = std::make_move_iterator(products.begin() + static_cast<std::ptrdiff_t>(first));
+        rows_.push_back(std::make_shared<const std::vector<Product>>(begin, begin + static_cast<std::ptrdiff_t>(n)));
+    }
+    // Padding rows hold zeros; select() clears their bits.
+    ids_ = std::make_shared<const std::vector<int32_t>>(std::move(ids));
+    category_ids_ = std::make_shared<const std::vector<int32_t>>(std::move(category_ids));
+    price_cents_ = std::make_shared<const std::vector<int64_t>>(std::move(price_cents));
+    created_us_ = std::make_shared<const std::vector<int64_t>>(std::move(created_us));
+    categories_ = std::move(categories);
+}
+
+std::optional<uint32_t> ProductColumns::row_of(int id) const {
+    // Rows are in id order; the zero padding past size() is not searched.
+    auto end = ids_->begin() + static_cast<std::ptrdiff_t>(size_);
+    auto it = std::lower_bound(ids_->begin(), end, id);
+    if (it == end || *it != id) return std::nullopt;
+    return static_cast<uint32_t>(it - ids_->begin());
+}
+
+int ProductColumns::category_id(std::string_view name) const {
+    auto it = categories_->find(std::string(name));
+    return it == categories_->end() ? ProductQuery::NO_CATEGORY : it->second;
+}
+
+void ProductColumns::select(const ProductQuery& q, std::vector<uint64_t>& bits) const {
+    size_t words = price_cents_->size() / ROWS_PER_WORD;
+    bits.assign(words, 0);
+    if (words == 0 || q.min_cents > q.max_cents) return;
+
+    bool avx2 = scan_kernels() == ScanKernels::Avx2;
+#ifdef PRODUCT_STORE_AVX2
+    auto range_i64 = avx2 ? range_i64_avx2 : range_i64_portable;
+    auto and_gt_i32 = avx2 ? and_gt_i32_avx2 : and_gt_i32_portable;
+    auto and_eq_i32 = avx2 ? and_eq_i32_avx2 : and_eq_i32_portable;
+#else
+    (void)avx2;
+    auto range_i64 = range_i64_portable;
+    auto and_gt_i32 = and_gt_i32_portable;
+    auto and_eq_i32 = and_eq_i32_portable;
+#endif
+    if (q.min_cents == INT64_MIN && q.max_cents == INT64_MAX) bits.assign(words, ~uint64_t{0});
+    else range_i64(price_cents_->data(), words, q.min_cents, q.max_cents, bits.data());
+    if (q.in_stock) {
+        constexpr size_t words_per_chunk = ROWS_PER_CHUNK / ROWS_PER_WORD;
+        for (size_t c = 0; c < stock_.size(); c++) {
+            size_t first = c * words_per_chunk;
+            and_gt_i32(stock_[c]->data(), std::min(words_per_chunk, words - first), 0, bits.data() + first);
+        }
+    }
+    if (q.category_id != ProductQuery::ANY_CATEGORY) and_eq_i32(category_ids_->data(), words, q.category_id, bits.data());
+
+    size_t tail = size_ % ROWS_PER_WORD;
+    if (tail != 0) bits[words - 1] &= (uint64_t{1} << tail) - 1;
+}
+
+std::vector<uint32_t> ProductColumns::query(const ProductQuery& q) const {
+    std::vector<uint64_t> bits;
+    select(q, bits);
+
+    size_t matches = 0;
+    for (uint64_t w : bits) matches += static_cast<size_t>(__builtin_popcountll(w));
+    std::vector<uint32_t> rows;
+    rows.reserve(matches);
+    for (size_t w = 0; w < bits.size(); w++) {
+        for (uint64_t b = bits[w]; b != 0; b &= b - 1) {
+            rows.push_back(static_cast<uint32_t>(w * ROWS_PER_WORD + static_cast<size_t>(__builtin_ctzll(b))));
+        }
+    }
+
+    size_t keep = q.limit != 0 && q.limit < rows.size() ? q.limit : rows.size();
+    auto order = [&](auto less) {
+        if (keep < rows.size()) std::partial_sort(rows.begin(), rows.begin() + static_cast<std::ptrdiff_t>(keep), rows.end(), less);
+        else std::sort(rows.begin(), rows.end(), less);
+    };
+    // Ties go by id, so equal prices keep a stable order across requests.
+    const int64_t* price = price_cents_->data();
+    const int64_t* created = created_us_->data();
+    const int32_t* id = ids_->data();
+    switch (q.sort) {
+    case ProductQuery::Sort::Price:
+        order([=](uint32_t a, uint32_t b) { return price[a] != price[b] ? price[a] < price[b] : id[a] < id[b]; });
+        break;
+    case ProductQuery::Sort::PriceDesc:
+        order([=](uint32_t a, uint32_t b) { return price[a] != price[b] ? price[a] > price[b] : id[a] < id[b]; });
+        break;
+    case ProductQuery::Sort::Newest:
+        order([=](uint32_t a, uint32_t b) { return created[a] != created[b] ? created[a] > created[b] : id[a] > id[b]; });
+        break;
+    case ProductQuery::Sort::Id:
+        break;  // rows are in id order already
+    }
+    rows.resize(keep);
+    return rows;
+}
+
+std::shared_ptr<const ProductColumns> ProductColumns::with_stock(const std::vector<std::pair<int, int64_t>>& stock,
+                                                                 std::vector<int>& changed) const {
+    std::shared_ptr<ProductColumns> copy;  // shares every column and chunk until one is written
+    // The chunks this patch copied, writable through these until it returns.
+    std::vector<std::pair<std::vector<int32_t>*, std::vector<Product>*>> copied;
+    for (const auto& [id, value] : stock) {
+        auto row = row_of(id);
+        if (!row) continue;
+        auto count = static_cast<int32_t>(std::clamp<int64_t>(value, INT32_MIN, INT32_MAX));
+        if ((copy ? copy->product(*row) : product(*row)).stock == count) continue;
+        if (!copy) {
+            copy = std::make_shared<ProductColumns>(*this);
+            copied.assign(rows_.size(), {nullptr, nullptr});
+        }
+        size_t c = *row / ROWS_PER_CHUNK;
+        if (!copied[c].first) {
+            auto s = std::make_shared<std::vector<int32_t>>(*stock_[c]);
+            auto r = std::make_shared<std::vector<Product>>(*rows_[c]);
+            copied[c] = {s.get(), r.get()};
+            copy->stock_[c] = std::move(s);
+            copy->rows_[c] = std::move(r);
+        }
+        (*copied[c].first)[*row % ROWS_PER_CHUNK] = count;
+        (*copied[c].second)[*row % ROWS_PER_CHUNK].stock = count;
+        changed.push_back(id);
+    }
+    return copy;
+}
+
+} // namespace server
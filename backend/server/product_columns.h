@@ -0,0 +1,95 @@
+#pragma once
+
+#include "models/Product.h"
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace server {
+
+/// Filters and order of a catalog list (/api/products?min_price=&max_price=&in_stock=1&category=&sort=&limit=).
+struct ProductQuery {
+    static constexpr int ANY_CATEGORY = -1;
+    /// Matches no row: category ids are SERIALs, which start at 1.
+    static constexpr int NO_CATEGORY = 0;
+
+    enum class Sort { Id, Price, PriceDesc, Newest };
+
+    int64_t min_cents = INT64_MIN;
+    int64_t max_cents = INT64_MAX;
+    bool in_stock = false;
+    int category_id = ANY_CATEGORY;
+    Sort sort = Sort::Id;
+    size_t limit = 0;      // 0 = all matches
+};
+
+/// Predicate kernels used by ProductColumns::select(). Avx2 is picked at startup when the CPU has it.
+enum class ScanKernels { Portable, Avx2 };
+ScanKernels scan_kernels();
+/// Force a kernel set (benchmarks); Avx2 falls back to Portable on CPUs without it.
+void set_scan_kernels(ScanKernels kernels);
+const char* scan_kernels_name(ScanKernels kernels);
+
+/**
+ * Immutable structure-of-arrays copy of the catalog. The columns the filters
+ * and sorts read (id, category id, price in cents, stock, created_at in
+ * microseconds) sit in their own contiguous arrays, padded to a multiple of
+ * 64 rows, so a predicate is one pass over one array that fills a selection
+ * bitmap 64 rows per word (8 int32 or 4 int64 lanes per AVX2 compare).
+ * Predicates are ANDed word by word, the set bits become row indices, and
+ * sorted lists with a limit use a partial sort (top-K) instead of a full one.
+ * The Product rows are kept alongside, in the same order, for the response.
+ *
+ * Stock and the Product rows are stored in chunks of ROWS_PER_CHUNK rows
+ * held by shared_ptr, and the other columns are shared whole, so
+ * with_stock() builds the next snapshot by copying only the chunks an order
+ * touched.
+ */
+class ProductColumns {
+public:
+    static constexpr size_t ROWS_PER_CHUNK = 1024;  // a multiple of 64
+
+    /// `products` in id order (products_all).
+    explicit ProductColumns(std::vector<Product> products);
+
+    size_t size() const { return size_; }
+    const Product& product(size_t row) const { return (*rows_[row / ROWS_PER_CHUNK])[row % ROWS_PER_CHUNK]; }
+    /// Row of the product with `id`, if it is in the snapshot.
+    std::optional<uint32_t> row_of(int id) const;
+    /// Category id for a category name; ProductQuery::NO_CATEGORY if no product has it.
+    int category_id(std::string_view name) const;
+
+    /// Bitmap of the rows matching `q`'s predicates: bit i of word i / 64 for row i.
+    void select(const ProductQuery& q, std::vector<uint64_t>& bits) const;
+    /// Rows matching `q`, in its order, at most q.limit of them.
+    std::vector<uint32_t> query(const ProductQuery& q) const;
+
+    /// A copy with the stock of each (product id, stock) pair replaced; ids not
+    /// in the snapshot are skipped. Appends the ids whose stock differed to
+    /// `changed`; null if none did.
+    std::shared_ptr<const ProductColumns> with_stock(const std::vector<std::pair<int, int64_t>>& stock,
+                                                     std::vector<int>& changed) const;
+
+private:
+    template <typename T>
+    using Column = std::shared_ptr<const std::vector<T>>;
+    template <typename T>
+    using Chunks = std::vector<std::shared_ptr<const std::vector<T>>>;
+
+    size_t size_ = 0;
+    Column<int32_t> ids_;
+    Column<int32_t> category_ids_;
+    Column<int64_t> price_cents_;
+    Column<int64_t> created_us_;
+    Chunks<int32_t> stock_;  // ROWS_PER_CHUNK each, zero padded
+    Chunks<Product> rows_;   // ROWS_PER_CHUNK each, the last one shorter
+    std::shared_ptr<const std::unordered_map<std::string, int>> categories_;
+};
+
+} // namespace server
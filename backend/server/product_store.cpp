@@ -0,0 +1,309 @@
+#include "server/product_store.h"
+#include "db/connection.h"
+#include "db/row_mapping.h"
+#include <pqxx/pqxx>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <unordered_map>
+
+namespace server {
+
+namespace {
+
+// product_sales aggregates all of order_items; the suggest ranking can lag this much.
+constexpr int64_t SALES_REFRESH_MS = 60000;
+
+// FNV-1a over the fields that decide whether a rebuild is needed.
+struct Fingerprint {
+    uint64_t value = 14695981039346656037ULL;
+
+    void add(const void* data, size_t n) {
+        for (size_t i = 0; i < n; i++) value = (value ^ static_cast<const unsigned char*>(data)[i]) * 1099511628211ULL;
+    }
+    void add(const std::string& s) { add(s.c_str(), s.size() + 1); }
+    void add(int64_t v) { add(&v, sizeof(v)); }
+};
+
+bool same_row(const Product& a, const Product& b) {
+    return a.category_id == b.category_id && a.price.cents() == b.price.cents() && a.stock == b.stock &&
+        a.name == b.name && a.description == b.description && a.image_url == b.image_url &&
+        a.category_name == b.category_name && a.created_at == b.created_at;
+}
+
+// Both snapshots are in id order: one merge pass finds the changed, added and removed ids.
+void diff_rows(const ProductColumns& before, const ProductColumns& after, std::vector<int>& changed,
+               std::vector<int>& removed) {
+    size_t i = 0, j = 0;
+    while (i < before.size() || j < after.size()) {
+        if (j == after.size() || (i < before.size() && before.product(i).id < after.product(j).id)) {
+            removed.push_back(before.product(i++).id);
+        } else if (i == before.size() || after.product(j).id < before.product(i).id) {
+            changed.push_back(after.product(j++).id);
+        } else {
+            if (!same_row(before.product(i), after.product(j))) changed.push_back(after.product(j).id);
+            i++;
+            j++;
+        }
+    }
+}
+
+int64_t wall_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+ProductStore& ProductStore::instance() {
+    static ProductStore store;
+    return store;
+}
+
+ProductStore::~ProductStore() {
+    stop();
+}
+
+void ProductStore::refresh() {
+    auto t0 = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        refreshing_ = true;
+        replay_.clear();
+    }
+    std::vector<Product> products;
+    bool read_sales = sales_loaded_ms_ == 0 || now_ms() - sales_loaded_ms_ >= SALES_REFRESH_MS;
+    try {
+        auto conn = Database::instance().acquire();
+        pqxx::work txn(*conn);
+        auto r = txn.exec_prepared("products_all");
+        pqxx::result sales;
+        if (read_sales) sales = txn.exec_prepared("product_sales");
+        txn.commit();
+        products.reserve(r.size());
+        for (const auto& row : r) products.push_back(row_mapping::decode<Product>(row));
+        if (read_sales) {
+            sold_.clear();
+            for (const auto& row : sales) sold_[row[0].as<int>()] = row[1].as<int64_t>();
+            sales_loaded_ms_ = now_ms();
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mu_);
+        refreshing_ = false;
+        replay_.clear();
+        failures_++;
+        throw;
+    }
+
+    // The suggest trie only depends on names and sales; most refreshes leave
+    // both alone and keep the current one.
+    auto units_sold = [this](int id) {
+        auto it = sold_.find(id);
+        return it == sold_.end() ? int64_t{0} : it->second;
+    };
+    Fingerprint names;
+    for (const auto& p : products) {
+        names.add(p.id);
+        names.add(p.name);
+        names.add(units_sold(p.id));
+    }
+    uint64_t fingerprint = names.value;
+    std::shared_ptr<const SuggestIndex> suggest;
+    double suggest_ms = 0;
+    if (fingerprint != suggest_fingerprint_.load(std::memory_order_relaxed)) {
+        auto t1 = std::chrono::steady_clock::now();
+        std::vector<SuggestIndex::Entry> entries;
+        entries.reserve(products.size());
+        for (const auto& p : products) entries.push_back({p.id, p.name, units_sold(p.id)});
+        suggest = std::make_shared<const SuggestIndex>(std::move(entries));
+        suggest_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t1).count();
+    }
+
+    auto columns = std::make_shared<const ProductColumns>(std::move(products));
+
+    // Stock patched in after the read began may be missing from it; those
+    // rows are already in the change log under the version that patched them.
+    // What is left after replaying them was edited outside the order paths
+    // (SQL): compare every row with the current snapshot and log the differences.
+    std::shared_ptr<const ProductColumns> current;
+    std::vector<std::pair<int, int64_t>> replay;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        current = columns_;
+        replay = replay_;
+    }
+    std::vector<int> replayed, changed, removed;
+    if (auto patched = columns->with_stock(replay, replayed)) columns = std::move(patched);
+    if (current) diff_rows(*current, *columns, changed, removed);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    std::unique_lock<std::mutex> swap(patch_mu_);
+    std::unique_lock<std::mutex> lock(mu_);
+    if (replay_.size() > replay.size()) {
+        // Patched while the rows were compared: in columns_ and the log already.
+        std::vector<std::pair<int, int64_t>> rest(replay_.begin() + static_cast<std::ptrdiff_t>(replay.size()), replay_.end());
+        if (auto patched = columns->with_stock(rest, replayed)) columns = std::move(patched);
+    }
+    refreshing_ = false;
+    replay_.clear();
+    columns_ = std::move(columns);
+    if (suggest) {
+        suggest_ = std::move(suggest);
+        suggest_fingerprint_.store(fingerprint, std::memory_order_relaxed);
+        suggest_builds_++;
+        last_suggest_build_ms_ = suggest_ms;
+    }
+    ChangeListener notify;
+    uint64_t version = version_.load(std::memory_order_relaxed);
+    if (refreshes_ == 0) {
+        version = std::max<uint64_t>(version + 1, static_cast<uint64_t>(wall_ms()));
+        log_.reset(version);
+        version_.store(version, std::memory_order_release);
+    } else if (!changed.empty() || !removed.empty()) {
+        version++;
+        for (int id : changed) log_.record(version, id, false);
+        for (int id : removed) log_.record(version, id, true);
+        version_.store(version, std::memory_order_release);
+        notify = listener_;
+    }
+    loaded_at_ms_ = now_ms();
+    last_refresh_ms_ = ms;
+    refreshes_++;
+    lock.unlock();
+    swap.unlock();
+    if (notify) notify(version, changed, removed);
+}
+
+void ProductStore::start(int refresh_ms) {
+    std::lock_guard<std::mutex> lock(mu_);
+    refresh_ms_ = refresh_ms;
+    if (thread_.joinable()) return;
+    stopping_ = false;
+    thread_ = std::thread([this] { run(); });
+}
+
+void ProductStore::set_refresh_ms(int refresh_ms) {
+    std::lock_guard<std::mutex> lock(mu_);
+    refresh_ms_ = refresh_ms;
+    cv_.notify_all();
+}
+
+void ProductStore::apply_stock(const std::vector<std::pair<int, int64_t>>& stock) {
+    if (stock.empty()) return;
+    std::unique_lock<std::mutex> swap(patch_mu_);
+    std::unique_lock<std::mutex> lock(mu_);
+    if (!columns_) return;  // off, or not loaded yet: the first refresh() reads the stock
+    if (refreshing_) replay_.insert(replay_.end(), stock.begin(), stock.end());
+    auto current = columns_;
+    lock.unlock();
+
+    // patch_mu_ keeps columns_ as it is while the copy is built outside mu_.
+    std::vector<int> changed;
+    auto patched = current->with_stock(stock, changed);
+    if (!patched) return;
+
+    lock.lock();
+    columns_ = std::move(patched);
+    uint64_t version = version_.load(std::memory_order_relaxed) + 1;
+    for (int id : changed) log_.record(version, id, false);
+    version_.store(version, std::memory_order_release);
+    patches_++;
+    ChangeListener notify = listener_;
+    lock.unlock();
+    swap.unlock();
+    if (notify) notify(version, changed, {});
+}
+
+void ProductStore::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        stopping_ = true;
+        cv_.notify_all();
+    }
+    if (thread_.joinable()) thread_.join();
+}
+
+void ProductStore::run() {
+    auto last = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(mu_);
+    while (!stopping_) {
+        auto interval = std::chrono::milliseconds(refresh_ms_);
+        if (std::chrono::steady_clock::now() < last + interval) {
+            cv_.wait_until(lock, last + interval);  // re-evaluated on any notify
+            continue;
+        }
+        lock.unlock();
+        try {
+            refresh();
+        } catch (std::exception& e) {
+            std::cerr << "Product store refresh failed: " << e.what() << std::endl;
+        }
+        last = std::chrono::steady_clock::now();
+        lock.lock();
+    }
+}
+
+std::shared_ptr<const ProductColumns> ProductStore::snapshot() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return columns_;
+}
+
+ProductChanges ProductStore::changes_since(uint64_t since) const {
+    ProductChanges out;
+    std::vector<ProductChange> log;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        out.version = version_.load(std::memory_order_relaxed);
+        out.columns = columns_;
+        // A `since` from the future comes from another deployment's clock or a bad client.
+        out.full_resync = !columns_ || since > out.version || !log_.since(since, log);
+    }
+    if (out.full_resync) return out;
+    for (const auto& c : log) {
+        auto row = c.removed ? std::nullopt : out.columns->row_of(c.product_id);
+        if (row) out.changed.push_back(*row);
+        else out.removed.push_back(c.product_id);
+    }
+    return out;
+}
+
+void ProductStore::set_change_log_entries(size_t entries) {
+    std::lock_guard<std::mutex> lock(mu_);
+    log_.set_max_entries(entries);
+}
+
+void ProductStore::set_listener(ChangeListener listener) {
+    std::lock_guard<std::mutex> lock(mu_);
+    listener_ = std::move(listener);
+}
+
+std::shared_ptr<const SuggestIndex> ProductStore::suggestions() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return suggest_;
+}
+
+ProductStoreMetrics ProductStore::metrics() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    ProductStoreMetrics m;
+    m.rows = columns_ ? columns_->size() : 0;
+    m.refreshes = refreshes_;
+    m.refresh_failures = failures_;
+    m.queries = queries_.load(std::memory_order_relaxed);
+    m.last_refresh_ms = last_refresh_ms_;
+    m.patches = patches_;
+    m.age_ms = columns_ ? static_cast<double>(now_ms() - loaded_at_ms_) : 0;
+    m.version = version_.load(std::memory_order_acquire);
+    m.suggest_nodes = suggest_ ? suggest_->nodes() : 0;
+    m.suggest_bytes = suggest_ ? suggest_->bytes() : 0;
+    m.suggest_builds = suggest_builds_;
+    m.last_suggest_build_ms = last_suggest_build_ms_;
+    m.changes = log_.metrics();
+    return m;
+}
+
+} // namespace server
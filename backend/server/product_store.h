@@ -0,0 +1,136 @@
+#pragma once
+
+#include "server/change_log.h"
+#include "server/product_columns.h"
+#include "server/suggest_index.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace server {
+
+struct ProductStoreMetrics {
+    size_t rows = 0;
+    uint64_t refreshes = 0;
+    uint64_t refresh_failures = 0;
+    uint64_t queries = 0;
+    double last_refresh_ms = 0;
+    double age_ms = 0;  // since the current snapshot was loaded
+    uint64_t patches = 0;  // snapshots built by apply_stock()
+    uint64_t version = 0;
+    size_t suggest_nodes = 0;
+    size_t suggest_bytes = 0;
+    uint64_t suggest_builds = 0;
+    double last_suggest_build_ms = 0;
+    ChangeLogMetrics changes;
+};
+
+/// What changed in the catalog after a given version (/api/products/changes).
+struct ProductChanges {
+    uint64_t version = 0;      // the catalog version these changes bring the reader to
+    bool full_resync = false;  // the log no longer reaches back far enough; reload everything
+    std::shared_ptr<const ProductColumns> columns;  // holds the changed rows
+    std::vector<uint32_t> changed;                  // rows in `columns`, oldest change first
+    std::vector<int> removed;                       // product ids
+};
+
+/**
+ * The catalog snapshot behind the filtered product lists, so every filter
+ * combination is answered from memory instead of a Postgres query. refresh()
+ * loads products_all into a new ProductColumns and swaps it in; requests
+ * keep the snapshot they started with. A background thread refreshes every
+ * refresh_ms (product_store_refresh_ms).
+ *
+ * Orders do not reload the catalog: the code that changed stock passes the
+ * new counts to apply_stock(), which swaps in a copy of the snapshot with
+ * only those rows replaced (ProductColumns::with_stock). Patches that land
+ * while a refresh is reading the database are applied again to what it
+ * read, so a reload never brings back older stock. Two orders' patches can
+ * still be applied in the other order than their commits; the next refresh
+ * corrects that.
+ *
+ * Units sold per product are re-read at most once a minute, since they come
+ * from an aggregate over every order line. The suggest trie
+ * (server/suggest_index.h) is rebuilt when a name or a sales count changed.
+ *
+ * Every new snapshot bumps the catalog version and records the product ids
+ * it changed in the change log (server/change_log.h) under that version, in
+ * the same critical section as the swap, so the log never runs ahead of the
+ * snapshot. apply_stock() records the rows it patched. A refresh compares its
+ * rows with the current snapshot field by field and records what differs,
+ * which is only what was edited outside the order paths (SQL restocks, new
+ * or deleted products, price changes). Versions start at the wall-clock milliseconds of the first
+ * load, so they keep increasing across restarts.
+ */
+class ProductStore {
+public:
+    static ProductStore& instance();
+
+    /// Load the catalog now. Throws on DB errors (the old snapshot stays).
+    void refresh();
+    /// Start the refresh thread.
+    void start(int refresh_ms);
+    /// New refresh interval (config reload).
+    void set_refresh_ms(int refresh_ms);
+    /// Products' stock changed (an order): (product id, new stock) pairs, swapped
+    /// into a copy of the snapshot without reading the catalog. No-op before the first refresh().
+    void apply_stock(const std::vector<std::pair<int, int64_t>>& stock);
+    void stop();
+
+    /// Current snapshot; null before the first refresh().
+    std::shared_ptr<const ProductColumns> snapshot() const;
+    /// Bumped by every new snapshot that changed the catalog (any product
+    /// field): a patch or a refresh. 0 before the first. Caches of catalog reads key on it.
+    uint64_t version() const { return version_.load(std::memory_order_acquire); }
+    /// The products changed or removed after version `since`, against the current snapshot.
+    ProductChanges changes_since(uint64_t since) const;
+    /// Change log capacity in products (config reload).
+    void set_change_log_entries(size_t entries);
+    /// Called on the refreshing or patching thread after each version bump (not the first load), outside the lock.
+    using ChangeListener = std::function<void(uint64_t version, const std::vector<int>& changed,
+                                              const std::vector<int>& removed)>;
+    void set_listener(ChangeListener listener);
+    /// Current autocomplete index; null before the first refresh().
+    std::shared_ptr<const SuggestIndex> suggestions() const;
+    /// Count a query served from the snapshot.
+    void count_query() { queries_.fetch_add(1, std::memory_order_relaxed); }
+    ProductStoreMetrics metrics() const;
+
+private:
+    ProductStore() = default;
+    ~ProductStore();
+    void run();
+
+    std::mutex patch_mu_;  // serializes snapshot swaps: apply_stock() and the end of refresh()
+    mutable std::mutex mu_;
+    std::condition_variable cv_;
+    std::shared_ptr<const ProductColumns> columns_;
+    std::shared_ptr<const SuggestIndex> suggest_;
+    std::atomic<uint64_t> suggest_fingerprint_{0};
+    std::unordered_map<int, int64_t> sold_;          // refresh() only: units sold per product
+    int64_t sales_loaded_ms_ = 0;                    // refresh() only
+    std::atomic<uint64_t> version_{0};
+    ChangeLog log_{10000};
+    ChangeListener listener_;
+    uint64_t suggest_builds_ = 0;
+    double last_suggest_build_ms_ = 0;
+    int64_t loaded_at_ms_ = 0;
+    double last_refresh_ms_ = 0;
+    uint64_t refreshes_ = 0;
+    uint64_t failures_ = 0;
+    int refresh_ms_ = 5000;
+    bool refreshing_ = false;
+    std::vector<std::pair<int, int64_t>> replay_;  // apply_stock() calls since refreshing_ was set
+    uint64_t patches_ = 0;
+    bool stopping_ = false;
+    std::thread thread_;
+    std::atomic<uint64_t> queries_{0};
+};
+
+} // namespace server
@@ -0,0 +1,255 @@
+#include "server/product_stream.h"
+#include "server/db_task.h"
+#include "server/lifecycle.h"
+#include "server/product_store.h"
+#include "utils/serializer.h"
+#include <algorithm>
+#include <string>
+#include <utility>
+
+namespace server {
+
+namespace {
+
+constexpr auto TICK = std::chrono::milliseconds(250);
+
+void append_event(std::string& body, const char* type, uint64_t version, const std::string& data) {
+    body += "event: ";
+    body += type;
+    body += "\nid: " + std::to_string(version) + "\ndata: " + data + "\n\n";
+}
+
+std::string product_data(const Product& p) {
+    serializer::JsonWriter w;
+    w.begin_object(3);
+    w.key("id");
+    w.integer(p.id);
+    w.key("price");
+    w.money(p.price);
+    w.key("stock");
+    w.integer(p.stock);
+    w.end_object();
+    return w.take();
+}
+
+std::string removed_data(int id) {
+    return "{\"id\":" + std::to_string(id) + "}";
+}
+
+crow::response stream_response(std::string body, bool closing) {
+    crow::response res(200, std::move(body));
+    res.set_header("Content-Type", "text/event-stream");
+    res.set_header("Cache-Control", "no-cache");
+    if (closing) res.set_header("Connection", "close");
+    return res;
+}
+
+std::string heartbeat_body() {
+    return "retry: " + std::to_string(ProductStream::RETRY_MS) + "\n: keepalive\n\n";
+}
+
+} // namespace
+
+ProductStream& ProductStream::instance() {
+    static ProductStream stream;
+    return stream;
+}
+
+ProductStream::~ProductStream() {
+    // Parked responses belong to Crow connections that are gone by now; main calls stop() before that.
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        stopping_ = true;
+        cv_.notify_all();
+    }
+    if (thread_.joinable()) thread_.join();
+}
+
+void ProductStream::configure(size_t max_waiting, int hold_ms) {
+    std::lock_guard<std::mutex> lock(mu_);
+    max_waiting_ = max_waiting;
+    hold_ms_ = hold_ms;
+}
+
+void ProductStream::start() {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (thread_.joinable()) return;
+        stopping_ = false;
+        thread_ = std::thread([this] { run(); });
+    }
+    ProductStore::instance().set_listener([this](uint64_t version, const std::vector<int>& changed,
+                                                 const std::vector<int>& removed) {
+        publish(version, changed, removed);
+    });
+}
+
+void ProductStream::stop() {
+    ProductStore::instance().set_listener(nullptr);
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        stopping_ = true;
+        cv_.notify_all();
+    }
+    if (thread_.joinable()) thread_.join();
+    end_waiting(true);
+}
+
+void ProductStream::subscribe(crow::response& res, std::vector<int> ids, uint64_t since) {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        requests_++;
+    }
+    serve(Reader{&res, std::move(ids), since, {}});
+}
+
+void ProductStream::serve(Reader reader) {
+    for (;;) {
+        if (try_answer(reader)) return;
+        std::unique_lock<std::mutex> lock(mu_);
+        // A version published since try_answer() looked would otherwise never wake this reader.
+        if (version_ > reader.since) continue;
+        if (stopping_ || Lifecycle::instance().draining()) {
+            lock.unlock();
+            return respond(*reader.res, stream_response(heartbeat_body(), true));
+        }
+        if (waiting_.size() >= max_waiting_) {
+            rejected_++;
+            lock.unlock();
+            crow::response busy(503, response_helper::error_json("Too many open streams, retry later"));
+            busy.set_header("Retry-After", "5");
+            return respond(*reader.res, std::move(busy));
+        }
+        reader.deadline = Clock::now() + std::chrono::milliseconds(hold_ms_);
+        park_locked(next_token_++, std::move(reader));
+        return;
+    }
+}
+
+bool ProductStream::try_answer(Reader& reader) {
+    auto changes = ProductStore::instance().changes_since(reader.since);
+    if (!changes.columns) {
+        respond(*reader.res, crow::response(503, response_helper::error_json("Catalog not loaded")));
+        return true;
+    }
+
+    // ids are sorted (the route dedupes them); a batch holds one event per product.
+    auto wanted = [&reader](int id) { return std::binary_search(reader.ids.begin(), reader.ids.end(), id); };
+    std::string body = "retry: " + std::to_string(RETRY_MS) + "\n\n";
+    size_t events = 0;
+    if (changes.full_resync) {
+        for (int id : reader.ids) {
+            auto row = changes.columns->row_of(id);
+            if (row) append_event(body, "product", changes.version, product_data(changes.columns->product(*row)));
+            else append_event(body, "removed", changes.version, removed_data(id));
+            events++;
+        }
+    } else {
+        for (uint32_t row : changes.changed) {
+            const Product& p = changes.columns->product(row);
+            if (!wanted(p.id)) continue;
+            append_event(body, "product", changes.version, product_data(p));
+            events++;
+        }
+        for (int id : changes.removed) {
+            if (!wanted(id)) continue;
+            append_event(body, "removed", changes.version, removed_data(id));
+            events++;
+        }
+    }
+    if (events == 0) {
+        reader.since = changes.version;
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        batches_++;
+        events_ += events;
+        if (changes.full_resync) resyncs_++;
+        else if (changes.version > reader.since + 1) coalesced_versions_ += changes.version - reader.since - 1;
+    }
+    respond(*reader.res, stream_response(std::move(body), false));
+    return true;
+}
+
+void ProductStream::park_locked(uint64_t token, Reader reader) {
+    for (int id : reader.ids) by_product_[id].insert(token);
+    waiting_.emplace(token, std::move(reader));
+}
+
+ProductStream::Reader ProductStream::unpark_locked(std::map<uint64_t, Reader>::iterator it) {
+    Reader reader = std::move(it->second);
+    for (int id : reader.ids) {
+        auto p = by_product_.find(id);
+        if (p == by_product_.end()) continue;
+        p->second.erase(it->first);
+        if (p->second.empty()) by_product_.erase(p);
+    }
+    waiting_.erase(it);
+    return reader;
+}
+
+void ProductStream::publish(uint64_t version, const std::vector<int>& changed, const std::vector<int>& removed) {
+    std::vector<Reader> ready;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        version_ = std::max(version_, version);  // concurrent stock patches can publish out of order
+        publishes_++;
+        for (const auto* ids : {&changed, &removed}) {
+            for (int id : *ids) {
+                auto p = by_product_.find(id);
+                if (p == by_product_.end()) continue;
+                std::vector<uint64_t> tokens(p->second.begin(), p->second.end());
+                for (uint64_t token : tokens) {
+                    auto it = waiting_.find(token);
+                    if (it != waiting_.end() && it->second.since < version) ready.push_back(unpark_locked(it));
+                }
+            }
+        }
+    }
+    for (Reader& reader : ready) serve(std::move(reader));
+}
+
+void ProductStream::end_waiting(bool closing) {
+    std::vector<Reader> done;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        auto now = Clock::now();
+        // Tokens are handed out in arrival order, so deadlines are (nearly) in token order too.
+        while (!waiting_.empty() && (closing || waiting_.begin()->second.deadline <= now)) {
+            done.push_back(unpark_locked(waiting_.begin()));
+        }
+        heartbeats_ += done.size();
+    }
+    for (Reader& reader : done) respond(*reader.res, stream_response(heartbeat_body(), closing));
+}
+
+void ProductStream::run() {
+    std::unique_lock<std::mutex> lock(mu_);
+    while (!stopping_) {
+        cv_.wait_for(lock, TICK);
+        if (stopping_) break;
+        lock.unlock();
+        end_waiting(Lifecycle::instance().draining());
+        lock.lock();
+    }
+}
+
+ProductStreamMetrics ProductStream::metrics() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    ProductStreamMetrics m;
+    m.waiting = waiting_.size();
+    m.max_waiting = max_waiting_;
+    m.requests = requests_;
+    m.rejected = rejected_;
+    m.batches = batches_;
+    m.events = events_;
+    m.heartbeats = heartbeats_;
+    m.resyncs = resyncs_;
+    m.coalesced_versions = coalesced_versions_;
+    m.publishes = publishes_;
+    return m;
+}
+
+} // namespace server
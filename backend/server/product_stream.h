@@ -0,0 +1,117 @@
+#pragma once
+
+#include "crow.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace server {
+
+struct ProductStreamMetrics {
+    size_t waiting = 0;            // parked requests now
+    size_t max_waiting = 0;
+    uint64_t requests = 0;
+    uint64_t rejected = 0;         // 503: max_waiting reached
+    uint64_t batches = 0;          // responses that carried events
+    uint64_t events = 0;
+    uint64_t heartbeats = 0;       // responses ended by the hold time, no events
+    uint64_t resyncs = 0;          // full state sent: no Last-Event-ID, or behind the change log
+    uint64_t coalesced_versions = 0;  // catalog versions a reader skipped; it got only the latest state
+    uint64_t publishes = 0;
+};
+
+/**
+ * Live stock and price updates for product pages, as Server-Sent Events
+ * (/api/stream/products?ids=1,2,3), instead of every open tab polling
+ * /api/products/<id>.
+ *
+ * Crow cannot flush part of a response, so each response carries one batch
+ * of events and ends; EventSource reconnects on its own and sends the last
+ * `id:` it saw, which is the catalog version (ProductStore::version()). A
+ * request with no id, or one behind the change log, gets the current state
+ * of all its products. A request that is up to date is parked: its
+ * crow::response is registered under each of its product ids, with no thread
+ * or executor worker behind it, so tens of thousands of idle readers cost a
+ * registry entry each. ProductStore calls publish() after every catalog
+ * version; the parked readers of the products in it are answered with one
+ * event per product carrying its current price and stock. A reader that is
+ * slow to come back (or still receiving the last batch) misses nothing but
+ * the intermediate values: it resumes with the latest state only. Readers
+ * with no event within hold_ms get an empty response (a comment) and
+ * reconnect, which keeps proxies from timing them out.
+ *
+ * When the server starts draining, every parked reader is answered with
+ * Connection: close, so the reconnect goes to another instance.
+ */
+class ProductStream {
+public:
+    static constexpr size_t MAX_IDS = 100;
+    static constexpr int RETRY_MS = 250;  // EventSource reconnect delay
+
+    static ProductStream& instance();
+
+    /// Hold limit and parked-reader cap (config reload).
+    void configure(size_t max_waiting, int hold_ms);
+    /// Start the hold-time thread and subscribe to catalog changes.
+    void start();
+    /// Answer every parked reader and stop the thread.
+    void stop();
+
+    /// Answer `res` with the changes to `ids` after `since` (0 = none seen), or park it until there are some.
+    void subscribe(crow::response& res, std::vector<int> ids, uint64_t since);
+    /// A new catalog version changed or removed these products.
+    void publish(uint64_t version, const std::vector<int>& changed, const std::vector<int>& removed);
+
+    ProductStreamMetrics metrics() const;
+
+private:
+    ProductStream() = default;
+    ~ProductStream();
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Reader {
+        crow::response* res;
+        std::vector<int> ids;
+        uint64_t since;
+        Clock::time_point deadline;
+    };
+
+    /// Answer `reader` now, or park it until a version touches its products.
+    void serve(Reader reader);
+    /// Events for `reader` after its version; false if there are none (it should wait).
+    bool try_answer(Reader& reader);
+    void park_locked(uint64_t token, Reader reader);
+    Reader unpark_locked(std::map<uint64_t, Reader>::iterator it);
+    void end_waiting(bool closing);
+    void run();
+
+    mutable std::mutex mu_;
+    std::condition_variable cv_;
+    std::map<uint64_t, Reader> waiting_;  // by token: arrival order
+    std::unordered_map<int, std::unordered_set<uint64_t>> by_product_;
+    uint64_t next_token_ = 0;
+    uint64_t version_ = 0;  // last version published
+    size_t max_waiting_ = 50000;
+    int hold_ms_ = 25000;
+    bool stopping_ = false;
+    std::thread thread_;
+
+    uint64_t requests_ = 0;
+    uint64_t rejected_ = 0;
+    uint64_t batches_ = 0;
+    uint64_t events_ = 0;
+    uint64_t heartbeats_ = 0;
+    uint64_t resyncs_ = 0;
+    uint64_t coalesced_versions_ = 0;
+    uint64_t publishes_ = 0;
+};
+
+} // namespace server
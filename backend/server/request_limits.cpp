@@ -0,0 +1,46 @@
+#include "server/request_limits.h"
+#include "utils/response_helper.h"
+
+namespace server {
+
+// Defaults match HttpConfig; main.cpp applies the configured values at startup.
+std::atomic<size_t> RequestLimits::max_body_bytes_{1024 * 1024};
+std::atomic<size_t> RequestLimits::max_headers_{64};
+std::atomic<uint64_t> RequestLimits::rejected_body_{0};
+std::atomic<uint64_t> RequestLimits::rejected_headers_{0};
+
+void RequestLimits::set_limits(size_t max_body_bytes, size_t max_headers) {
+    max_body_bytes_ = max_body_bytes;
+    max_headers_ = max_headers;
+}
+
+RequestLimitsMetrics RequestLimits::metrics() {
+    RequestLimitsMetrics m;
+    m.max_body_bytes = max_body_bytes_.load();
+    m.max_headers = max_headers_.load();
+    m.rejected_body = rejected_body_.load();
+    m.rejected_headers = rejected_headers_.load();
+    return m;
+}
+
+void RequestLimits::before_handle(crow::request& req, crow::response& res, context&) {
+    int code = 0;
+    const char* message = nullptr;
+    if (req.body.size() > max_body_bytes_.load(std::memory_order_relaxed)) {
+        rejected_body_++;
+        code = 413;
+        message = "Request body too large";
+    } else if (req.headers.size() > max_headers_.load(std::memory_order_relaxed)) {
+        rejected_headers_++;
+        code = 431;
+        message = "Too many request headers";
+    } else {
+        return;
+    }
+    res.code = code;
+    res.body = response_helper::error_json(message);
+    res.add_header("Connection", "close");
+    res.end();
+}
+
+} // namespace server
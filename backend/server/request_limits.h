@@ -0,0 +1,45 @@
+#pragma once
+
+#include "crow.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace server {
+
+struct RequestLimitsMetrics {
+    size_t max_body_bytes = 0;
+    size_t max_headers = 0;
+    uint64_t rejected_body = 0;     // 413s
+    uint64_t rejected_headers = 0;  // 431s
+};
+
+/**
+ * Crow middleware in front of AdmissionControl: a request with a body larger
+ * than max_body_bytes gets 413, one with more than max_headers headers gets
+ * 431, before it is admitted, parsed or queued for the DB. Crow reads the
+ * whole request before middleware runs, so header bytes are bounded by its
+ * parser and the proxy should cap bodies as well; this keeps oversized
+ * requests away from the handlers and the JSON parser.
+ *
+ * Limits are process-wide (shared by every App instance) and can change at
+ * runtime (config reload).
+ */
+class RequestLimits {
+public:
+    struct context {};
+
+    static void set_limits(size_t max_body_bytes, size_t max_headers);
+    static RequestLimitsMetrics metrics();
+
+    void before_handle(crow::request& req, crow::response& res, context& ctx);
+    void after_handle(crow::request&, crow::response&, context&) {}
+
+private:
+    static std::atomic<size_t> max_body_bytes_;
+    static std::atomic<size_t> max_headers_;
+    static std::atomic<uint64_t> rejected_body_;
+    static std::atomic<uint64_t> rejected_headers_;
+};
+
+} // namespace server
@@ -0,0 +1,80 @@
+#include "server/response_compression.h"
+#include <chrono>
+
+namespace server {
+
+namespace {
+
+bool compressible(const std::string& content_type) {
+    if (content_type.empty()) return true;  // our JSON routes do not set one
+    return content_type.rfind("text/", 0) == 0 || content_type.find("json") != std::string::npos ||
+        content_type.find("javascript") != std::string::npos || content_type.find("xml") != std::string::npos ||
+        content_type.find("msgpack") != std::string::npos || content_type.find("cbor") != std::string::npos;
+}
+
+} // namespace
+
+std::atomic<bool> ResponseCompression::enabled_{true};
+std::atomic<size_t> ResponseCompression::min_bytes_{1024};
+std::atomic<int> ResponseCompression::level_{6};
+std::atomic<uint64_t> ResponseCompression::responses_{0};
+std::atomic<uint64_t> ResponseCompression::bytes_in_{0};
+std::atomic<uint64_t> ResponseCompression::bytes_out_{0};
+std::atomic<uint64_t> ResponseCompression::compress_ns_{0};
+std::atomic<uint64_t> ResponseCompression::compressed_bytes_in_{0};
+
+CompressedCache& ResponseCompression::cache() {
+    static CompressedCache cache(CompressionOptions{}.cache_bytes);
+    return cache;
+}
+
+void ResponseCompression::set_options(const CompressionOptions& options) {
+    enabled_ = options.enabled;
+    min_bytes_ = options.min_bytes;
+    // Cached variants are keyed by body, not level: drop them when the level changes.
+    if (level_.exchange(options.level) != options.level) cache().set_max_bytes(0);
+    cache().set_max_bytes(options.cache_bytes);
+}
+
+CompressionMetrics ResponseCompression::metrics() {
+    CompressionMetrics m;
+    auto stats = cache().stats();
+    m.responses = responses_.load();
+    m.cache_hits = stats.hits;
+    m.bytes_in = bytes_in_.load();
+    m.bytes_out = bytes_out_.load();
+    m.compress_ms = static_cast<double>(compress_ns_.load()) / 1e6;
+    m.compressed_bytes_in = compressed_bytes_in_.load();
+    m.cache_bytes = stats.bytes;
+    return m;
+}
+
+void ResponseCompression::after_handle(crow::request& req, crow::response& res, context&) {
+    if (!enabled_.load(std::memory_order_relaxed) || res.body.size() < min_bytes_.load(std::memory_order_relaxed))
+        return;
+    if (!res.get_header_value("Content-Encoding").empty() || !res.get_header_value("ETag").empty()) return;
+    if (!compressible(res.get_header_value("Content-Type"))) return;
+
+    std::string vary = res.get_header_value("Vary");  // e.g. Accept, from format negotiation
+    res.set_header("Vary", vary.empty() ? "Accept-Encoding" : vary + ", Accept-Encoding");
+    Encoding e = negotiate_encoding(req.get_header_value("Accept-Encoding"));
+    if (e == Encoding::Identity) return;
+
+    bool hit = false;
+    auto t0 = std::chrono::steady_clock::now();
+    auto compressed = cache().get(res.body, e, level_.load(std::memory_order_relaxed), &hit);
+    if (!hit) {
+        compress_ns_ += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - t0).count());
+        compressed_bytes_in_ += res.body.size();
+    }
+    if (compressed->size() >= res.body.size()) return;  // incompressible: send as is
+
+    responses_++;
+    bytes_in_ += res.body.size();
+    bytes_out_ += compressed->size();
+    res.body = *compressed;
+    res.set_header("Content-Encoding", encoding_name(e));
+}
+
+} // namespace server
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "crow.h"
+#include "server/compression.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace server {
+
+struct CompressionOptions {
+    bool enabled = true;
+    size_t min_bytes = 1024;              // smaller bodies are sent as they are
+    int level = 6;                        // zlib level, 1 (fast) - 9 (small)
+    size_t cache_bytes = 32 * 1024 * 1024;  // CompressedCache budget; 0 = compress every time
+};
+
+struct CompressionMetrics {
+    uint64_t responses = 0;    // bodies sent compressed
+    uint64_t cache_hits = 0;   // ... of which came from the cache
+    uint64_t bytes_in = 0;     // uncompressed bytes of those bodies
+    uint64_t bytes_out = 0;    // bytes actually sent for them
+    double compress_ms = 0;    // time spent deflating (cache misses)
+    uint64_t compressed_bytes_in = 0;  // input bytes behind compress_ms
+    size_t cache_bytes = 0;
+};
+
+/**
+ * Crow middleware, last in the chain: compresses response bodies of at least
+ * min_bytes with gzip or deflate, as negotiated from Accept-Encoding, and adds
+ * Vary: Accept-Encoding to every body it could have compressed. JSON, text,
+ * JavaScript, SVG, MessagePack, CBOR and bodies without a Content-Type are
+ * compressed (the binary formats still repeat every key per row). Bodies
+ * that already have a Content-Encoding or an ETag are left alone: the static
+ * files carry their own precompressed variants (server/static_files.h).
+ *
+ * Compressed bytes come from a process-wide CompressedCache keyed by the
+ * body, so a hot catalog response is compressed once and then only hashed.
+ * For async routes after_handle runs on the DB executor thread that
+ * completes the response, so the deflate cost stays off the HTTP threads.
+ */
+class ResponseCompression {
+public:
+    struct context {};
+
+    static void set_options(const CompressionOptions& options);
+    static CompressionMetrics metrics();
+
+    void before_handle(crow::request&, crow::response&, context&) {}
+    void after_handle(crow::request& req, crow::response& res, context& ctx);
+
+private:
+    static CompressedCache& cache();
+
+    static std::atomic<bool> enabled_;
+    static std::atomic<size_t> min_bytes_;
+    static std::atomic<int> level_;
+    static std::atomic<uint64_t> responses_;
+    static std::atomic<uint64_t> bytes_in_;
+    static std::atomic<uint64_t> bytes_out_;
+    static std::atomic<uint64_t> compress_ns_;
+    static std::atomic<uint64_t> compressed_bytes_in_;
+};
+
+} // namespace server
@@ -0,0 +1,44 @@
+#include "server/response_format.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <sstream>
+
+namespace server {
+
+Format negotiate_format(const std::string& accept) {
+    if (accept.empty()) return Format::Json;
+    Format best = Format::Json;
+    double best_q = 0;
+    std::stringstream ss(accept);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        size_t b = item.find_first_not_of(" \t");
+        if (b == std::string::npos) continue;
+        size_t semi = item.find(';', b);
+        std::string media = item.substr(b, semi == std::string::npos ? std::string::npos : semi - b);
+        while (!media.empty() && (media.back() == ' ' || media.back() == '\t')) media.pop_back();
+        std::transform(media.begin(), media.end(), media.begin(), [](unsigned char c) { return std::tolower(c); });
+
+        Format f;
+        if (media == "application/msgpack" || media == "application/x-msgpack" || media == "application/vnd.msgpack")
+            f = Format::MsgPack;
+        else if (media == "application/cbor")
+            f = Format::Cbor;
+        else if (media == "application/json" || media == "application/*" || media == "*/*")
+            f = Format::Json;
+        else
+            continue;
+
+        double q = 1;
+        size_t qpos = semi == std::string::npos ? std::string::npos : item.find("q=", semi);
+        if (qpos != std::string::npos) q = std::strtod(item.c_str() + qpos + 2, nullptr);
+        if (q > best_q) {  // ties keep the earlier entry
+            best = f;
+            best_q = q;
+        }
+    }
+    return best;
+}
+
+} // namespace server
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "crow.h"
+#include "utils/serializer.h"
+#include <string>
+
+namespace server {
+
+enum class Format { Json, MsgPack, Cbor };
+
+/**
+ * Response format from an Accept header: application/msgpack (also
+ * x-msgpack, vnd.msgpack) or application/cbor when the client prefers it to
+ * JSON (higher q, or listed first at equal q), else JSON. Wildcards only ever select JSON, so
+ * browsers and existing clients are unaffected.
+ */
+Format negotiate_format(const std::string& accept);
+
+inline Format request_format(const crow::request& req) {
+    return negotiate_format(req.get_header_value("Accept"));
+}
+
+namespace detail {
+
+template <typename W, typename WriteData>
+crow::response data_response(int code, WriteData& write_data) {
+    W w;
+    w.begin_object(2);
+    w.key("success");
+    w.boolean(true);
+    w.key("data");
+    write_data(w);
+    w.end_object();
+    crow::response res(code, w.take());
+    if (W::content_type) res.set_header("Content-Type", W::content_type);
+    res.set_header("Vary", "Accept");
+    return res;
+}
+
+} // namespace detail
+
+/**
+ * `{"success":true,"data":...}` in `format`, the data written by
+ * `write_data(writer)` — a generic lambda, instantiated once per format, e.g.
+ * `[&](auto& w) { row_mapping::write_rows<Product>(w, r); }`.
+ * Errors stay JSON (response_helper::error_json) whatever the format.
+ */
+template <typename WriteData>
+crow::response data_response(Format format, int code, WriteData&& write_data) {
+    switch (format) {
+    case Format::MsgPack: return detail::data_response<serializer::MsgPackWriter>(code, write_data);
+    case Format::Cbor: return detail::data_response<serializer::CborWriter>(code, write_data);
+    default: return detail::data_response<serializer::JsonWriter>(code, write_data);
+    }
+}
+
+} // namespace server
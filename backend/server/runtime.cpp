@@ -0,0 +1,126 @@
+#include "server/runtime.h"
+#include <atomic>
+#include <thread>
+
+#ifdef __linux__
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace server {
+
+namespace {
+
+std::atomic<int> g_listen_port{-1};
+std::atomic<bool> g_reuseport{false};
+std::atomic<bool> g_tcp_nodelay{false};
+std::atomic<int> g_backlog{0};
+// Set by arm_listener(); cleared once the acceptor is listening.
+thread_local bool t_armed = false;
+thread_local int t_bound_fd = -1;
+
+#ifdef __linux__
+int port_of(const struct sockaddr* addr, socklen_t len) {
+    if (addr->sa_family == AF_INET && len >= sizeof(sockaddr_in))
+        return ntohs(reinterpret_cast<const sockaddr_in*>(addr)->sin_port);
+    if (addr->sa_family == AF_INET6 && len >= sizeof(sockaddr_in6))
+        return ntohs(reinterpret_cast<const sockaddr_in6*>(addr)->sin6_port);
+    return -1;
+}
+#endif
+
+} // namespace
+
+size_t cpu_count() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+bool pin_current_thread(size_t first, size_t count) {
+#ifdef __linux__
+    size_t n = cpu_count();
+    if (count == 0 || count >= n) return true;  // whole machine: nothing to restrict
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (size_t i = 0; i < count; i++) CPU_SET(static_cast<int>((first + i) % n), &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)first;
+    (void)count;
+    return false;
+#endif
+}
+
+#if defined(__linux__) && defined(SYS_bind) && defined(SYS_listen)
+bool configure_listener(uint16_t port, const ListenOptions& options) {
+    g_reuseport = options.reuseport;
+    g_tcp_nodelay = options.tcp_nodelay;
+    g_backlog = options.backlog;
+    g_listen_port = port;
+    return true;
+}
+
+void arm_listener() {
+    t_armed = true;
+    t_bound_fd = -1;
+}
+#else
+bool configure_listener(uint16_t, const ListenOptions&) {
+    return false;
+}
+
+void arm_listener() {}
+#endif
+
+size_t raise_fd_limit() {
+#ifdef __linux__
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) != 0) return 0;
+    if (rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+        getrlimit(RLIMIT_NOFILE, &rl);
+    }
+    return static_cast<size_t>(rl.rlim_cur);
+#else
+    return 0;
+#endif
+}
+
+} // namespace server
+
+#if defined(__linux__) && defined(SYS_bind) && defined(SYS_listen)
+// Replace libc's bind() and listen() for the whole binary (Crow is header-only,
+// so its acceptor calls land here). Options are applied only on a thread
+// between arm_listener() and its acceptor's listen(), and only to the socket
+// bound to the configure_listener() port; every other call goes straight to
+// the syscall.
+extern "C" int bind(int fd, const struct sockaddr* addr, socklen_t len) noexcept {
+    if (server::t_armed && addr) {
+        int want = server::g_listen_port.load(std::memory_order_relaxed);
+        if (want >= 0 && server::port_of(addr, len) == want) {
+            int one = 1;
+            if (server::g_reuseport) setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+            if (server::g_tcp_nodelay) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            server::t_bound_fd = fd;
+        }
+    }
+    return static_cast<int>(syscall(SYS_bind, fd, addr, len));
+}
+
+extern "C" int listen(int fd, int backlog) noexcept {
+    if (server::t_armed && fd == server::t_bound_fd) {
+        int configured = server::g_backlog.load(std::memory_order_relaxed);
+        if (configured > 0) backlog = configured;
+        server::t_armed = false;
+        server::t_bound_fd = -1;
+    }
+    return static_cast<int>(syscall(SYS_listen, fd, backlog));
+}
+#endif
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace server {
+
+/// How the HTTP side is run. Filled from db_config.json (http_port, http_workers,
+/// http_instances, pin_threads), then overridden by --port/--workers/--instances/--pin-threads.
+struct ServeOptions {
+    int port = 8080;
+    int workers = 0;        // Crow worker threads across all instances; 0 = one per CPU
+    int instances = 1;      // >1: independent Crow apps on one port via SO_REUSEPORT
+    bool pin_threads = false;
+};
+
+size_t cpu_count();
+
+/// Restrict the calling thread to CPUs [first, first + count) (mod cpu_count()).
+/// Threads it spawns afterwards inherit the mask. Returns false where unsupported.
+bool pin_current_thread(size_t first, size_t count);
+
+/// Socket options for the HTTP listener(s).
+struct ListenOptions {
+    bool reuseport = false;   // several Crow apps on one port, balanced by the kernel
+    bool tcp_nodelay = true;  // set on the listener; accepted connections inherit it
+    int backlog = 0;          // listen() backlog; 0 = Crow's default (SOMAXCONN)
+};
+
+/**
+ * Options for the HTTP listener on `port`. Crow opens, binds and listens on
+ * its acceptor internally, so they are applied by interposing bind() and
+ * listen() (Linux only; returns false elsewhere), and only on threads that
+ * called arm_listener().
+ */
+bool configure_listener(uint16_t port, const ListenOptions& options);
+
+/**
+ * Call on the thread that is about to run a Crow app: its next bind() to the
+ * configured port and the listen() on that socket get the options. Any other
+ * socket in the process, and this thread's sockets afterwards, are left alone.
+ */
+void arm_listener();
+
+/// Raise the open-file soft limit to the hard limit (one fd per connection).
+/// Returns the resulting limit, or 0 where unsupported.
+size_t raise_fd_limit();
+
+} // namespace server
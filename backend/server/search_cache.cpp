@@ -0,0 +1,114 @@
+#include "server/search_cache.h"
+#include <functional>
+#include <iterator>
+
+namespace server {
+
+namespace {
+
+// List node, index node and the Entry itself, roughly.
+constexpr size_t ENTRY_OVERHEAD = 192;
+
+} // namespace
+
+SearchCache& SearchCache::instance() {
+    static SearchCache cache;
+    return cache;
+}
+
+void SearchCache::configure(size_t max_bytes, int ttl_ms) {
+    {
+        std::lock_guard<std::mutex> lock(config_mu_);
+        max_bytes_ = max_bytes;
+        ttl_ms_ = ttl_ms;
+    }
+    for (auto& s : shards_) {
+        std::lock_guard<std::mutex> lock(s.mu);
+        evict_locked(s, max_bytes / SHARDS);
+    }
+}
+
+bool SearchCache::enabled() const {
+    std::lock_guard<std::mutex> lock(config_mu_);
+    return max_bytes_ > 0;
+}
+
+SearchCache::Shard& SearchCache::shard(const std::string& key) {
+    return shards_[std::hash<std::string>()(key) % SHARDS];
+}
+
+std::shared_ptr<const CachedResponse> SearchCache::get(const std::string& key, uint64_t version) {
+    Shard& s = shard(key);
+    std::lock_guard<std::mutex> lock(s.mu);
+    auto it = s.index.find(key);
+    if (it == s.index.end()) {
+        s.misses++;
+        return nullptr;
+    }
+    Lru::iterator e = it->second;
+    if (e->version != version || Clock::now() >= e->expires) {
+        erase_locked(s, e);
+        s.stale++;
+        s.misses++;
+        return nullptr;
+    }
+    s.lru.splice(s.lru.begin(), s.lru, e);
+    s.hits++;
+    return e->value;
+}
+
+void SearchCache::put(const std::string& key, uint64_t version, std::shared_ptr<const CachedResponse> value) {
+    size_t max_bytes;
+    int ttl_ms;
+    {
+        std::lock_guard<std::mutex> lock(config_mu_);
+        max_bytes = max_bytes_;
+        ttl_ms = ttl_ms_;
+    }
+    size_t budget = max_bytes / SHARDS;
+    size_t bytes = 2 * key.size() + value->body.size() + value->content_type.size() + ENTRY_OVERHEAD;
+    if (bytes > budget) return;  // also when the cache is off
+
+    Shard& s = shard(key);
+    std::lock_guard<std::mutex> lock(s.mu);
+    auto it = s.index.find(key);
+    if (it != s.index.end()) erase_locked(s, it->second);
+    s.lru.push_front({key, version, Clock::now() + std::chrono::milliseconds(ttl_ms), std::move(value), bytes});
+    s.index.emplace(key, s.lru.begin());
+    s.bytes += bytes;
+    evict_locked(s, budget);
+}
+
+void SearchCache::erase_locked(Shard& s, Lru::iterator it) {
+    s.bytes -= it->bytes;
+    s.index.erase(it->key);
+    s.lru.erase(it);
+}
+
+void SearchCache::evict_locked(Shard& s, size_t budget) {
+    while (s.bytes > budget && !s.lru.empty()) {
+        erase_locked(s, std::prev(s.lru.end()));
+        s.evictions++;
+    }
+}
+
+SearchCacheMetrics SearchCache::metrics() const {
+    SearchCacheMetrics m;
+    {
+        std::lock_guard<std::mutex> lock(config_mu_);
+        m.max_bytes = max_bytes_;
+        m.ttl_ms = ttl_ms_;
+    }
+    for (auto& s : shards_) {
+        std::lock_guard<std::mutex> lock(s.mu);
+        m.hits += s.hits;
+        m.misses += s.misses;
+        m.stale += s.stale;
+        m.evictions += s.evictions;
+        m.entries += s.lru.size();
+        m.bytes += s.bytes;
+    }
+    return m;
+}
+
+} // namespace server
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace server {
+
+/// A finished response body as the search route produced it.
+struct CachedResponse {
+    std::string body;
+    std::string content_type;
+};
+
+struct SearchCacheMetrics {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t stale = 0;      // expired or from an older catalog version (counted in misses too)
+    uint64_t evictions = 0;  // dropped to stay under max_bytes
+    size_t entries = 0;
+    size_t bytes = 0;
+    size_t max_bytes = 0;
+    int ttl_ms = 0;
+};
+
+/**
+ * Bounded cache of /api/products/search responses, keyed by the normalized
+ * term (server/search_term.h) and the response format. A few terms make up
+ * most searches, so these skip the ILIKE scan entirely.
+ *
+ * SHARDS independent LRU lists, each with its own mutex and a byte budget
+ * of max_bytes / SHARDS (keys, bodies and a fixed per-entry overhead are
+ * counted). An entry is served while it is younger than ttl_ms and was
+ * built from the current catalog version (ProductStore::version()); older
+ * ones are dropped when looked up, or evicted as least recently used.
+ * configure() applies new limits at runtime (config reload).
+ */
+class SearchCache {
+public:
+    static constexpr size_t SHARDS = 16;
+
+    static SearchCache& instance();
+
+    /// Total byte budget (0 = off) and entry lifetime. Shrinking evicts now.
+    void configure(size_t max_bytes, int ttl_ms);
+    bool enabled() const;
+
+    /// The entry for `key` if it is fresh and was built at catalog `version`.
+    std::shared_ptr<const CachedResponse> get(const std::string& key, uint64_t version);
+    /// Store a response built from catalog `version` (taken before the query ran).
+    void put(const std::string& key, uint64_t version, std::shared_ptr<const CachedResponse> value);
+
+    SearchCacheMetrics metrics() const;
+
+private:
+    SearchCache() = default;
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        std::string key;
+        uint64_t version;
+        Clock::time_point expires;
+        std::shared_ptr<const CachedResponse> value;
+        size_t bytes;
+    };
+    using Lru = std::list<Entry>;
+
+    struct Shard {
+        mutable std::mutex mu;
+        Lru lru;  // front = most recently used
+        std::unordered_map<std::string, Lru::iterator> index;
+        size_t bytes = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t stale = 0;
+        uint64_t evictions = 0;
+    };
+
+    Shard& shard(const std::string& key);
+    static void erase_locked(Shard& s, Lru::iterator it);
+    void evict_locked(Shard& s, size_t budget);
+
+    std::array<Shard, SHARDS> shards_;
+    mutable std::mutex config_mu_;
+    size_t max_bytes_ = 0;
+    int ttl_ms_ = 0;
+};
+
+} // namespace server
@@ -0,0 +1,37 @@
+#include "server/search_term.h"
+
+namespace server {
+
+namespace {
+
+bool blank(char c) {
+    return c == ' ' || c == '\t';
+}
+
+bool utf8_continuation(char c) {
+    return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+} // namespace
+
+std::string normalize_search_term(std::string_view raw) {
+    std::string term;
+    term.reserve(raw.size() < MAX_SEARCH_TERM_BYTES ? raw.size() : MAX_SEARCH_TERM_BYTES);
+    for (char c : raw) {
+        auto u = static_cast<unsigned char>(c);
+        if ((u < 32 && c != '\t') || u == 127) continue;
+        if (term.empty() && blank(c)) continue;
+        term += c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+        if (term.size() > MAX_SEARCH_TERM_BYTES) break;
+    }
+    if (term.size() > MAX_SEARCH_TERM_BYTES) {
+        // Cut before the sequence that crosses the limit.
+        size_t cut = MAX_SEARCH_TERM_BYTES;
+        while (cut > 0 && utf8_continuation(term[cut])) cut--;
+        term.resize(cut);
+    }
+    while (!term.empty() && blank(term.back())) term.pop_back();
+    return term;
+}
+
+} // namespace server
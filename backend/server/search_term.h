@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace server {
+
+constexpr size_t MAX_SEARCH_TERM_BYTES = 500;
+
+/**
+ * The form a /api/products/search term is queried and cached under:
+ * control characters other than tab removed, leading and trailing spaces
+ * and tabs trimmed, ASCII letters lower-cased, and the result cut to
+ * MAX_SEARCH_TERM_BYTES without splitting a UTF-8 sequence. Non-ASCII
+ * bytes are kept as they are: the query is ILIKE, so folding ASCII never
+ * changes the matches, and Postgres folds the rest by its own locale.
+ * Idempotent (fuzz_targets/fuzz_search_term.cpp checks it).
+ */
+std::string normalize_search_term(std::string_view raw);
+
+} // namespace server
@@ -0,0 +1,54 @@
+#include "server/single_flight.h"
+
+namespace server {
+
+SingleFlight& SingleFlight::instance() {
+    static SingleFlight flight;
+    return flight;
+}
+
+bool SingleFlight::join(const std::string& key, crow::response& res) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = inflight_.find(key);
+    if (it == inflight_.end()) {
+        inflight_.emplace(key, std::vector<crow::response*>());
+        leaders_++;
+        return false;
+    }
+    it->second.push_back(&res);
+    coalesced_++;
+    auto counted = by_key_.find(key);
+    if (counted != by_key_.end()) counted->second++;
+    else if (by_key_.size() < MAX_TRACKED_KEYS) by_key_.emplace(key, 1);
+    else by_key_["other"]++;
+    return true;
+}
+
+void SingleFlight::finish(const std::string& key, const crow::response& result) {
+    std::vector<crow::response*> waiters;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        auto it = inflight_.find(key);
+        if (it == inflight_.end()) return;
+        waiters = std::move(it->second);
+        inflight_.erase(it);
+    }
+    // crow::response is move-only: each parked request gets its own copy.
+    for (crow::response* res : waiters) {
+        crow::response copy(result.code, result.body);
+        copy.headers = result.headers;
+        respond(*res, std::move(copy));
+    }
+}
+
+SingleFlightMetrics SingleFlight::metrics() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    SingleFlightMetrics m;
+    m.leaders = leaders_;
+    m.coalesced = coalesced_;
+    m.inflight = inflight_.size();
+    m.coalesced_by_key = by_key_;
+    return m;
+}
+
+} // namespace server
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "crow.h"
+#include "server/db_task.h"
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace server {
+
+struct SingleFlightMetrics {
+    uint64_t leaders = 0;    // executions started
+    uint64_t coalesced = 0;  // requests answered by another request's execution
+    size_t inflight = 0;     // keys executing now
+    std::map<std::string, uint64_t> coalesced_by_key;  // the first MAX_TRACKED_KEYS keys, rest under "other"
+};
+
+/**
+ * Request coalescing for identical catalog reads. The first request for a
+ * key (normalized statement + parameters + response format) runs its work
+ * on the DB executor; requests with the same key that arrive while it runs
+ * do not queue their own task. They are parked and completed with a copy of
+ * the leader's response (status, body, headers) when it finishes, so N
+ * concurrent identical requests cost one query and one serialization.
+ *
+ * Parked requests take no executor worker. They share the leader's result,
+ * including an error or a 504 from the leader's deadline.
+ */
+class SingleFlight {
+public:
+    static constexpr size_t MAX_TRACKED_KEYS = 256;
+
+    static SingleFlight& instance();
+
+    /// Like run_db(res, priority, work), but coalesced with in-flight calls for `key`.
+    template <typename Work>
+    void run(std::string key, crow::response& res, Priority priority, Work&& work) {
+        if (join(key, res)) return;
+        run_db(res, priority, [this, key = std::move(key), work = std::forward<Work>(work)]() mutable {
+            crow::response result;
+            try {
+                result = work();
+            } catch (std::exception& e) {
+                result = crow::response(500, response_helper::error_json(std::string("Error: ") + e.what()));
+            }
+            finish(key, result);
+            return result;
+        });
+    }
+
+    SingleFlightMetrics metrics() const;
+
+private:
+    SingleFlight() = default;
+
+    /// Park `res` behind the in-flight call for `key` (true), or register a new leader (false).
+    bool join(const std::string& key, crow::response& res);
+    /// Complete every request parked on `key` with a copy of `result`.
+    void finish(const std::string& key, const crow::response& result);
+
+    mutable std::mutex mu_;
+    std::unordered_map<std::string, std::vector<crow::response*>> inflight_;
+    uint64_t leaders_ = 0;
+    uint64_t coalesced_ = 0;
+    std::map<std::string, uint64_t> by_key_;
+};
+
+} // namespace server
@@ -0,0 +1,109 @@
+#include "server/startup.h"
+#include "server/db_executor.h"
+#include "server/lifecycle.h"
+#include "server/product_store.h"
+#include "db/connection.h"
+#include <pqxx/pqxx>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+
+namespace server {
+
+namespace {
+
+struct Probe {
+    crow::HTTPMethod method;
+    std::string url;
+    std::string body;
+};
+
+bool url_safe(const std::string& s) {
+    return !s.empty() && std::all_of(s.begin(), s.end(), [](unsigned char c) {
+        return std::isalnum(c) || c == '-' || c == '_';
+    });
+}
+
+} // namespace
+
+void timed_phase(const std::string& name, const std::function<void()>& fn) {
+    auto t0 = std::chrono::steady_clock::now();
+    fn();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    Lifecycle::instance().record_phase(name, ms);
+    std::printf("  startup %-12s %8.1f ms\n", name.c_str(), ms);
+    std::fflush(stdout);
+}
+
+std::vector<std::string> warm_catalog() {
+    std::mutex mu;
+    std::vector<std::string> categories;
+    Database::instance().pool().for_each_idle([&](pqxx::connection& conn) {
+        pqxx::work txn(conn);
+        txn.exec_prepared("products_all");
+        auto cats = txn.exec_prepared("categories_all");
+        txn.commit();
+        std::lock_guard<std::mutex> lock(mu);
+        if (!categories.empty()) return;
+        for (const auto& row : cats) categories.push_back(row[1].as<std::string>());
+    });
+    return categories;
+}
+
+bool self_check(App& app, const std::vector<std::string>& categories) {
+    std::string category = "none";
+    for (const auto& c : categories) {
+        if (url_safe(c)) {
+            category = c;
+            break;
+        }
+    }
+    std::vector<Probe> probes = {
+        {crow::HTTPMethod::Get, "/api/products", ""},
+        {crow::HTTPMethod::Get, "/api/products/1", ""},
+        {crow::HTTPMethod::Get, "/api/products/category/" + category, ""},
+        {crow::HTTPMethod::Get, "/api/products/search?q=a", ""},
+        {crow::HTTPMethod::Get, "/api/cart/0", ""},
+        {crow::HTTPMethod::Get, "/api/orders/0", ""},
+        {crow::HTTPMethod::Post, "/api/auth/login", "{\"email\":\"selfcheck@invalid\",\"password\":\"selfcheck\"}"},
+        {crow::HTTPMethod::Post, "/api/auth/register", "{}"},
+        {crow::HTTPMethod::Post, "/api/cart/add", "{}"},
+        {crow::HTTPMethod::Post, "/api/cart/remove", "{}"},
+        {crow::HTTPMethod::Post, "/api/cart/update_quantity", "{}"},
+        {crow::HTTPMethod::Post, "/api/orders/create", "{}"},
+        {crow::HTTPMethod::Get, "/api/metrics", ""},
+    };
+    if (ProductStore::instance().snapshot()) {  // product_store off: these answer 503
+        probes.push_back({crow::HTTPMethod::Get, "/api/products?in_stock=1&sort=price&limit=10", ""});
+        probes.push_back({crow::HTTPMethod::Get, "/api/products/suggest?prefix=a", ""});
+    }
+
+    app.validate();
+    bool ok = true;
+    for (const auto& probe : probes) {
+        crow::request req;
+        req.method = probe.method;
+        req.raw_url = probe.url;
+        req.url = probe.url.substr(0, probe.url.find('?'));
+        req.url_params = crow::query_string(probe.url);
+        req.body = probe.body;
+        crow::response res;
+        app.handle_full(req, res);
+        if (!DbExecutor::instance().wait_idle(std::chrono::seconds(10))) {
+            std::cerr << "  self-check " << probe.url << ": timed out" << std::endl;
+            // The queued task still writes to `res`: let it finish before `res` goes out of scope.
+            DbExecutor::instance().shutdown();
+            return false;
+        }
+        if (res.code >= 500) {
+            std::cerr << "  self-check " << probe.url << ": " << res.code << " " << res.body << std::endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+} // namespace server
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "server/app.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace server {
+
+/// Run `fn`, record its wall time as startup phase `name` (Lifecycle::phases)
+/// and print it. Exceptions propagate; the phase is not recorded then.
+void timed_phase(const std::string& name, const std::function<void()>& fn);
+
+/// Run the catalog queries once on every app connection, in parallel, so each
+/// Postgres backend has its relation/plan caches and the shared buffers hold
+/// the product and category pages. Returns the category names.
+std::vector<std::string> warm_catalog();
+
+/**
+ * Send one synthetic request through each app route with app.handle_full()
+ * (no socket, no middleware) and wait for the async ones to finish on the DB
+ * executor. Write routes get bodies that fail validation, so nothing is
+ * inserted. Returns false if any route answered 5xx, or if one did not
+ * finish within 10 s; the DB executor is shut down first in that case.
+ */
+bool self_check(App& app, const std::vector<std::string>& categories);
+
+} // namespace server
@@ -0,0 +1,268 @@
+#include "server/static_files.h"
+#include "server/compression.h"
+#include <openssl/evp.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <sstream>
+#include <vector>
+
+namespace server {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+const char* content_type_for(const std::string& path) {
+    static const std::map<std::string, const char*> types = {
+        {"html", "text/html; charset=utf-8"},
+        {"js", "text/javascript; charset=utf-8"},
+        {"mjs", "text/javascript; charset=utf-8"},
+        {"css", "text/css; charset=utf-8"},
+        {"json", "application/json"},
+        {"map", "application/json"},
+        {"txt", "text/plain; charset=utf-8"},
+        {"svg", "image/svg+xml"},
+        {"png", "image/png"},
+        {"jpg", "image/jpeg"},
+        {"jpeg", "image/jpeg"},
+        {"gif", "image/gif"},
+        {"webp", "image/webp"},
+        {"avif", "image/avif"},
+        {"ico", "image/x-icon"},
+        {"woff", "font/woff"},
+        {"woff2", "font/woff2"},
+        {"ttf", "font/ttf"},
+        {"wasm", "application/wasm"},
+        {"webmanifest", "application/manifest+json"},
+    };
+    size_t dot = path.find_last_of('.');
+    size_t slash = path.find_last_of('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return "application/octet-stream";
+    std::string ext = path.substr(dot + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+    auto it = types.find(ext);
+    return it == types.end() ? "application/octet-stream" : it->second;
+}
+
+bool text_like(const std::string& content_type) {
+    return content_type.rfind("text/", 0) == 0 || content_type.find("json") != std::string::npos ||
+        content_type.find("svg") != std::string::npos;
+}
+
+bool has_extension(const std::string& path) {
+    size_t dot = path.find_last_of('.');
+    size_t slash = path.find_last_of('/');
+    return dot != std::string::npos && (slash == std::string::npos || dot > slash);
+}
+
+// Vite names bundled assets `assets/<name>-<hash>.<ext>`; the hash changes with the content.
+bool content_hashed(const std::string& rel) {
+    if (rel.rfind("assets/", 0) != 0) return false;
+    std::string name = rel.substr(rel.find_last_of('/') + 1);
+    size_t dot = name.find('.');
+    std::string stem = name.substr(0, dot);
+    size_t sep = stem.find_last_of("-.");
+    if (sep == std::string::npos) return false;
+    std::string hash = stem.substr(sep + 1);
+    return hash.size() >= 8 && std::all_of(hash.begin(), hash.end(), [](unsigned char c) {
+        return std::isalnum(c) || c == '_';
+    });
+}
+
+class Sha256 {
+public:
+    Sha256() : ctx_(EVP_MD_CTX_new()) { EVP_DigestInit_ex(ctx_, EVP_sha256(), nullptr); }
+    ~Sha256() { EVP_MD_CTX_free(ctx_); }
+    Sha256(const Sha256&) = delete;
+    Sha256& operator=(const Sha256&) = delete;
+
+    void update(const char* data, size_t n) { EVP_DigestUpdate(ctx_, data, n); }
+    // Quoted strong ETag from the first 128 bits of the digest.
+    std::string etag() {
+        unsigned char digest[EVP_MAX_MD_SIZE];
+        unsigned int len = 0;
+        EVP_DigestFinal_ex(ctx_, digest, &len);
+        char hex[33];
+        for (unsigned i = 0; i < 16 && i < len; i++) std::snprintf(hex + 2 * i, 3, "%02x", digest[i]);
+        return "\"" + std::string(hex, 32) + "\"";
+    }
+
+private:
+    EVP_MD_CTX* ctx_;
+};
+
+// Split a comma-separated header into trimmed items.
+std::vector<std::string> header_items(const std::string& value) {
+    std::vector<std::string> out;
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        size_t b = item.find_first_not_of(" \t");
+        size_t e = item.find_last_not_of(" \t");
+        if (b != std::string::npos) out.push_back(item.substr(b, e - b + 1));
+    }
+    return out;
+}
+
+bool etag_matches(const std::string& if_none_match, const std::string& etag) {
+    for (auto item : header_items(if_none_match)) {
+        if (item == "*") return true;
+        if (item.rfind("W/", 0) == 0) item = item.substr(2);
+        if (item == etag) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+StaticFiles& StaticFiles::instance() {
+    static StaticFiles files;
+    return files;
+}
+
+size_t StaticFiles::load(const std::string& root, size_t max_file_bytes, size_t max_cache_bytes) {
+    auto index = std::make_shared<Index>();
+    std::error_code ec;
+    std::set<std::string> found;  // relative paths, '/'-separated
+    if (fs::is_directory(root, ec)) {
+        for (auto it = fs::recursive_directory_iterator(root, ec); !ec && it != fs::recursive_directory_iterator();
+             it.increment(ec)) {
+            if (it->is_regular_file(ec)) found.insert(fs::relative(it->path(), root, ec).generic_string());
+        }
+    }
+
+    auto make_variant = [&](const std::string& rel, const std::string& encoding) {
+        Variant v;
+        v.encoding = encoding;
+        v.file = (fs::path(root) / rel).string();
+        v.size = static_cast<size_t>(fs::file_size(v.file, ec));
+        std::ifstream in(v.file, std::ios::binary);
+        Sha256 sha;
+        if (v.size <= max_file_bytes && index->cached_bytes + v.size <= max_cache_bytes) {
+            auto body = std::make_shared<std::string>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            sha.update(body->data(), body->size());
+            v.size = body->size();
+            index->cached_bytes += body->size();
+            v.body = std::move(body);
+        } else {
+            char buf[65536];
+            while (in.read(buf, sizeof(buf)) || in.gcount() > 0) sha.update(buf, static_cast<size_t>(in.gcount()));
+        }
+        v.etag = sha.etag();
+        return v;
+    };
+
+    for (const auto& rel : found) {
+        bool is_br = rel.size() > 3 && rel.compare(rel.size() - 3, 3, ".br") == 0;
+        bool is_gz = rel.size() > 3 && rel.compare(rel.size() - 3, 3, ".gz") == 0;
+        if ((is_br || is_gz) && found.count(rel.substr(0, rel.size() - 3))) continue;  // a variant, not a file
+
+        Entry e;
+        e.content_type = content_type_for(rel);
+        e.immutable = content_hashed(rel);
+        e.identity = make_variant(rel, "");
+        if (found.count(rel + ".br")) e.encoded["br"] = make_variant(rel + ".br", "br");
+        if (found.count(rel + ".gz")) e.encoded["gzip"] = make_variant(rel + ".gz", "gzip");
+        if (!e.encoded.count("gzip") && e.identity.body && text_like(e.content_type)) {
+            // No precompressed sibling: gzip it once now, at the highest level.
+            auto gz = std::make_shared<std::string>(compress(*e.identity.body, Encoding::Gzip, 9));
+            if (gz->size() < e.identity.size && index->cached_bytes + gz->size() <= max_cache_bytes) {
+                Variant v;
+                v.encoding = "gzip";
+                v.file = e.identity.file;
+                v.size = gz->size();
+                Sha256 sha;
+                sha.update(gz->data(), gz->size());
+                v.etag = sha.etag();
+                index->cached_bytes += gz->size();
+                v.body = std::move(gz);
+                e.encoded["gzip"] = std::move(v);
+            }
+        }
+        index->files["/" + rel] = std::move(e);
+    }
+
+    size_t n = index->files.size();
+    std::lock_guard<std::mutex> lock(mu_);
+    index_ = n ? std::move(index) : nullptr;
+    return n;
+}
+
+bool StaticFiles::enabled() const {
+    return snapshot() != nullptr;
+}
+
+std::shared_ptr<const StaticFiles::Index> StaticFiles::snapshot() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return index_;
+}
+
+bool StaticFiles::serve(const crow::request& req, const std::string& path, crow::response& res) {
+    auto index = snapshot();
+    if (!index) return false;
+    auto it = index->files.find(path.empty() || path == "/" ? "/index.html" : path);
+    if (it == index->files.end()) {
+        if (has_extension(path)) return false;
+        it = index->files.find("/index.html");  // client-side route
+        if (it == index->files.end()) return false;
+    }
+    const Entry& e = it->second;
+
+    // br before gzip: smaller at the same decode cost.
+    const Variant* v = &e.identity;
+    const std::string& accept_encoding = req.get_header_value("Accept-Encoding");
+    for (const char* encoding : {"br", "gzip"}) {
+        auto enc = e.encoded.find(encoding);
+        if (enc != e.encoded.end() && accepts_encoding(accept_encoding, encoding)) {
+            v = &enc->second;
+            break;
+        }
+    }
+
+    auto common_headers = [&] {
+        res.set_header("ETag", v->etag);
+        res.set_header("Cache-Control", e.immutable ? "public, max-age=31536000, immutable" : "no-cache");
+        if (!e.encoded.empty()) res.set_header("Vary", "Accept-Encoding");
+    };
+
+    const std::string& if_none_match = req.get_header_value("If-None-Match");
+    if (!if_none_match.empty() && etag_matches(if_none_match, v->etag)) {
+        not_modified_++;
+        res.code = 304;
+        common_headers();
+        return true;
+    }
+
+    served_++;
+    if (v->body) {
+        res.code = 200;
+        res.body = *v->body;  // a copy: crow::response owns its body and cannot send a shared buffer
+    } else {
+        streamed_++;
+        res.set_static_file_info_unsafe(v->file);  // Crow writes it from disk in chunks
+        if (res.code != 200) return false;         // removed since load()
+    }
+    res.set_header("Content-Type", e.content_type);
+    if (!v->encoding.empty()) res.set_header("Content-Encoding", v->encoding);
+    common_headers();
+    return true;
+}
+
+StaticFilesMetrics StaticFiles::metrics() const {
+    StaticFilesMetrics m;
+    if (auto index = snapshot()) {
+        m.files = index->files.size();
+        m.cached_bytes = index->cached_bytes;
+    }
+    m.served = served_.load();
+    m.not_modified = not_modified_.load();
+    m.streamed = streamed_.load();
+    return m;
+}
+
+} // namespace server
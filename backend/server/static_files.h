@@ -0,0 +1,93 @@
+#pragma once
+
+#include "crow.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace server {
+
+struct StaticFilesMetrics {
+    size_t files = 0;
+    size_t cached_bytes = 0;  // bodies held in memory (all variants)
+    uint64_t served = 0;
+    uint64_t not_modified = 0;  // 304s
+    uint64_t streamed = 0;      // large files sent from disk
+};
+
+/**
+ * In-memory index of a built frontend (frontend/dist), for serving the SPA
+ * from the backend process.
+ *
+ * load() walks the directory once and, for every file, records its content
+ * type, a strong ETag (SHA-256 of the content) and the precompressed
+ * siblings Vite/compression plugins leave next to it (`x.js.br`, `x.js.gz`).
+ * Bodies up to max_file_bytes are read into memory, up to max_cache_bytes in
+ * total, and text files without a `.gz` get a gzip variant made once here.
+ * Each response gets its own copy of a cached body (crow::response owns its
+ * body as a std::string), which saves the file read and the compression,
+ * not the copy. Larger files are streamed from disk by Crow's static file
+ * writer.
+ *
+ * Cache policy: files whose names carry a content hash (Vite's
+ * `assets/name-<hash>.ext`) are `immutable` for a year; everything else
+ * (index.html, public/ files) is `no-cache` and revalidated with If-None-Match.
+ *
+ * The index is swapped atomically, so load() can run again on a config
+ * reload (a new deploy of dist/) while requests are being served.
+ */
+class StaticFiles {
+public:
+    static StaticFiles& instance();
+
+    /// Index `root`. Returns the number of files (0 also if `root` is missing).
+    size_t load(const std::string& root, size_t max_file_bytes, size_t max_cache_bytes);
+    bool enabled() const;
+
+    /**
+     * Answer a GET for `path` (no query string): the best variant for the
+     * request's Accept-Encoding, 304 on a matching If-None-Match, and
+     * index.html for unknown paths without an extension (client-side routes).
+     * Returns false if there is nothing to serve; `res` is untouched then.
+     */
+    bool serve(const crow::request& req, const std::string& path, crow::response& res);
+
+    StaticFilesMetrics metrics() const;
+
+private:
+    StaticFiles() = default;
+
+    struct Variant {
+        std::string encoding;  // "", "br" or "gzip"
+        std::string etag;
+        std::string file;      // on-disk path
+        size_t size = 0;
+        std::shared_ptr<const std::string> body;  // null: stream from disk
+    };
+
+    struct Entry {
+        std::string content_type;
+        bool immutable = false;
+        Variant identity;
+        std::map<std::string, Variant> encoded;  // by encoding
+    };
+
+    struct Index {
+        std::map<std::string, Entry> files;  // URL path -> entry
+        size_t cached_bytes = 0;
+    };
+
+    std::shared_ptr<const Index> snapshot() const;
+
+    mutable std::mutex mu_;
+    std::shared_ptr<const Index> index_;
+    std::atomic<uint64_t> served_{0};
+    std::atomic<uint64_t> not_modified_{0};
+    std::atomic<uint64_t> streamed_{0};
+};
+
+} // namespace server
@@ -0,0 +1,169 @@
+#include "server/stock_committer.h"
+#include "db/connection.h"
+#include "server/product_store.h"
+#include <pqxx/pqxx>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+namespace server {
+
+StockCommitter& StockCommitter::instance() {
+    static StockCommitter committer;
+    return committer;
+}
+
+StockCommitter::~StockCommitter() {
+    // main() calls stop() while the database is still open; nothing is flushed from here.
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        stopping_ = true;
+        cv_.notify_all();
+    }
+    if (thread_.joinable()) thread_.join();
+}
+
+void StockCommitter::load() {
+    flush(false);  // what a previous run committed but did not apply
+    auto conn = Database::instance().acquire();
+    pqxx::work txn(*conn);
+    auto r = txn.exec_prepared("stock_all");
+    txn.commit();
+    for (const auto& row : r) ledger_.add(row[0].as<int>(), row[1].as<int64_t>(), row[2].as<int64_t>());
+    enabled_.store(true, std::memory_order_release);
+}
+
+void StockCommitter::start(int commit_ms) {
+    std::lock_guard<std::mutex> lock(mu_);
+    commit_ms_ = commit_ms;
+    if (thread_.joinable()) return;
+    stopping_ = false;
+    thread_ = std::thread([this] { run(); });
+}
+
+void StockCommitter::set_commit_ms(int commit_ms) {
+    std::lock_guard<std::mutex> lock(mu_);
+    commit_ms_ = commit_ms;
+    cv_.notify_all();
+}
+
+void StockCommitter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        stopping_ = true;
+        cv_.notify_all();
+    }
+    if (thread_.joinable()) thread_.join();
+    if (!enabled()) return;
+    try {
+        flush(false);
+    } catch (std::exception& e) {
+        // The items stay pending in the database; the next start applies them.
+        std::cerr << "Stock flush at shutdown failed: " << e.what() << std::endl;
+    }
+}
+
+void StockCommitter::committed(uint64_t orders) {
+    std::lock_guard<std::mutex> lock(mu_);
+    orders_ += orders;
+    if (pending_ == 0) cv_.notify_all();
+    pending_ += orders;
+}
+
+void StockCommitter::flush(bool reconcile) {
+    uint64_t orders;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        orders = pending_;
+        pending_ = 0;
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    pqxx::result applied, all;
+    try {
+        auto conn = Database::instance().acquire();
+        pqxx::work txn(*conn);
+        applied = txn.exec_prepared("stock_apply_pending");
+        // Same transaction, after the update: these counts include what was just applied.
+        if (reconcile) all = txn.exec_prepared("stock_all");
+        txn.commit();
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mu_);
+        pending_ += orders;  // retried after the next window
+        failures_++;
+        throw;
+    }
+
+    uint64_t oversold = 0;
+    std::vector<std::pair<int, int64_t>> stock;
+    stock.reserve(applied.size());
+    for (const auto& row : applied) {
+        int id = row[0].as<int>();
+        ledger_.applied(id, row[1].as<int64_t>());
+        ledger_.reconcile(id, row[2].as<int64_t>());
+        stock.emplace_back(id, row[2].as<int64_t>());
+        if (int64_t short_by = row[3].as<int64_t>(); short_by > 0) {
+            // Stock was taken outside this ledger (a second backend on the database?); clamped at 0.
+            std::cerr << "Stock ledger: product " << id << " oversold by " << short_by << std::endl;
+            oversold += static_cast<uint64_t>(short_by);
+        }
+    }
+    for (const auto& row : all) {
+        int id = row[0].as<int>();
+        if (ledger_.contains(id)) ledger_.reconcile(id, row[1].as<int64_t>());
+        else ledger_.add(id, row[1].as<int64_t>(), row[2].as<int64_t>());
+    }
+    ProductStore::instance().apply_stock(stock);
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    std::lock_guard<std::mutex> lock(mu_);
+    oversold_ += oversold;
+    if (!applied.empty()) {
+        flushes_++;
+        flushed_orders_ += orders;
+        last_flush_ms_ = ms;
+    }
+}
+
+void StockCommitter::run() {
+    auto last_flush = std::chrono::steady_clock::now();
+    auto last_reconcile = last_flush;
+    std::unique_lock<std::mutex> lock(mu_);
+    while (!stopping_) {
+        // An order after a quiet period is applied at once; the ones that
+        // arrive while that transaction runs share the next, commit_ms later.
+        auto due = last_reconcile + RECONCILE_INTERVAL;
+        if (pending_ > 0) due = std::min(due, last_flush + std::chrono::milliseconds(commit_ms_));
+        auto now = std::chrono::steady_clock::now();
+        if (now < due) {
+            cv_.wait_until(lock, due);  // re-evaluated on any notify
+            continue;
+        }
+        bool reconcile = now >= last_reconcile + RECONCILE_INTERVAL;
+        lock.unlock();
+        try {
+            flush(reconcile);
+            if (reconcile) last_reconcile = now;
+        } catch (std::exception& e) {
+            std::cerr << "Stock flush failed: " << e.what() << std::endl;
+            if (reconcile) last_reconcile = now;  // do not retry the full read in a loop
+        }
+        last_flush = std::chrono::steady_clock::now();
+        lock.lock();
+    }
+}
+
+StockCommitterMetrics StockCommitter::metrics() const {
+    StockCommitterMetrics m;
+    m.enabled = enabled();
+    m.ledger = ledger_.metrics();
+    std::lock_guard<std::mutex> lock(mu_);
+    m.orders = orders_;
+    m.flushes = flushes_;
+    m.flush_failures = failures_;
+    m.flushed_orders = flushed_orders_;
+    m.last_flush_ms = last_flush_ms_;
+    m.oversold = oversold_;
+    return m;
+}
+
+} // namespace server
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "server/stock_ledger.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace server {
+
+struct StockCommitterMetrics {
+    bool enabled = false;
+    uint64_t orders = 0;          // orders committed with pending stock
+    uint64_t flushes = 0;         // transactions that applied at least one order
+    uint64_t flush_failures = 0;
+    uint64_t flushed_orders = 0;  // orders applied by those transactions
+    double last_flush_ms = 0;
+    uint64_t oversold = 0;        // units applied past zero stock (clamped); should stay 0
+    StockLedgerMetrics ledger;
+};
+
+/**
+ * Group commit of the stock ledger (server/stock_ledger.h) to Postgres.
+ *
+ * With the ledger on, /api/orders/create reserves units in memory and
+ * inserts its order items with stock_applied = false instead of running
+ * UPDATE products for each of them; the order is durable at that point.
+ * committed() wakes this thread, which waits up to commit_ms for more
+ * orders and then applies every pending item in one statement: it marks the
+ * items applied and subtracts their sum from products.stock, one row update
+ * per product however many orders bought it. Because the pending items are
+ * in the database, a crash loses nothing: load() applies whatever a previous
+ * run left behind before reading the counts.
+ *
+ * Every RECONCILE_INTERVAL the same transaction also reads all stock
+ * counts, so products added since load() are tracked and stock changed
+ * directly in SQL (restocks) reaches the ledger.
+ *
+ * The ledger assumes it is the only writer of products.stock for orders:
+ * run one backend process per database with it on (stock_ledger, off by
+ * default). If that is broken, the flush still never takes stock below
+ * zero; it clamps, logs the product and counts the units as oversold.
+ */
+class StockCommitter {
+public:
+    static constexpr auto RECONCILE_INTERVAL = std::chrono::seconds(5);
+
+    static StockCommitter& instance();
+
+    StockLedger& ledger() { return ledger_; }
+    /// True once load() has run: orders go through the ledger.
+    bool enabled() const { return enabled_.load(std::memory_order_acquire); }
+
+    /// Apply pending items left by a previous run, then load every product's stock. Throws on DB errors.
+    void load();
+    /// Start the commit thread.
+    void start(int commit_ms);
+    /// New group commit window (config reload).
+    void set_commit_ms(int commit_ms);
+    /// Stop the thread and apply what is still pending.
+    void stop();
+
+    /// `orders` orders with pending items were committed.
+    void committed(uint64_t orders = 1);
+
+    StockCommitterMetrics metrics() const;
+
+private:
+    StockCommitter() = default;
+    ~StockCommitter();
+    /// Apply pending items (and reconcile, when due) in one transaction. Throws on DB errors.
+    void flush(bool reconcile);
+    void run();
+
+    StockLedger ledger_;
+    std::atomic<bool> enabled_{false};
+
+    mutable std::mutex mu_;
+    std::condition_variable cv_;
+    uint64_t pending_ = 0;  // orders committed since the last flush started
+    int commit_ms_ = 10;
+    bool stopping_ = false;
+    std::thread thread_;
+
+    uint64_t orders_ = 0;
+    uint64_t flushes_ = 0;
+    uint64_t failures_ = 0;
+    uint64_t flushed_orders_ = 0;
+    double last_flush_ms_ = 0;
+    uint64_t oversold_ = 0;
+};
+
+} // namespace server
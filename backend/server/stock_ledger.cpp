@@ -0,0 +1,128 @@
+#include "server/stock_ledger.h"
+#include <mutex>
+
+namespace server {
+
+uint64_t StockLedger::pack(int64_t available, int64_t unflushed) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(static_cast<int32_t>(available))) << 32) |
+        static_cast<uint32_t>(static_cast<int32_t>(unflushed));
+}
+
+int64_t StockLedger::available_of(uint64_t word) {
+    return static_cast<int32_t>(static_cast<uint32_t>(word >> 32));
+}
+
+int64_t StockLedger::unflushed_of(uint64_t word) {
+    return static_cast<int32_t>(static_cast<uint32_t>(word));
+}
+
+void StockLedger::add(int product_id, int64_t stock, int64_t unflushed) {
+    Shard& s = shard(product_id);
+    std::unique_lock<std::shared_mutex> lock(s.mu);
+    auto& counter = s.counters[product_id];
+    if (counter) return;  // someone else loaded it first; theirs is at least as current
+    counter = std::make_unique<Counter>();
+    counter->word.store(pack(stock - unflushed, unflushed), std::memory_order_release);
+}
+
+StockLedger::Counter* StockLedger::find(int product_id) const {
+    Shard& s = shard(product_id);
+    std::shared_lock<std::shared_mutex> lock(s.mu);
+    auto it = s.counters.find(product_id);
+    return it == s.counters.end() ? nullptr : it->second.get();
+}
+
+bool StockLedger::contains(int product_id) const {
+    return find(product_id) != nullptr;
+}
+
+StockLedger::Reserve StockLedger::reserve(int product_id, int qty) {
+    Counter* c = find(product_id);
+    if (!c) return Reserve::Unknown;
+    uint64_t word = c->word.load(std::memory_order_acquire);
+    do {
+        if (available_of(word) < qty) {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            return Reserve::Insufficient;
+        }
+    } while (!c->word.compare_exchange_weak(word, pack(available_of(word) - qty, unflushed_of(word) + qty),
+                                            std::memory_order_acq_rel, std::memory_order_acquire));
+    reserved_.fetch_add(static_cast<uint64_t>(qty), std::memory_order_relaxed);
+    return Reserve::Ok;
+}
+
+StockLedger::Reserve StockLedger::reserve_all(const std::vector<std::pair<int, int>>& items, int& failed) {
+    for (size_t i = 0; i < items.size(); i++) {
+        if (items[i].second < 1) continue;
+        Reserve r = reserve(items[i].first, items[i].second);
+        if (r == Reserve::Ok) continue;
+        for (size_t j = 0; j < i; j++) {
+            if (items[j].second >= 1) release(items[j].first, items[j].second);
+        }
+        failed = items[i].first;
+        return r;
+    }
+    return Reserve::Ok;
+}
+
+void StockLedger::release(int product_id, int qty) {
+    Counter* c = find(product_id);
+    if (!c) return;
+    uint64_t word = c->word.load(std::memory_order_acquire);
+    while (!c->word.compare_exchange_weak(word, pack(available_of(word) + qty, unflushed_of(word) - qty),
+                                          std::memory_order_acq_rel, std::memory_order_acquire)) {
+    }
+    released_.fetch_add(static_cast<uint64_t>(qty), std::memory_order_relaxed);
+}
+
+void StockLedger::release_all(const std::vector<std::pair<int, int>>& items) {
+    for (const auto& [product_id, qty] : items) {
+        if (qty >= 1) release(product_id, qty);
+    }
+}
+
+void StockLedger::applied(int product_id, int64_t qty) {
+    Counter* c = find(product_id);
+    if (!c) return;
+    uint64_t word = c->word.load(std::memory_order_acquire);
+    while (!c->word.compare_exchange_weak(word, pack(available_of(word), unflushed_of(word) - qty),
+                                          std::memory_order_acq_rel, std::memory_order_acquire)) {
+    }
+    applied_.fetch_add(static_cast<uint64_t>(qty), std::memory_order_relaxed);
+}
+
+void StockLedger::reconcile(int product_id, int64_t db_stock) {
+    Counter* c = find(product_id);
+    if (!c) return;
+    // reserve() and release() keep available + unflushed constant, so a
+    // difference can only come from a write that bypassed the ledger.
+    uint64_t word = c->word.load(std::memory_order_acquire);
+    int64_t delta;
+    do {
+        delta = db_stock - (available_of(word) + unflushed_of(word));
+        if (delta == 0) return;
+    } while (!c->word.compare_exchange_weak(word, pack(available_of(word) + delta, unflushed_of(word)),
+                                            std::memory_order_acq_rel, std::memory_order_acquire));
+    adjusted_.fetch_add(1, std::memory_order_relaxed);
+}
+
+int64_t StockLedger::available(int product_id) const {
+    Counter* c = find(product_id);
+    return c ? available_of(c->word.load(std::memory_order_acquire)) : -1;
+}
+
+StockLedgerMetrics StockLedger::metrics() const {
+    StockLedgerMetrics m;
+    for (auto& s : shards_) {
+        std::shared_lock<std::shared_mutex> lock(s.mu);
+        m.products += s.counters.size();
+    }
+    m.reserved = reserved_.load(std::memory_order_relaxed);
+    m.rejected = rejected_.load(std::memory_order_relaxed);
+    m.released = released_.load(std::memory_order_relaxed);
+    m.applied = applied_.load(std::memory_order_relaxed);
+    m.adjusted = adjusted_.load(std::memory_order_relaxed);
+    return m;
+}
+
+} // namespace server
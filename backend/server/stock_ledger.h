@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace server {
+
+struct StockLedgerMetrics {
+    size_t products = 0;
+    uint64_t reserved = 0;     // units
+    uint64_t rejected = 0;     // reservations refused for lack of stock
+    uint64_t released = 0;     // units given back by orders that failed after reserving
+    uint64_t applied = 0;      // units written to products.stock
+    uint64_t adjusted = 0;     // products whose stock was changed outside the ledger (restocks)
+};
+
+/**
+ * In-process stock counts for order admission. Every unit an order takes is
+ * reserved here first, with one compare-and-swap on the product's counter,
+ * so concurrent buyers of a hot product are admitted or refused without a
+ * database round trip and without queueing on the products row lock. The
+ * count can never go below zero: a reservation that does not fit fails.
+ *
+ * Each product keeps two numbers in one 64-bit word, updated together:
+ * `available` (what can still be sold) and `unflushed` (units reserved but
+ * not yet subtracted from products.stock). reserve() moves units from the
+ * first to the second, release() moves them back, and applied() drops them
+ * once the stock committer (server/stock_committer.h) has written them to
+ * the database. available + unflushed is therefore what products.stock
+ * should read; reconcile() compares it with the database and takes in any
+ * difference (a restock done in SQL).
+ *
+ * Products live in SHARDS hash maps, each behind a shared_mutex that is only
+ * taken exclusively to add a product. Counters are never removed, so the
+ * pointers handed out stay valid.
+ */
+class StockLedger {
+public:
+    static constexpr size_t SHARDS = 16;
+
+    enum class Reserve { Ok, Insufficient, Unknown };
+
+    StockLedger() = default;
+    StockLedger(const StockLedger&) = delete;
+    StockLedger& operator=(const StockLedger&) = delete;
+
+    /// Start tracking `product_id` unless it already is: `stock` in the database, `unflushed` of it already sold.
+    void add(int product_id, int64_t stock, int64_t unflushed = 0);
+    bool contains(int product_id) const;
+
+    /// Take `qty` units of `product_id`. Unknown: the product is not tracked yet (see add()).
+    Reserve reserve(int product_id, int qty);
+    /// All of `items` (product id, quantity) or none: the first product that does not fit is in `failed`.
+    Reserve reserve_all(const std::vector<std::pair<int, int>>& items, int& failed);
+    /// Give back units whose order was not committed.
+    void release(int product_id, int qty);
+    void release_all(const std::vector<std::pair<int, int>>& items);
+
+    /// `qty` reserved units are now part of products.stock.
+    void applied(int product_id, int64_t qty);
+    /// products.stock reads `db_stock` after every applied() so far; take in changes made outside the ledger.
+    void reconcile(int product_id, int64_t db_stock);
+
+    /// Units that can still be sold (-1 if untracked).
+    int64_t available(int product_id) const;
+    StockLedgerMetrics metrics() const;
+
+private:
+    struct Counter {
+        std::atomic<uint64_t> word{0};  // available in the high half, unflushed in the low half (both int32)
+    };
+    struct Shard {
+        mutable std::shared_mutex mu;
+        std::unordered_map<int, std::unique_ptr<Counter>> counters;
+    };
+
+    static uint64_t pack(int64_t available, int64_t unflushed);
+    static int64_t available_of(uint64_t word);
+    static int64_t unflushed_of(uint64_t word);
+
+    Counter* find(int product_id) const;
+    Shard& shard(int product_id) const { return shards_[static_cast<uint32_t>(product_id) % SHARDS]; }
+
+    mutable std::array<Shard, SHARDS> shards_;
+    std::atomic<uint64_t> reserved_{0};
+    std::atomic<uint64_t> rejected_{0};
+    std::atomic<uint64_t> released_{0};
+    std::atomic<uint64_t> applied_{0};
+    std::atomic<uint64_t> adjusted_{0};
+};
+
+} // namespace server
@@ -0,0 +1,145 @@
+#include "server/suggest_index.h"
+#include <algorithm>
+
+namespace server {
+
+namespace {
+
+unsigned char fold(unsigned char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<unsigned char>(c - 'A' + 'a') : c;
+}
+
+bool word_char(unsigned char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c >= 0x80;  // UTF-8 bytes stay inside words
+}
+
+// Offsets in `folded` where a word starts.
+std::vector<uint32_t> word_starts(const std::string& folded) {
+    std::vector<uint32_t> starts;
+    for (size_t i = 0; i < folded.size(); i++) {
+        auto c = static_cast<unsigned char>(folded[i]);
+        if (word_char(c) && (i == 0 || !word_char(static_cast<unsigned char>(folded[i - 1])))) {
+            starts.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    return starts;
+}
+
+std::string folded(std::string_view s) {
+    std::string out(s);
+    for (char& c : out) c = static_cast<char>(fold(static_cast<unsigned char>(c)));
+    return out;
+}
+
+struct Key {
+    std::string_view text;  // folded name from a word start, at most MAX_DEPTH bytes
+    uint32_t entry;
+};
+
+// Range of sorted keys sharing the node's prefix, and the prefix length.
+struct Pending {
+    uint32_t lo;
+    uint32_t hi;
+    uint32_t depth;
+};
+
+} // namespace
+
+SuggestIndex::SuggestIndex(std::vector<Entry> entries) : entries_(std::move(entries)) {
+    std::sort(entries_.begin(), entries_.end(), [](const Entry& a, const Entry& b) {
+        return a.popularity != b.popularity ? a.popularity > b.popularity : a.id < b.id;
+    });
+
+    std::vector<std::string> names(entries_.size());
+    std::vector<Key> keys;
+    for (size_t e = 0; e < entries_.size(); e++) {
+        names[e] = folded(entries_[e].name);
+        std::string_view name = names[e];
+        for (uint32_t start : word_starts(names[e])) {
+            keys.push_back({name.substr(start, MAX_DEPTH), static_cast<uint32_t>(e)});
+        }
+    }
+    // string_view compares bytes as unsigned char, the order of labels_.
+    std::sort(keys.begin(), keys.end(), [](const Key& a, const Key& b) {
+        return a.text != b.text ? a.text < b.text : a.entry < b.entry;
+    });
+
+    // Breadth first: node i covers keys[pending[i].lo, pending[i].hi), so its
+    // children are appended together and stay contiguous.
+    std::vector<Pending> pending = {{0, static_cast<uint32_t>(keys.size()), 0}};
+    nodes_.push_back({});
+    labels_.push_back(0);
+    std::vector<uint32_t> best;
+    for (size_t n = 0; n < pending.size(); n++) {
+        Pending p = pending[n];
+
+        // The TOP_K distinct entries under this node: lowest index = most popular.
+        best.clear();
+        for (uint32_t k = p.lo; k < p.hi; k++) {
+            uint32_t e = keys[k].entry;
+            if (best.size() == TOP_K && e >= best.back()) continue;
+            auto at = std::lower_bound(best.begin(), best.end(), e);
+            if (at != best.end() && *at == e) continue;
+            best.insert(at, e);
+            if (best.size() > TOP_K) best.pop_back();
+        }
+        Node node{static_cast<uint32_t>(nodes_.size()), static_cast<uint32_t>(top_.size()), 0,
+                  static_cast<uint8_t>(best.size())};
+        top_.insert(top_.end(), best.begin(), best.end());
+
+        // Keys ending here sort first; the rest split by their byte at `depth`.
+        uint32_t k = p.lo;
+        while (k < p.hi && keys[k].text.size() == p.depth) k++;
+        while (k < p.hi) {
+            auto c = static_cast<unsigned char>(keys[k].text[p.depth]);
+            uint32_t end = k;
+            while (end < p.hi && static_cast<unsigned char>(keys[end].text[p.depth]) == c) end++;
+            nodes_.push_back({});
+            labels_.push_back(c);
+            pending.push_back({k, end, p.depth + 1});
+            node.child_count++;
+            k = end;
+        }
+        nodes_[n] = node;
+    }
+}
+
+void SuggestIndex::suggest(std::string_view prefix, size_t limit, std::vector<uint32_t>& out) const {
+    out.clear();
+    limit = std::min(limit, TOP_K);
+    if (nodes_.empty() || limit == 0) return;
+
+    uint32_t n = 0;
+    size_t depth = std::min(prefix.size(), MAX_DEPTH);
+    for (size_t i = 0; i < depth; i++) {
+        unsigned char c = fold(static_cast<unsigned char>(prefix[i]));
+        const Node& node = nodes_[n];
+        auto first = labels_.begin() + node.first_child;
+        auto last = first + node.child_count;
+        auto it = std::lower_bound(first, last, c);
+        if (it == last || *it != c) return;
+        n = static_cast<uint32_t>(it - labels_.begin());
+    }
+
+    const Node& node = nodes_[n];
+    std::string folded_prefix = prefix.size() > MAX_DEPTH ? folded(prefix) : std::string();
+    for (uint32_t i = 0; i < node.top_count && out.size() < limit; i++) {
+        uint32_t e = top_[node.top_begin + i];
+        if (!folded_prefix.empty()) {
+            std::string name = folded(entries_[e].name);
+            bool match = false;
+            for (uint32_t start : word_starts(name)) {
+                if (name.compare(start, folded_prefix.size(), folded_prefix) == 0) match = true;
+            }
+            if (!match) continue;
+        }
+        out.push_back(e);
+    }
+}
+
+size_t SuggestIndex::bytes() const {
+    return nodes_.capacity() * sizeof(Node) + labels_.capacity() + top_.capacity() * sizeof(uint32_t) +
+        entries_.capacity() * sizeof(Entry);
+}
+
+} // namespace server
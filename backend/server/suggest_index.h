@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace server {
+
+/**
+ * Immutable prefix trie of product names for autocomplete
+ * (/api/products/suggest). Every word start of a name is a key ("Blue Linen
+ * Shirt" is found by "blu", "lin" and "shi", and by "blue li"), folded to
+ * ASCII lower case and cut at MAX_DEPTH bytes. Each node stores the TOP_K
+ * most popular products below it, so a lookup is one walk down the prefix
+ * (a binary search over sorted edge labels per byte) and a copy of at most
+ * TOP_K indices: no scan, no allocation beyond the result.
+ *
+ * Built once from sorted keys, breadth first, into flat arrays (children of
+ * a node are contiguous), and never modified: a new catalog builds a new
+ * index, which is swapped in whole (ProductStore).
+ */
+class SuggestIndex {
+public:
+    static constexpr size_t TOP_K = 10;
+    static constexpr size_t MAX_DEPTH = 32;
+
+    struct Entry {
+        int id;
+        std::string name;
+        int64_t popularity;  // units sold
+    };
+
+    explicit SuggestIndex(std::vector<Entry> entries);
+
+    /**
+     * Entries (indices for entry()) whose name has a word starting with
+     * `prefix`, most popular first (then by id), at most min(limit, TOP_K).
+     * An empty prefix gives the most popular products overall. Prefixes
+     * longer than MAX_DEPTH are checked against the names beyond it, so they
+     * may return fewer matches than exist.
+     */
+    void suggest(std::string_view prefix, size_t limit, std::vector<uint32_t>& out) const;
+    const Entry& entry(uint32_t i) const { return entries_[i]; }
+
+    size_t size() const { return entries_.size(); }
+    size_t nodes() const { return nodes_.size(); }
+    /// Memory held by the trie arrays (entries' names not included).
+    size_t bytes() const;
+
+private:
+    struct Node {
+        uint32_t first_child;
+        uint32_t top_begin;   // in top_
+        uint16_t child_count; // up to 256 labels
+        uint8_t top_count;
+    };
+
+    std::vector<Node> nodes_;
+    std::vector<unsigned char> labels_;  // labels_[i]: byte on the edge into node i
+    std::vector<uint32_t> top_;          // entry indices, TOP_K or fewer per node
+    std::vector<Entry> entries_;         // by popularity desc, id asc: index order is rank order
+};
+
+} // namespace server
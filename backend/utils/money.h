@@ -0,0 +1,148 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * An amount of money as a whole number of cents. products.price,
+ * orders.total and order_items.price_at_purchase are DECIMAL(10,2), so every
+ * value the database holds fits exactly, and sums and products of them stay
+ * exact (no 0.1 + 0.2 drift in order totals).
+ *
+ * Decoders for both libpq representations of NUMERIC — the text form
+ * ("19.99") and the binary form (base-10000 digits) — and a formatter that
+ * writes what "%.2f" wrote for the same value.
+ */
+class Money {
+public:
+    /// Longest format() output: sign, 17 integer digits, point, two decimals.
+    static constexpr size_t MAX_CHARS = 21;
+
+    constexpr Money() = default;
+    static constexpr Money from_cents(int64_t cents) { return Money(cents); }
+
+    constexpr int64_t cents() const { return cents_; }
+    constexpr double to_double() const { return static_cast<double>(cents_) / 100.0; }
+
+    constexpr Money& operator+=(Money o) { cents_ += o.cents_; return *this; }
+    constexpr Money operator+(Money o) const { return Money(cents_ + o.cents_); }
+    constexpr Money operator-(Money o) const { return Money(cents_ - o.cents_); }
+    constexpr Money operator*(int64_t n) const { return Money(cents_ * n); }
+    constexpr bool operator==(Money o) const { return cents_ == o.cents_; }
+    constexpr bool operator!=(Money o) const { return cents_ != o.cents_; }
+    constexpr bool operator<(Money o) const { return cents_ < o.cents_; }
+
+    /**
+     * Decimal text: optional '-', digits, optional '.' and fraction digits
+     * (at least one digit overall). Fractions beyond cents round half away
+     * from zero, as NUMERIC rounds to scale 2. At most 16 integer digits.
+     * False (and `out` untouched) for anything else.
+     */
+    static bool parse(std::string_view s, Money& out) {
+        const char* p = s.data();
+        const char* end = p + s.size();
+        bool neg = p < end && *p == '-';
+        p += neg;
+        // Fast path, the only shape Postgres sends for DECIMAL(10,2): digits "." d d.
+        size_t n = static_cast<size_t>(end - p);
+        if (n >= 4 && n <= 19 && end[-3] == '.') {
+            uint64_t v = 0;
+            unsigned bad = 0;
+            for (const char* q = p; q < end - 3; q++) {
+                unsigned d = static_cast<unsigned char>(*q) - '0';
+                bad |= d > 9;
+                v = v * 10 + d;
+            }
+            unsigned d1 = static_cast<unsigned char>(end[-2]) - '0';
+            unsigned d2 = static_cast<unsigned char>(end[-1]) - '0';
+            if (!(bad | (d1 > 9) | (d2 > 9))) {
+                int64_t c = static_cast<int64_t>(v * 100 + d1 * 10 + d2);
+                out = Money(neg ? -c : c);
+                return true;
+            }
+            return false;
+        }
+        return parse_general(p, end, neg, out);
+    }
+
+    /**
+     * The binary NUMERIC wire format (numeric_send in the Postgres sources):
+     * int16 ndigits, int16 weight, uint16 sign, int16 dscale, then ndigits
+     * base-10000 digits, all big-endian. Same rounding as parse(), for values
+     * below 10^12; false for NaN, infinities, larger values and malformed input.
+     */
+    static bool parse_numeric(const char* data, size_t len, Money& out) {
+        if (len < 8) return false;
+        auto u16 = [data](size_t i) {
+            return static_cast<unsigned>(static_cast<unsigned char>(data[i])) << 8 |
+                   static_cast<unsigned char>(data[i + 1]);
+        };
+        unsigned ndigits = u16(0);
+        int weight = static_cast<int16_t>(u16(2));
+        unsigned sign = u16(4);
+        if ((sign != 0x0000 && sign != 0x4000) || len != 8 + 2 * size_t{ndigits}) return false;
+        if (ndigits > 0 && weight > 2) return false;
+        // Value in 1/10000 units: every digit down to the one holding decimals 1-4.
+        // Later digits cannot change the rounding: cents round up iff decimals 3-4 are >= 50.
+        uint64_t acc = 0;
+        int e = weight;
+        for (unsigned i = 0; i < ndigits && e >= -1; i++, e--) {
+            unsigned d = u16(8 + 2 * i);
+            if (d > 9999) return false;
+            acc = acc * 10000 + d;
+        }
+        for (; e >= -1 && ndigits > 0; e--) acc *= 10000;  // trailing zero digits are not sent
+        int64_t c = static_cast<int64_t>(acc / 100 + (acc % 100 >= 50));
+        out = Money(sign == 0x4000 ? -c : c);
+        return true;
+    }
+
+    /// Writes the amount as "-123.45" into `buf` (MAX_CHARS bytes) and returns the length.
+    size_t format(char* buf) const {
+        char* p = buf;
+        uint64_t a = cents_ < 0 ? 0 - static_cast<uint64_t>(cents_) : static_cast<uint64_t>(cents_);
+        if (cents_ < 0) *p++ = '-';
+        p = std::to_chars(p, buf + MAX_CHARS, a / 100).ptr;
+        unsigned frac = static_cast<unsigned>(a % 100);
+        p[0] = '.';
+        p[1] = static_cast<char>('0' + frac / 10);
+        p[2] = static_cast<char>('0' + frac % 10);
+        return static_cast<size_t>(p + 3 - buf);
+    }
+
+    std::string str() const {
+        char buf[MAX_CHARS];
+        return std::string(buf, format(buf));
+    }
+
+private:
+    constexpr explicit Money(int64_t cents) : cents_(cents) {}
+
+    static bool parse_general(const char* p, const char* end, bool neg, Money& out) {
+        uint64_t whole = 0;
+        int int_digits = 0;
+        for (; p < end && *p >= '0' && *p <= '9'; p++, int_digits++) {
+            if (int_digits == 16) return false;
+            whole = whole * 10 + static_cast<unsigned>(*p - '0');
+        }
+        unsigned frac = 0;
+        int frac_digits = 0;
+        bool round_up = false;
+        if (p < end && *p == '.') {
+            for (p++; p < end && *p >= '0' && *p <= '9'; p++, frac_digits++) {
+                if (frac_digits < 2) frac = frac * 10 + static_cast<unsigned>(*p - '0');
+                else if (frac_digits == 2) round_up = *p >= '5';
+            }
+        }
+        if (p != end || int_digits + frac_digits == 0) return false;
+        if (frac_digits == 1) frac *= 10;
+        int64_t c = static_cast<int64_t>(whole * 100 + frac + round_up);
+        out = Money(neg ? -c : c);
+        return true;
+    }
+
+    int64_t cents_ = 0;
+};
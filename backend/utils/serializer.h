@@ -0,0 +1,236 @@
+#pragma once
+
+#include "money.h"
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/**
+ * Streaming writers for the response bodies, one per wire format. They share
+ * one interface, so a single template (see models/schema.h) lists an
+ * entity's fields once and emits JSON, MessagePack or CBOR from it:
+ *
+ *   begin_object(n) / end_object()   n = number of key/value pairs
+ *   begin_array(n)  / end_array()    n = number of elements
+ *   key(k), integer(v), number(v), money(m), string(s), boolean(b)
+ *
+ * The binary formats are length-prefixed, so counts must be exact; the JSON
+ * writer ignores them. JsonWriter output is byte-for-byte what the routes
+ * built with json_helper before, including two-decimal numbers. Money goes
+ * out as a two-decimal JSON number and as float64 in the binary formats, the
+ * same bytes the double prices produced.
+ */
+namespace serializer {
+
+class JsonWriter {
+public:
+    static constexpr const char* content_type = nullptr;  // routes have never set one for JSON
+
+    void reserve(size_t n) { out_.reserve(n); }
+    std::string take() { return std::move(out_); }
+
+    void begin_object(size_t) { open('{'); }
+    void end_object() { close('}'); }
+    void begin_array(size_t) { open('['); }
+    void end_array() { close(']'); }
+
+    void key(std::string_view k) {
+        separate();
+        append_quoted(k);
+        out_ += ':';
+        comma_ = false;
+    }
+    void integer(int64_t v) {
+        separate();
+        char buf[24];
+        auto r = std::to_chars(buf, buf + sizeof(buf), v);
+        out_.append(buf, static_cast<size_t>(r.ptr - buf));
+    }
+    // Same as json_helper::double_to_str (fixed, two decimals) without the ostringstream.
+    void number(double v) {
+        separate();
+        char buf[64];
+        int n = std::snprintf(buf, sizeof(buf), "%.2f", v);
+        out_.append(buf, static_cast<size_t>(n));
+    }
+    void money(Money m) {
+        separate();
+        char buf[Money::MAX_CHARS];
+        out_.append(buf, m.format(buf));
+    }
+    void string(std::string_view s) {
+        separate();
+        append_quoted(s);
+    }
+    void boolean(bool b) {
+        separate();
+        out_ += b ? "true" : "false";
+    }
+
+private:
+    void separate() {
+        if (comma_) out_ += ',';
+        comma_ = true;
+    }
+    void open(char c) {
+        separate();
+        out_ += c;
+        comma_ = false;
+    }
+    void close(char c) {
+        out_ += c;
+        comma_ = true;
+    }
+    // json_helper::escape, appending runs of plain bytes at once.
+    void append_quoted(std::string_view s) {
+        out_ += '"';
+        size_t run = 0;
+        for (size_t i = 0; i < s.size(); i++) {
+            const char* esc = nullptr;
+            switch (s[i]) {
+            case '"': esc = "\\\""; break;
+            case '\\': esc = "\\\\"; break;
+            case '\n': esc = "\\n"; break;
+            case '\r': esc = "\\r"; break;
+            case '\t': esc = "\\t"; break;
+            default: continue;
+            }
+            out_.append(s.data() + run, i - run);
+            out_ += esc;
+            run = i + 1;
+        }
+        out_.append(s.data() + run, s.size() - run);
+        out_ += '"';
+    }
+
+    std::string out_;
+    bool comma_ = false;
+};
+
+namespace detail {
+
+inline void put_be(std::string& out, uint64_t v, int bytes) {
+    for (int i = bytes - 1; i >= 0; i--) out += static_cast<char>((v >> (8 * i)) & 0xff);
+}
+
+inline uint64_t double_bits(double v) {
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+} // namespace detail
+
+/// MessagePack (msgpack.org spec): smallest encoding for every length and integer.
+class MsgPackWriter {
+public:
+    static constexpr const char* content_type = "application/msgpack";
+
+    void reserve(size_t n) { out_.reserve(n); }
+    std::string take() { return std::move(out_); }
+
+    void begin_object(size_t n) { head(n, 0x80, 0xde, 0xdf); }
+    void end_object() {}
+    void begin_array(size_t n) { head(n, 0x90, 0xdc, 0xdd); }
+    void end_array() {}
+
+    void key(std::string_view k) { string(k); }
+    void integer(int64_t v) {
+        if (v >= 0) {
+            if (v < 128) out_ += static_cast<char>(v);
+            else if (v <= 0xff) put(0xcc, static_cast<uint64_t>(v), 1);
+            else if (v <= 0xffff) put(0xcd, static_cast<uint64_t>(v), 2);
+            else if (v <= 0xffffffffLL) put(0xce, static_cast<uint64_t>(v), 4);
+            else put(0xcf, static_cast<uint64_t>(v), 8);
+        } else {
+            if (v >= -32) out_ += static_cast<char>(v);
+            else if (v >= INT8_MIN) put(0xd0, static_cast<uint64_t>(v), 1);
+            else if (v >= INT16_MIN) put(0xd1, static_cast<uint64_t>(v), 2);
+            else if (v >= INT32_MIN) put(0xd2, static_cast<uint64_t>(v), 4);
+            else put(0xd3, static_cast<uint64_t>(v), 8);
+        }
+    }
+    void number(double v) { put(0xcb, detail::double_bits(v), 8); }
+    void money(Money m) { number(m.to_double()); }
+    void string(std::string_view s) {
+        size_t n = s.size();
+        if (n < 32) out_ += static_cast<char>(0xa0 | n);
+        else if (n <= 0xff) put(0xd9, n, 1);
+        else if (n <= 0xffff) put(0xda, n, 2);
+        else put(0xdb, n, 4);
+        out_.append(s.data(), n);
+    }
+    void boolean(bool b) { out_ += static_cast<char>(b ? 0xc3 : 0xc2); }
+
+private:
+    void put(unsigned char tag, uint64_t v, int bytes) {
+        out_ += static_cast<char>(tag);
+        detail::put_be(out_, v, bytes);
+    }
+    // Map/array header: fix form below 16, then the 16- and 32-bit forms.
+    void head(size_t n, unsigned char fix, unsigned char tag16, unsigned char tag32) {
+        if (n < 16) out_ += static_cast<char>(fix | n);
+        else if (n <= 0xffff) put(tag16, n, 2);
+        else put(tag32, n, 4);
+    }
+
+    std::string out_;
+};
+
+/// CBOR (RFC 8949), definite lengths only.
+class CborWriter {
+public:
+    static constexpr const char* content_type = "application/cbor";
+
+    void reserve(size_t n) { out_.reserve(n); }
+    std::string take() { return std::move(out_); }
+
+    void begin_object(size_t n) { head(5, n); }
+    void end_object() {}
+    void begin_array(size_t n) { head(4, n); }
+    void end_array() {}
+
+    void key(std::string_view k) { string(k); }
+    void integer(int64_t v) {
+        if (v >= 0) head(0, static_cast<uint64_t>(v));
+        else head(1, static_cast<uint64_t>(-1 - v));
+    }
+    void number(double v) {
+        out_ += static_cast<char>(0xfb);
+        detail::put_be(out_, detail::double_bits(v), 8);
+    }
+    void money(Money m) { number(m.to_double()); }
+    void string(std::string_view s) {
+        head(3, s.size());
+        out_.append(s.data(), s.size());
+    }
+    void boolean(bool b) { out_ += static_cast<char>(b ? 0xf5 : 0xf4); }
+
+private:
+    void head(unsigned major, uint64_t n) {
+        unsigned char m = static_cast<unsigned char>(major << 5);
+        if (n < 24) {
+            out_ += static_cast<char>(m | n);
+        } else if (n <= 0xff) {
+            out_ += static_cast<char>(m | 24);
+            detail::put_be(out_, n, 1);
+        } else if (n <= 0xffff) {
+            out_ += static_cast<char>(m | 25);
+            detail::put_be(out_, n, 2);
+        } else if (n <= 0xffffffffULL) {
+            out_ += static_cast<char>(m | 26);
+            detail::put_be(out_, n, 4);
+        } else {
+            out_ += static_cast<char>(m | 27);
+            detail::put_be(out_, n, 8);
+        }
+    }
+
+    std::string out_;
+};
+
+} // namespace serializer
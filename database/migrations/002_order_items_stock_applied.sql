@@ -0,0 +1,3 @@
+-- Pending stock decrements for the backend's stock ledger (for existing databases)
+ALTER TABLE order_items ADD COLUMN IF NOT EXISTS stock_applied BOOLEAN NOT NULL DEFAULT true;
+CREATE INDEX IF NOT EXISTS idx_order_items_stock_pending ON order_items(product_id) WHERE NOT stock_applied;
@@ -0,0 +1,2 @@
+-- Order tokens for the backend's async order pipeline (for existing databases)
+ALTER TABLE orders ADD COLUMN IF NOT EXISTS token VARCHAR(32) UNIQUE;
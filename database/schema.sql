@@ -48,6 +48,7 @@ CREATE TABLE IF NOT EXISTS orders (
     shipping_phone VARCHAR(50),
     shipping_address TEXT,
     payment_method VARCHAR(50),
+    token VARCHAR(32) UNIQUE,  -- set by the backend's async order pipeline (202 Accepted)
     created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP
 );
 
@@ -57,7 +58,8 @@ CREATE TABLE IF NOT EXISTS order_items (
     order_id INTEGER NOT NULL REFERENCES orders(id) ON DELETE CASCADE,
     product_id INTEGER NOT NULL REFERENCES products(id) ON DELETE CASCADE,
     quantity INTEGER NOT NULL,
-    price_at_purchase DECIMAL(10, 2) NOT NULL
+    price_at_purchase DECIMAL(10, 2) NOT NULL,
+    stock_applied BOOLEAN NOT NULL DEFAULT true  -- false until the backend's stock ledger subtracts it from products.stock
 );
 
 -- Indexes for common queries
@@ -65,3 +67,4 @@ CREATE INDEX IF NOT EXISTS idx_products_category ON products(category_id);
 CREATE INDEX IF NOT EXISTS idx_cart_items_user ON cart_items(user_id);
 CREATE INDEX IF NOT EXISTS idx_orders_user ON orders(user_id);
 CREATE INDEX IF NOT EXISTS idx_order_items_order ON order_items(order_id);
+CREATE INDEX IF NOT EXISTS idx_order_items_stock_pending ON order_items(product_id) WHERE NOT stock_applied;